@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace itp_bench {
+
+// Keeps the compiler from discarding a computed value (or from hoisting its computation out of the timing loop)
+template<typename T> inline void do_not_optimize(T const &value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+struct BenchmarkResult {
+  std::string name;
+  uint64_t iterations;  // Per sample
+  double ns_per_op;     // Median across samples
+  double min_ns_per_op;
+};
+
+/* Minimal benchmark runner.  Each benchmark is calibrated so that one sample takes roughly min_time_ms / samples,
+then timed for `samples` samples; the median and fastest per-operation times are reported as JSON.
+
+Options:
+  --filter=<substring>  Only run benchmarks whose name contains substring
+  --min-time-ms=<n>     Target total time per benchmark (default 200)
+  --samples=<n>         Number of timed samples per benchmark (default 5)
+  --output=<path>       Write JSON to path instead of stdout
+*/
+class Runner {
+ public:
+  Runner(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+      const char *arg = argv[i];
+      if (strncmp(arg, "--filter=", 9) == 0) {
+        filter_ = arg + 9;
+      } else if (strncmp(arg, "--min-time-ms=", 14) == 0) {
+        min_time_ms_ = std::max(1, atoi(arg + 14));
+      } else if (strncmp(arg, "--samples=", 10) == 0) {
+        samples_ = std::max(1, atoi(arg + 10));
+      } else if (strncmp(arg, "--output=", 9) == 0) {
+        output_ = arg + 9;
+      } else {
+        fprintf(stderr, "Unknown option %s\n", arg);
+        exit(2);
+      }
+    }
+  }
+
+  bool is_selected(const char *name) const { return filter_.empty() || strstr(name, filter_.c_str()) != nullptr; }
+
+  // Times fn(), which should perform one operation and (ideally) return its result.
+  template<typename F> void run(const char *name, F &&fn) {
+    if (!is_selected(name))
+      return;
+
+    const double sample_target_ns = min_time_ms_ * 1e6 / samples_;
+
+    uint64_t iterations = 1;
+    while (true) {
+      double elapsed = time_(fn, iterations);
+      if (elapsed >= sample_target_ns || iterations >= (1ull << 40))
+        break;
+      // Grow towards the target, but never more than 10x at a time in case the first runs were noisy
+      double scale = elapsed > 0 ? std::min(10.0, std::max(2.0, 1.2 * sample_target_ns / elapsed)) : 10.0;
+      iterations = (uint64_t) (iterations * scale);
+    }
+
+    std::vector<double> per_op;
+    for (int i = 0; i < samples_; i++) {
+      per_op.push_back(time_(fn, iterations) / iterations);
+    }
+    std::sort(per_op.begin(), per_op.end());
+
+    results_.push_back({name, iterations, per_op[per_op.size() / 2], per_op.front()});
+    fprintf(stderr, "%-60s %12.2f ns/op\n", name, per_op[per_op.size() / 2]);
+  }
+
+  // Writes all results as JSON and returns the process exit code
+  int finish() const {
+    FILE *out = output_.empty() ? stdout : fopen(output_.c_str(), "w");
+    if (out == nullptr) {
+      fprintf(stderr, "Unable to open %s\n", output_.c_str());
+      return 1;
+    }
+
+    fprintf(out, "{\n  \"context\": {\"library\": \"itp-packet\", \"compiler\": \"%s\", \"build_type\": \"%s\", ",
+            __VERSION__, ITP_PACKET_BUILD_TYPE);
+    fprintf(out, "\"samples\": %d, \"min_time_ms\": %d},\n  \"benchmarks\": [", samples_, min_time_ms_);
+    for (size_t i = 0; i < results_.size(); i++) {
+      const BenchmarkResult &r = results_[i];
+      fprintf(out, "%s\n    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f}",
+              i == 0 ? "" : ",", r.name.c_str(), (unsigned long long) r.iterations, r.ns_per_op, r.min_ns_per_op);
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout)
+      fclose(out);
+    return 0;
+  }
+
+ private:
+  std::string filter_;
+  std::string output_;
+  int min_time_ms_ = 200;
+  int samples_ = 5;
+  std::vector<BenchmarkResult> results_;
+
+  template<typename F> static double time_(F &fn, uint64_t iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+      if constexpr (std::is_void_v<decltype(fn())>) {
+        fn();
+        asm volatile("" : : : "memory");
+      } else {
+        do_not_optimize(fn());
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+  }
+};
+
+}  // namespace itp_bench
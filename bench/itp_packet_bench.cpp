@@ -0,0 +1,784 @@
+#include <initializer_list>
+#include <thread>
+#include <vector>
+#include "bench_harness.h"
+#include "itp_changedetector.h"
+#include "itp_heatpumpstate.h"
+#include "itp_packetdispatch.h"
+#include "itp_packetframer.h"
+#include "itp_packetrecord.h"
+#include "itp_pollscheduler.h"
+#include "itp_redundantsetfilter.h"
+#include "itp_remotetemperaturefeed.h"
+#include "itp_requestengine.h"
+#include "itp_settingscoalescer.h"
+#include "itp_packets.h"
+#include "itp_spscring.h"
+#include "itp_transactions.h"
+#include "reference_6_bit_decoder.h"
+#ifdef ITP_PACKET_HAVE_HOST
+#include <unistd.h>
+#include <fcntl.h>
+#include "itp_capture.h"
+#include "itp_gateway.h"
+#include "itp_heatpumpemulator.h"
+#include "itp_replay.h"
+#include "itp_thermostatemulator.h"
+#include "itp_sharedbus.h"
+#endif
+
+using namespace itp_packet;
+using itp_bench::do_not_optimize;
+
+namespace {
+
+// Builds a packet with the given leading payload bytes (the rest are zero)
+RawPacket make_raw(PacketType type, std::initializer_list<uint8_t> payload, uint8_t payload_size = 16) {
+  RawPacket pkt(type, payload_size);
+  uint8_t i = 0;
+  for (uint8_t b : payload) {
+    pkt.set_payload_byte(i++, b);
+  }
+  return pkt;
+}
+
+// Sample traffic, modelled on captures from a heat pump and an MHK2 thermostat.  These are globals so that the
+// compiler has to assume every iteration could see different contents.
+RawPacket settings_raw = make_raw(PacketType::GET_RESPONSE,
+                                  {0x02, 0x00, 0x00, 0x01, 0x08, 0x09, 0x00, 0x00, 0x00, 0x00, 0x03, 0xa8});
+RawPacket current_temp_raw =
+    make_raw(PacketType::GET_RESPONSE, {0x03, 0x00, 0x00, 0x0b, 0x00, 0x9a, 0xaa, 0x00, 0x00, 0x00, 0x00, 0x00, 0x42,
+                                        0x1a});
+RawPacket status_raw = make_raw(PacketType::GET_RESPONSE, {0x06, 0x00, 0x00, 0x2a, 0x01, 0x03, 0x21, 0x12, 0x34});
+RawPacket run_state_raw = make_raw(PacketType::GET_RESPONSE, {0x09, 0x00, 0x00, 0x02, 0x03, 0x01});
+RawPacket error_state_raw = make_raw(PacketType::GET_RESPONSE, {0x04, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00});
+RawPacket functions_raw = make_raw(PacketType::GET_RESPONSE, {0x20, 0x05, 0x0a, 0x0d, 0x11, 0x16, 0x1a, 0x1d, 0x22,
+                                                              0x26, 0x2a, 0x2d, 0x31, 0x36, 0x3a, 0x3d});
+RawPacket get_request_raw = make_raw(PacketType::GET_REQUEST, {0x02}, 1);
+RawPacket connect_response_raw = make_raw(PacketType::CONNECT_RESPONSE, {0x00}, 1);
+RawPacket capabilities_raw = make_raw(PacketType::IDENTIFY_RESPONSE, {0xc9, 0x03, 0x10, 0x00, 0x00, 0x00, 0x00, 0x60,
+                                                                      0x04, 0x01, 0xa0, 0xbe, 0xa0, 0xbe, 0xa2, 0xbc});
+RawPacket identify_cd_raw = make_raw(PacketType::IDENTIFY_RESPONSE, {0xcd, 0x01, 0x02});
+RawPacket settings_set_raw = make_raw(PacketType::SET_REQUEST, {0x01, 0x1f, 0x01, 0x01, 0x03, 0x09, 0x03, 0x00, 0x00,
+                                                                0x00, 0x00, 0x00, 0x00, 0x0c, 0xad});
+RawPacket remote_temp_raw = make_raw(PacketType::SET_REQUEST, {0x07, 0x01, 0x1d, 0xad}, 4);
+RawPacket set_response_raw = make_raw(PacketType::SET_RESPONSE, {0x00});
+RawPacket sensor_status_raw = make_raw(PacketType::SET_REQUEST, {0xa6, 0x00, 0x00, 0x00, 0x00, 0x2d, 0x00, 0x01});
+RawPacket hello_raw = make_raw(PacketType::SET_REQUEST, {0xa7, 0x4d, 0x48, 0xcb, 0x32, 0x12, 0x34, 0x56, 0x78, 0x9a,
+                                                         0xbc, 0xde, 0xf0, 0x01, 0x02, 0x03});
+RawPacket state_upload_raw = make_raw(PacketType::SET_REQUEST, {0xa8, 0x1d, 0x1d, 0x91, 0x6a, 0x3b, 0x00, 0x01, 0xaa,
+                                                                0xb2});
+
+// Not const, and passed through do_not_optimize() by each benchmark, so decoders can't be folded at compile time
+uint8_t hello_bytes[] = {0x4d, 0x48, 0xcb, 0x32, 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0};
+
+// Typed packets, all wrapping copies of the raw packets above
+SettingsGetResponsePacket settings{RawPacket(settings_raw)};
+CurrentTempGetResponsePacket current_temp{RawPacket(current_temp_raw)};
+StatusGetResponsePacket status{RawPacket(status_raw)};
+RunStateGetResponsePacket run_state{RawPacket(run_state_raw)};
+ErrorStateGetResponsePacket error_state{RawPacket(error_state_raw)};
+Functions1GetResponsePacket functions_1{RawPacket(functions_raw)};
+Functions2GetResponsePacket functions_2{RawPacket(functions_raw)};
+GetRequestPacket get_request{RawPacket(get_request_raw)};
+ConnectResponsePacket connect_response{RawPacket(connect_response_raw)};
+CapabilitiesResponsePacket capabilities{RawPacket(capabilities_raw)};
+IdentifyCDResponsePacket identify_cd{RawPacket(identify_cd_raw)};
+SettingsSetRequestPacket settings_set{RawPacket(settings_set_raw)};
+RemoteTemperatureSetRequestPacket remote_temp{RawPacket(remote_temp_raw)};
+SetResponsePacket set_response{RawPacket(set_response_raw)};
+ThermostatSensorStatusPacket sensor_status{RawPacket(sensor_status_raw)};
+ThermostatHelloPacket hello{RawPacket(hello_raw)};
+ThermostatStateUploadPacket state_upload{RawPacket(state_upload_raw)};
+Packet generic{RawPacket(status_raw)};
+
+uint8_t temp_byte = 0xab;
+float temp_float = 22.5f;
+int16_t temp_deci_c = 225;
+
+void bench_raw_packet(itp_bench::Runner &runner) {
+  runner.run("raw_packet.construct_from_bytes", [] {
+    return RawPacket(settings_raw.get_bytes(), settings_raw.get_length(), SourceBridge::HEATPUMP);
+  });
+  runner.run("raw_packet.construct_empty", [] { return RawPacket(PacketType::SET_REQUEST, 16); });
+  runner.run("raw_packet.calculate_checksum", [] {
+    return RawPacket::calculate_checksum(settings_raw.get_bytes(), settings_raw.get_length() - 1);
+  });
+  runner.run("raw_packet.is_checksum_valid", [] { return settings_raw.is_checksum_valid(); });
+  runner.run("raw_packet.set_payload_byte",
+             [] { return settings_set_raw.set_payload_byte(5, temp_byte).get_length(); });
+  runner.run("raw_packet.to_string", [] { return settings_raw.to_string(); });
+}
+
+// Copying a queue's worth of frames as typed packets versus as records
+std::vector<SettingsGetResponsePacket> packet_queue(1024, settings);
+std::vector<PacketRecord> record_queue(1024, PacketRecord::from_packet(settings));
+
+void bench_packet_record(itp_bench::Runner &runner) {
+  runner.run("packet_record.from_packet", [] { return PacketRecord::from_packet(settings, 1234); });
+  runner.run("packet_record.to_packet", [] { return record_queue[0].to_packet<SettingsGetResponsePacket>(); });
+  runner.run("packet_record.copy_1024_packets", [] {
+    std::vector<SettingsGetResponsePacket> copy(packet_queue);
+    return copy.back().get_power();
+  });
+  runner.run("packet_record.copy_1024_records", [] {
+    std::vector<PacketRecord> copy(record_queue);
+    return copy.back().bytes[8];
+  });
+}
+
+PacketRecordRing<1024> record_ring;
+
+// Hands 64k records from a producer thread to this one
+uint32_t ring_transfer(SpscWaitMode mode) {
+  static PacketRecordRing<1024> ring;
+  new (&ring) PacketRecordRing<1024>();
+
+  std::thread producer([] {
+    for (size_t sent = 0; sent < 65536;) {
+      size_t pushed = ring.push_batch(&record_queue[0], 16);
+      sent += pushed;
+      if (pushed == 0)
+        std::this_thread::yield();
+    }
+    ring.close();
+  });
+
+  PacketRecord out[64];
+  uint32_t received = 0;
+  while (size_t popped = ring.wait_pop_batch(out, 64, mode)) {
+    received += popped;
+  }
+  producer.join();
+  return received;
+}
+
+void bench_spsc_ring(itp_bench::Runner &runner) {
+  runner.run("spsc_ring.push_pop", [] {
+    PacketRecord out{};
+    record_ring.push(record_queue[0]);
+    record_ring.pop(out);
+    return out.length;
+  });
+  runner.run("spsc_ring.push_pop_batch_16", [] {
+    PacketRecord out[16];
+    record_ring.push_batch(&record_queue[0], 16);
+    return record_ring.pop_batch(out, 16);
+  });
+  runner.run("spsc_ring.transfer_64k_blocking", [] { return ring_transfer(SpscWaitMode::BLOCKING); });
+  // Spinning consumers only make sense with a core to themselves
+  if (std::thread::hardware_concurrency() > 1)
+    runner.run("spsc_ring.transfer_64k_busy_poll", [] { return ring_transfer(SpscWaitMode::BUSY_POLL); });
+}
+
+TransactionTracker tracker;
+
+void bench_transactions(itp_bench::Runner &runner) {
+  runner.run("transactions.next_sequence", [] { return tracker.next_sequence(); });
+  runner.run("transactions.begin_complete_get", [] {
+    tracker.begin(RawPacketView(GetRequestPacket::SETTINGS_FRAME.data(), GetRequestPacket::SETTINGS_FRAME.size()), 0);
+    return tracker.complete(settings_raw, 1);
+  });
+  runner.run("transactions.begin_complete_set", [] {
+    tracker.begin(settings_set_raw, 0);
+    return tracker.complete(set_response_raw, 1);
+  });
+}
+
+// A refresh cycle of five GETs through a window of four, answered as soon as each batch is on the wire
+RawPacket *refresh_responses[] = {&settings_raw, &current_temp_raw, &status_raw, &run_state_raw, &error_state_raw};
+GetRequestPacket *refresh_requests[] = {
+    &GetRequestPacket::get_settings_instance(), &GetRequestPacket::get_current_temp_instance(),
+    &GetRequestPacket::get_status_instance(), &GetRequestPacket::get_runstate_instance(),
+    &GetRequestPacket::get_error_info_instance()};
+uint32_t refresh_completed = 0;
+RequestEngine request_engine([](const RawPacketView &frame) { do_not_optimize(frame); });
+
+void bench_request_engine(itp_bench::Runner &runner) {
+  runner.run("request_engine.refresh_cycle_5", [] {
+    for (GetRequestPacket *request : refresh_requests) {
+      request_engine.submit(*request, [](RequestResult, const RawPacketView &) { refresh_completed++; });
+    }
+    for (RawPacket *response : refresh_responses) {
+      request_engine.handle_response(*response, 1);
+    }
+    return refresh_completed;
+  });
+}
+
+PollScheduler poll_scheduler({2400, 100});
+uint32_t poll_clock_ms = 0;
+
+void bench_poll_scheduler(itp_bench::Runner &runner) {
+  runner.run("poll_scheduler.next_idle", [] {
+    GetCommand command;
+    return poll_scheduler.next(poll_clock_ms, command);
+  });
+  runner.run("poll_scheduler.on_response",
+             [] { return poll_scheduler.on_response(GetCommand::STATUS, status_raw, poll_clock_ms); });
+}
+
+ChangeDetector change_detector;
+RawPacket settings_changed_raw = make_raw(PacketType::GET_RESPONSE,
+                                          {0x02, 0x00, 0x00, 0x01, 0x08, 0x09, 0x00, 0x00, 0x00, 0x00, 0x03, 0xaa});
+uint32_t target_temp_changes = 0;
+
+void bench_change_detector(itp_bench::Runner &runner) {
+  change_detector.on_change(PacketField::SETTINGS_TARGET_TEMP,
+                            [](PacketField, const RawPacketView &) { target_temp_changes++; });
+  change_detector.process(settings_raw);
+
+  runner.run("change_detector.process_unchanged", [] { return change_detector.process(settings_raw); });
+  // Every packet changes the target temperature, so every call runs a callback
+  runner.run("change_detector.process_changed", [] {
+    change_detector.process(settings_changed_raw);
+    return change_detector.process(settings_raw);
+  });
+  runner.run("change_detector.diff_bytes", [] {
+    return ChangeDetector::diff_bytes(settings_raw.get_payload_bytes(), current_temp_raw.get_payload_bytes());
+  });
+}
+
+HeatPumpStateStore state_store;
+
+void bench_heat_pump_state(itp_bench::Runner &runner) {
+  runner.run("heat_pump_state.update_settings", [] { return state_store.process_frame(settings_raw, 1); });
+  runner.run("heat_pump_state.update_status", [] { return state_store.process_frame(status_raw, 1); });
+  runner.run("heat_pump_state.snapshot", [] { return state_store.snapshot().target_temp.value; });
+}
+
+#ifdef ITP_PACKET_HAVE_HOST
+void bench_shared_bus(itp_bench::Runner &runner) {
+  char name[32];
+  snprintf(name, sizeof(name), "/itp-bench-%d", (int) getpid());
+  static SharedBusPublisher publisher;
+  static SharedBusReader reader;
+  if (!publisher.open(name) || !reader.attach(name)) {
+    fprintf(stderr, "Unable to open shared memory %s, skipping shared_bus benchmarks\n", name);
+    return;
+  }
+
+  runner.run("shared_bus.publish_frame", [] { publisher.publish_frame(record_queue[0]); });
+  runner.run("shared_bus.publish_and_read_16", [] {
+    PacketRecord out[16];
+    for (size_t i = 0; i < 16; i++) {
+      publisher.publish(settings_raw, SourceBridge::HEATPUMP, ControllerAssociation::MITP, i);
+    }
+    return reader.read_frames(out, 16);
+  });
+  runner.run("shared_bus.read_state", [] { return reader.read_state().target_temp.value; });
+
+  reader.detach();
+  publisher.close();
+}
+
+// A million frames (about 32MB): a day of polling, in which error frames only appear in one stretch
+void bench_capture(itp_bench::Runner &runner) {
+  static char path[64];
+  snprintf(path, sizeof(path), "/tmp/itp-bench-%d.cap", (int) getpid());
+  static const uint64_t RECORDS = 1000000;
+  static CaptureWriter writer;
+  static CaptureReader reader;
+
+  if (!writer.open(path)) {
+    fprintf(stderr, "Unable to create %s, skipping capture benchmarks\n", path);
+    return;
+  }
+  const RawPacket *frames[] = {&settings_raw, &current_temp_raw, &status_raw, &run_state_raw};
+  for (uint64_t i = 0; i < RECORDS; i++) {
+    const RawPacket *frame = (i >= 500000 && i < 500100) ? &error_state_raw : frames[i % 4];
+    writer.append(*frame, SourceBridge::HEATPUMP, ControllerAssociation::MITP, i * 86400);
+  }
+  writer.close();
+
+  runner.run("capture.append", [] {
+    static CaptureWriter sink;
+    if (!sink.is_open())
+      sink.open("/dev/null");
+    return sink.append(settings_raw, SourceBridge::HEATPUMP, ControllerAssociation::MITP, 0);
+  });
+  runner.run("capture.open_1m", [] {
+    CaptureReader opened;
+    opened.open(path);
+    return opened.size();
+  });
+
+  if (!reader.open(path)) {
+    fprintf(stderr, "Unable to open %s, skipping capture benchmarks\n", path);
+    unlink(path);
+    return;
+  }
+  runner.run("capture.find_time", [] { return reader.find_time(43200000000ull); });
+  runner.run("capture.scan_1m", [] {
+    uint64_t total = 0;
+    reader.for_each(0, reader.size(), [&total](uint64_t, const CaptureRecord &record) { total += record.length; });
+    return total;
+  });
+  runner.run("capture.filter_common_command_1m", [] {
+    return reader.for_each_matching(0x62, 0x02, 0, reader.size(), [](uint64_t, const CaptureRecord &) {});
+  });
+  runner.run("capture.filter_rare_command_1m", [] {
+    return reader.for_each_matching(0x62, 0x04, 0, reader.size(), [](uint64_t, const CaptureRecord &) {});
+  });
+
+  // Replay the whole capture through a PacketProcessor, on one thread and on four
+  struct SettingsCounter : PacketProcessor {
+    uint64_t settings = 0;
+    void process_packet(const SettingsGetResponsePacket &packet) override { settings += packet.get_power(); }
+  };
+  runner.run("replay.fast_1m", [] {
+    SettingsCounter counter;
+    return replay_capture(reader, counter, ReplayConfig{.time_handlers = false}).frames;
+  });
+  runner.run("replay.fast_timed_handlers_1m", [] {
+    SettingsCounter counter;
+    return replay_capture(reader, counter).frames;
+  });
+  runner.run("replay.parallel_4x1m", [] {
+    SettingsCounter counters[4];
+    ReplayJob jobs[4] = {};
+    for (size_t i = 0; i < 4; i++) {
+      jobs[i].path = path;
+      jobs[i].processor = &counters[i];
+    }
+    replay_parallel(jobs, 4);
+    return jobs[0].stats.frames + jobs[3].stats.frames;
+  });
+
+  reader.close();
+  unlink(path);
+}
+
+void bench_heat_pump_emulator(itp_bench::Runner &runner) {
+  static HeatPumpEmulator emulator(HeatPumpEmulatorConfig{.latency_ms = 0, .require_connect = false});
+  static int client_fd = -1;
+  if (!emulator.open() || (client_fd = open(emulator.get_device_path(), O_RDWR | O_NOCTTY | O_NONBLOCK)) < 0) {
+    fprintf(stderr, "Unable to open a pty, skipping heat pump emulator benchmarks\n");
+    return;
+  }
+
+  // One request and response through the pty, as a gateway polling the unit would see it
+  runner.run("heat_pump_emulator.get_settings_round_trip", [] {
+    uint8_t response[PACKET_MAX_SIZE];
+    write(client_fd, GetRequestPacket::SETTINGS_FRAME.data(), GetRequestPacket::SETTINGS_FRAME.size());
+    emulator.on_readable(0);
+    emulator.poll(0);
+    return read(client_fd, response, sizeof(response));
+  });
+
+  close(client_fd);
+  emulator.close();
+}
+
+void bench_gateway(itp_bench::Runner &runner) {
+  static HeatPumpEmulator emulator(HeatPumpEmulatorConfig{.latency_ms = 0});
+  static Gateway gateway;
+  if (!emulator.open() || !gateway.open() || gateway.add_link(emulator.get_device_path()) < 0) {
+    fprintf(stderr, "Unable to open a pty, skipping gateway benchmarks\n");
+    return;
+  }
+  for (int i = 0; i < 100 && gateway.get_link(0).get_state() != GatewayLinkState::ONLINE; i++) {
+    gateway.run_once(1);
+    emulator.on_readable(gateway.now_ms());
+    emulator.poll(gateway.now_ms());
+  }
+
+  // A request submitted to the gateway, answered by the unit and delivered to its callback, through the event loop
+  runner.run("gateway.get_round_trip", [] {
+    static bool responded;
+    responded = false;
+    gateway.submit(0, GetRequestPacket::get_settings_instance(),
+                   [](RequestResult result, const RawPacketView &) { responded = result == RequestResult::RESPONDED; });
+    for (int i = 0; i < 10 && !responded; i++) {
+      emulator.on_readable(0);
+      emulator.poll(0);
+      gateway.run_once(0);
+    }
+    return responded;
+  });
+
+  gateway.close();
+  emulator.close();
+}
+
+void bench_thermostat_emulator(itp_bench::Runner &runner) {
+  static ThermostatEmulator emulator(ThermostatEmulatorConfig{.cycle_interval_ms = 0, .request_gap_ms = 0});
+  static int adapter_fd = -1;
+  static uint64_t now_us = 0;
+  if (!emulator.open() || (adapter_fd = open(emulator.get_device_path(), O_RDWR | O_NOCTTY | O_NONBLOCK)) < 0) {
+    fprintf(stderr, "Unable to open a pty, skipping thermostat emulator benchmarks\n");
+    return;
+  }
+
+  // One exchange of the polling cycle through the pty, answered the way an adapter would
+  runner.run("thermostat_emulator.exchange_round_trip", [] {
+    uint8_t request[PACKET_MAX_SIZE];
+    emulator.poll(++now_us);
+    ssize_t received = read(adapter_fd, request, sizeof(request));
+    if (received < PACKET_HEADER_SIZE)
+      return received;
+
+    RawPacket response(PacketType::SET_RESPONSE, 1);
+    if (request[1] == static_cast<uint8_t>(PacketType::CONNECT_REQUEST)) {
+      response = RawPacket(PacketType::CONNECT_RESPONSE, 1);
+    } else if (request[1] == static_cast<uint8_t>(PacketType::GET_REQUEST)) {
+      response = RawPacket(PacketType::GET_RESPONSE, 16);
+      response.set_payload_byte(0, request[PACKET_HEADER_SIZE]);
+    } else if (request[PACKET_HEADER_SIZE] == static_cast<uint8_t>(SetCommand::THERMOSTAT_HELLO)) {
+      return received;  // Not answered
+    }
+    write(adapter_fd, response.get_bytes(), response.get_length());
+    emulator.on_readable(now_us);
+    return received;
+  });
+
+  close(adapter_fd);
+  emulator.close();
+}
+#endif
+
+SettingsCoalescer settings_coalescer(0);
+
+void bench_settings_coalescer(itp_bench::Runner &runner) {
+  runner.run("settings_set_request.merge", [] {
+    SettingsSetRequestPacket merged;
+    return merged.merge(settings_set).get_flags();
+  });
+  // A slider drag: ten target temperature changes become one request
+  runner.run("settings_coalescer.burst_of_10", [] {
+    for (int i = 0; i < 10; i++) {
+      settings_coalescer.submit(settings_set, 0, [](bool success) { do_not_optimize(success); });
+    }
+    SettingsSetRequestPacket request;
+    uint32_t batch_id;
+    settings_coalescer.take_ready(0, request, batch_id);
+    settings_coalescer.complete(batch_id, true);
+    return request.get_flags();
+  });
+}
+
+RedundantSetFilter set_filter;
+
+void bench_redundant_set_filter(itp_bench::Runner &runner) {
+  set_filter.process_frame(settings_raw, 0);
+  // Re-asserting power on and auto fan, which the unit already reports
+  RawPacket redundant_set = SettingsSetRequestPacket()
+                                .set_power(true)
+                                .set_fan(SettingsSetRequestPacket::FAN_AUTO)
+                                .raw_packet();
+  runner.run("redundant_set_filter.suppress_settings", [redundant_set] {
+    RawPacket request = redundant_set;
+    return set_filter.filter(request, 0);
+  });
+  runner.run("redundant_set_filter.learn_and_strip", [] {
+    set_filter.process_frame(settings_raw, 0);
+    RawPacket request = settings_set_raw;
+    return set_filter.filter(request, 0);
+  });
+}
+
+RemoteTemperatureFeed remote_temperature_feed;
+uint32_t remote_temperature_now_ms = 0;
+
+void bench_remote_temperature_feed(itp_bench::Runner &runner) {
+  // A sensor reporting every two seconds, hovering around an encoding boundary
+  runner.run("remote_temperature_feed.reading_and_poll", [] {
+    remote_temperature_now_ms += 2000;
+    remote_temperature_feed.on_reading((remote_temperature_now_ms & 0x2000) ? 21.05f : 20.95f,
+                                       remote_temperature_now_ms);
+    RemoteTemperatureSetRequestPacket request;
+    return remote_temperature_feed.poll(remote_temperature_now_ms, request);
+  });
+}
+
+// A 4KB burst of back-to-back response frames, as a DMA read might deliver them
+std::vector<uint8_t> make_burst() {
+  std::vector<uint8_t> burst;
+  const RawPacket *frames[] = {&settings_raw, &current_temp_raw, &status_raw, &run_state_raw, &error_state_raw};
+  for (size_t i = 0; burst.size() + PACKET_MAX_SIZE <= 4096; i++) {
+    const RawPacket *frame = frames[i % 5];
+    burst.insert(burst.end(), frame->get_bytes(), frame->get_bytes() + frame->get_length());
+  }
+  return burst;
+}
+std::vector<uint8_t> burst = make_burst();
+
+struct CountingHandler {
+  uint32_t count = 0;
+  void process_packet(const SettingsGetResponsePacket &packet) { count += packet.get_power(); }
+  void process_packet(const CurrentTempGetResponsePacket &packet) { count += packet.get_runtime_minutes(); }
+  void process_packet(const StatusGetResponsePacket &packet) { count += packet.get_input_watts(); }
+};
+
+void bench_framing(itp_bench::Runner &runner) {
+  runner.run("framer.feed_4k_burst", [] {
+    PacketFramer framer(SourceBridge::HEATPUMP);
+    return framer.feed(burst.data(), burst.size(), [](RawPacket &&pkt) { do_not_optimize(pkt); });
+  });
+  runner.run("framer.feed_4k_bytewise", [] {
+    PacketFramer framer(SourceBridge::HEATPUMP);
+    size_t packets = 0;
+    for (uint8_t b : burst) {
+      packets += framer.feed(&b, 1, [](RawPacket &&pkt) { do_not_optimize(pkt); });
+    }
+    return packets;
+  });
+
+  runner.run("framer.feed_views_4k_burst", [] {
+    PacketFramer framer(SourceBridge::HEATPUMP);
+    return framer.feed_views(burst.data(), burst.size(), [](const RawPacketView &view) { do_not_optimize(view); });
+  });
+
+  // Decoding the first frame of the burst in place, versus wrapping a copy of it in a typed packet
+  runner.run("decode.settings_from_buffer_packet", [] {
+    SettingsGetResponsePacket packet{RawPacket(burst.data(), burst[PACKET_HEADER_INDEX_PAYLOAD_LENGTH] + 6)};
+    return packet.get_target_temp();
+  });
+  runner.run("decode.settings_from_buffer_view", [] {
+    SettingsGetResponseView view(burst.data(), burst[PACKET_HEADER_INDEX_PAYLOAD_LENGTH] + 6);
+    return view.get_target_temp();
+  });
+
+  runner.run("dispatch.settings_get_response", [] {
+    CountingHandler handler;
+    dispatch_packet(handler, RawPacket(settings_raw));
+    return handler.count;
+  });
+  runner.run("dispatch.unhandled", [] {
+    CountingHandler handler;
+    dispatch_packet(handler, RawPacket(remote_temp_raw));
+    return handler.count;
+  });
+}
+
+void bench_get_packets(itp_bench::Runner &runner) {
+  runner.run("get_request.get_requested_command", [] { return get_request.get_requested_command(); });
+
+  runner.run("settings_get_response.get_power", [] { return settings.get_power(); });
+  runner.run("settings_get_response.get_mode", [] { return settings.get_mode(); });
+  runner.run("settings_get_response.get_fan", [] { return settings.get_fan(); });
+  runner.run("settings_get_response.get_vane", [] { return settings.get_vane(); });
+  runner.run("settings_get_response.locked_power", [] { return settings.locked_power(); });
+  runner.run("settings_get_response.locked_mode", [] { return settings.locked_mode(); });
+  runner.run("settings_get_response.locked_temp", [] { return settings.locked_temp(); });
+  runner.run("settings_get_response.get_horizontal_vane", [] { return settings.get_horizontal_vane(); });
+  runner.run("settings_get_response.get_horizontal_vane_msb", [] { return settings.get_horizontal_vane_msb(); });
+  runner.run("settings_get_response.get_target_temp", [] { return settings.get_target_temp(); });
+  runner.run("settings_get_response.get_target_temp_deci_c", [] { return settings.get_target_temp_deci_c(); });
+  runner.run("settings_get_response.is_i_see_enabled", [] { return settings.is_i_see_enabled(); });
+
+  runner.run("current_temp_get_response.get_current_temp", [] { return current_temp.get_current_temp(); });
+  runner.run("current_temp_get_response.get_current_temp_deci_c",
+             [] { return current_temp.get_current_temp_deci_c(); });
+  runner.run("current_temp_get_response.get_outdoor_temp", [] { return current_temp.get_outdoor_temp(); });
+  runner.run("current_temp_get_response.get_outdoor_temp_deci_c",
+             [] { return current_temp.get_outdoor_temp_deci_c(); });
+  runner.run("current_temp_get_response.get_runtime_minutes", [] { return current_temp.get_runtime_minutes(); });
+
+  runner.run("status_get_response.get_compressor_frequency", [] { return status.get_compressor_frequency(); });
+  runner.run("status_get_response.get_operating", [] { return status.get_operating(); });
+  runner.run("status_get_response.get_input_watts", [] { return status.get_input_watts(); });
+  runner.run("status_get_response.get_lifetime_kwh", [] { return status.get_lifetime_kwh(); });
+
+  runner.run("run_state_get_response.service_filter", [] { return run_state.service_filter(); });
+  runner.run("run_state_get_response.in_defrost", [] { return run_state.in_defrost(); });
+  runner.run("run_state_get_response.in_preheat", [] { return run_state.in_preheat(); });
+  runner.run("run_state_get_response.in_standby", [] { return run_state.in_standby(); });
+  runner.run("run_state_get_response.get_actual_fan_speed", [] { return run_state.get_actual_fan_speed(); });
+  runner.run("run_state_get_response.get_auto_mode", [] { return run_state.get_auto_mode(); });
+
+  runner.run("error_state_get_response.get_error_code", [] { return error_state.get_error_code(); });
+  runner.run("error_state_get_response.get_raw_short_code", [] { return error_state.get_raw_short_code(); });
+  runner.run("error_state_get_response.get_short_code", [] { return error_state.get_short_code(); });
+  runner.run("error_state_get_response.error_present", [] { return error_state.error_present(); });
+
+  runner.run("capabilities_response.get_supported_fan_speeds", [] { return capabilities.get_supported_fan_speeds(); });
+  runner.run("capabilities_response.get_min_heating_setpoint", [] { return capabilities.get_min_heating_setpoint(); });
+}
+
+void bench_set_packets(itp_bench::Runner &runner) {
+  runner.run("settings_set_request.get_power", [] { return settings_set.get_power(); });
+  runner.run("settings_set_request.get_mode", [] { return settings_set.get_mode(); });
+  runner.run("settings_set_request.get_fan", [] { return settings_set.get_fan(); });
+  runner.run("settings_set_request.get_vane", [] { return settings_set.get_vane(); });
+  runner.run("settings_set_request.get_horizontal_vane", [] { return settings_set.get_horizontal_vane(); });
+  runner.run("settings_set_request.get_horizontal_vane_msb", [] { return settings_set.get_horizontal_vane_msb(); });
+  runner.run("settings_set_request.get_target_temp", [] { return settings_set.get_target_temp(); });
+  runner.run("settings_set_request.get_target_temp_deci_c", [] { return settings_set.get_target_temp_deci_c(); });
+  runner.run("settings_set_request.build_all_fields", [] {
+    SettingsSetRequestPacket pkt;
+    pkt.set_power(true)
+        .set_mode(SettingsSetRequestPacket::MODE_BYTE_COOL)
+        .set_target_temperature(temp_float)
+        .set_fan(SettingsSetRequestPacket::FAN_2)
+        .set_vane(SettingsSetRequestPacket::VANE_SWING)
+        .set_horizontal_vane(SettingsSetRequestPacket::HV_SWING);
+    return pkt.get_flags();
+  });
+  runner.run("settings_set_request.set_target_temperature", [] {
+    SettingsSetRequestPacket pkt;
+    return pkt.set_target_temperature(temp_float).get_flags();
+  });
+  runner.run("settings_set_request.set_target_temperature_deci_c", [] {
+    SettingsSetRequestPacket pkt;
+    return pkt.set_target_temperature_deci_c(temp_deci_c).get_flags();
+  });
+
+  runner.run("remote_temperature_set_request.get_remote_temperature",
+             [] { return remote_temp.get_remote_temperature(); });
+  runner.run("remote_temperature_set_request.get_use_internal_temperature",
+             [] { return remote_temp.get_use_internal_temperature(); });
+  runner.run("remote_temperature_set_request.build", [] {
+    RemoteTemperatureSetRequestPacket pkt;
+    pkt.set_remote_temperature(temp_float);
+    return pkt.get_flags();
+  });
+  runner.run("remote_temperature_set_request.build_deci_c", [] {
+    RemoteTemperatureSetRequestPacket pkt;
+    pkt.set_remote_temperature_deci_c(temp_deci_c);
+    return pkt.get_flags();
+  });
+
+  runner.run("set_response.get_result_code", [] { return set_response.get_result_code(); });
+  runner.run("set_response.is_successful", [] { return set_response.is_successful(); });
+}
+
+void bench_thermostat_packets(itp_bench::Runner &runner) {
+  runner.run("thermostat_sensor_status.get_indoor_humidity_percent",
+             [] { return sensor_status.get_indoor_humidity_percent(); });
+  runner.run("thermostat_sensor_status.get_thermostat_battery_state",
+             [] { return sensor_status.get_thermostat_battery_state(); });
+  runner.run("thermostat_sensor_status.get_sensor_flags", [] { return sensor_status.get_sensor_flags(); });
+
+  runner.run("thermostat_hello.get_thermostat_model", [] { return hello.get_thermostat_model(); });
+  runner.run("thermostat_hello.get_thermostat_serial", [] { return hello.get_thermostat_serial(); });
+  runner.run("thermostat_hello.get_thermostat_serial_buffer", [] {
+    char buffer[ThermostatHelloPacket::SERIAL_BUFFER_SIZE];
+    return hello.get_thermostat_serial(buffer);
+  });
+  runner.run("thermostat_hello.get_thermostat_version_string", [] { return hello.get_thermostat_version_string(); });
+
+  runner.run("thermostat_state_upload.get_thermostat_timestamp",
+             [] { return state_upload.get_thermostat_timestamp(); });
+  runner.run("thermostat_state_upload.get_auto_mode", [] { return state_upload.get_auto_mode(); });
+  runner.run("thermostat_state_upload.get_heat_setpoint", [] { return state_upload.get_heat_setpoint(); });
+  runner.run("thermostat_state_upload.get_cool_setpoint", [] { return state_upload.get_cool_setpoint(); });
+}
+
+void bench_utils(itp_bench::Runner &runner) {
+  runner.run("utils.decode_n_bit_string.12", [] {
+    do_not_optimize(hello_bytes);
+    return ITPUtils::decode_n_bit_string(hello_bytes, 12, 6);
+  });
+  runner.run("utils.decode_6_bit_string.12", [] {
+    char buffer[13];
+    do_not_optimize(hello_bytes);
+    ITPUtils::decode_6_bit_string(hello_bytes, 12, buffer);
+    return buffer[11];
+  });
+  runner.run("utils.reference_decode_6_bit_string.12", [] {
+    char buffer[13];
+    do_not_optimize(hello_bytes);
+    reference_decode_6_bit_string(hello_bytes, 12, buffer);
+    return buffer[11];
+  });
+  runner.run("utils.encode_6_bit_string.12", [] {
+    static char serial[] = "MHK2SERIAL01";
+    uint8_t data[9];
+    do_not_optimize(serial);
+    ITPUtils::encode_6_bit_string(serial, 12, data);
+    return data[8];
+  });
+
+  runner.run("utils.temp_scale_a_to_deg_c", [] { return ITPUtils::temp_scale_a_to_deg_c(temp_byte); });
+  runner.run("utils.deg_c_to_temp_scale_a", [] { return ITPUtils::deg_c_to_temp_scale_a(temp_float); });
+  runner.run("utils.legacy_target_temp_to_deg_c", [] { return ITPUtils::legacy_target_temp_to_deg_c(temp_byte); });
+  runner.run("utils.deg_c_to_legacy_target_temp", [] { return ITPUtils::deg_c_to_legacy_target_temp(temp_float); });
+  runner.run("utils.legacy_hp_room_temp_to_deg_c", [] { return ITPUtils::legacy_hp_room_temp_to_deg_c(temp_byte); });
+  runner.run("utils.deg_c_to_legacy_hp_room_temp", [] { return ITPUtils::deg_c_to_legacy_hp_room_temp(temp_float); });
+  runner.run("utils.legacy_ts_room_temp_to_deg_c", [] { return ITPUtils::legacy_ts_room_temp_to_deg_c(temp_byte); });
+  runner.run("utils.deg_c_to_legacy_ts_room_temp", [] { return ITPUtils::deg_c_to_legacy_ts_room_temp(temp_float); });
+
+  // On a host with an FPU these match the float converters above; they're here to catch regressions, not to show a gain
+  runner.run("utils.temp_scale_a_to_deci_c", [] { return ITPUtils::temp_scale_a_to_deci_c(temp_byte); });
+  runner.run("utils.deci_c_to_temp_scale_a", [] { return ITPUtils::deci_c_to_temp_scale_a(temp_deci_c); });
+  runner.run("utils.legacy_target_temp_to_deci_c", [] { return ITPUtils::legacy_target_temp_to_deci_c(temp_byte); });
+  runner.run("utils.deci_c_to_legacy_target_temp",
+             [] { return ITPUtils::deci_c_to_legacy_target_temp(temp_deci_c); });
+  runner.run("utils.legacy_hp_room_temp_to_deci_c",
+             [] { return ITPUtils::legacy_hp_room_temp_to_deci_c(temp_byte); });
+  runner.run("utils.deci_c_to_legacy_hp_room_temp",
+             [] { return ITPUtils::deci_c_to_legacy_hp_room_temp(temp_deci_c); });
+  runner.run("utils.legacy_ts_room_temp_to_deci_c",
+             [] { return ITPUtils::legacy_ts_room_temp_to_deci_c(temp_byte); });
+  runner.run("utils.deci_c_to_legacy_ts_room_temp",
+             [] { return ITPUtils::deci_c_to_legacy_ts_room_temp(temp_deci_c); });
+
+  runner.run("utils.format_hex_pretty", [] {
+    return ITPUtils::format_hex_pretty(settings_raw.get_bytes(), settings_raw.get_length());
+  });
+}
+
+void bench_to_string(itp_bench::Runner &runner) {
+  runner.run("to_string.packet", [] { return generic.to_string(); });
+  runner.run("to_string.connect_request", [] { return ConnectRequestPacket::instance().to_string(); });
+  runner.run("to_string.connect_response", [] { return connect_response.to_string(); });
+  runner.run("to_string.capabilities_response", [] { return capabilities.to_string(); });
+  runner.run("to_string.identify_cd_response", [] { return identify_cd.to_string(); });
+  runner.run("to_string.get_request", [] { return get_request.to_string(); });
+  runner.run("to_string.settings_get_response", [] { return settings.to_string(); });
+  runner.run("to_string.current_temp_get_response", [] { return current_temp.to_string(); });
+  runner.run("to_string.status_get_response", [] { return status.to_string(); });
+  runner.run("to_string.run_state_get_response", [] { return run_state.to_string(); });
+  runner.run("to_string.error_state_get_response", [] { return error_state.to_string(); });
+  runner.run("to_string.functions_1_get_response", [] { return functions_1.to_string(); });
+  runner.run("to_string.functions_2_get_response", [] { return functions_2.to_string(); });
+  runner.run("to_string.settings_set_request", [] { return settings_set.to_string(); });
+  runner.run("to_string.remote_temperature_set_request", [] { return remote_temp.to_string(); });
+  runner.run("to_string.thermostat_sensor_status", [] { return sensor_status.to_string(); });
+  runner.run("to_string.thermostat_hello", [] { return hello.to_string(); });
+  runner.run("to_string.thermostat_state_upload", [] { return state_upload.to_string(); });
+
+  // The allocation-free path to_string() is built on
+  static char buffer[PACKET_FORMAT_BUFFER_SIZE];
+  runner.run("format.packet", [] { return generic.format(buffer, sizeof(buffer)); });
+  runner.run("format.capabilities_response", [] { return capabilities.format(buffer, sizeof(buffer)); });
+  runner.run("format.settings_get_response", [] { return settings.format(buffer, sizeof(buffer)); });
+  runner.run("format.settings_get_response_no_color", [] { return settings.format(buffer, sizeof(buffer), false); });
+  runner.run("format.functions_1_get_response", [] { return functions_1.format(buffer, sizeof(buffer)); });
+  runner.run("format.settings_set_request", [] { return settings_set.format(buffer, sizeof(buffer)); });
+  runner.run("format.thermostat_hello", [] { return hello.format(buffer, sizeof(buffer)); });
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  itp_bench::Runner runner(argc, argv);
+
+  bench_raw_packet(runner);
+  bench_packet_record(runner);
+  bench_spsc_ring(runner);
+  bench_transactions(runner);
+  bench_request_engine(runner);
+  bench_poll_scheduler(runner);
+  bench_settings_coalescer(runner);
+  bench_redundant_set_filter(runner);
+  bench_remote_temperature_feed(runner);
+  bench_change_detector(runner);
+  bench_heat_pump_state(runner);
+#ifdef ITP_PACKET_HAVE_HOST
+  bench_shared_bus(runner);
+  bench_capture(runner);
+  bench_heat_pump_emulator(runner);
+  bench_thermostat_emulator(runner);
+  bench_gateway(runner);
+#endif
+  bench_framing(runner);
+  bench_get_packets(runner);
+  bench_set_packets(runner);
+  bench_thermostat_packets(runner);
+  bench_utils(runner);
+  bench_to_string(runner);
+
+  return runner.finish();
+}
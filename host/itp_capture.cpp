@@ -0,0 +1,363 @@
+#include "itp_capture.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace itp_packet {
+
+static size_t chunk_stride(uint32_t chunk_records) {
+  return (size_t) chunk_records * sizeof(CaptureRecord) + sizeof(CaptureIndexBlock);
+}
+
+static bool is_compatible(const CaptureFileHeader &header) {
+  return header.magic == CAPTURE_MAGIC && header.version == CAPTURE_VERSION &&
+         header.record_size == sizeof(CaptureRecord) && header.index_size == sizeof(CaptureIndexBlock) &&
+         header.chunk_records > 0;
+}
+
+CaptureRecord CaptureRecord::from_view(const RawPacketView &view, SourceBridge source_bridge,
+                                       ControllerAssociation controller_association, uint64_t timestamp_us) {
+  CaptureRecord record;
+  memset(&record, 0, sizeof(record));
+  record.timestamp_us = timestamp_us;
+  record.length = view.get_length() < PACKET_MAX_SIZE ? view.get_length() : PACKET_MAX_SIZE;
+  memcpy(record.bytes, view.get_bytes(), record.length);
+  record.origin = static_cast<uint8_t>(source_bridge) | static_cast<uint8_t>(controller_association) << 4;
+  return record;
+}
+
+size_t CaptureIndexBlock::type_row(uint8_t packet_type) {
+  switch (static_cast<PacketType>(packet_type)) {
+    case PacketType::CONNECT_REQUEST:
+      return 0;
+    case PacketType::CONNECT_RESPONSE:
+      return 1;
+    case PacketType::GET_REQUEST:
+      return 2;
+    case PacketType::GET_RESPONSE:
+      return 3;
+    case PacketType::SET_REQUEST:
+      return 4;
+    case PacketType::SET_RESPONSE:
+      return 5;
+    case PacketType::IDENTIFY_REQUEST:
+      return 6;
+    case PacketType::IDENTIFY_RESPONSE:
+      return 7;
+    default:
+      return TYPE_ROWS - 1;
+  }
+}
+
+// CaptureWriter functions
+
+bool CaptureWriter::open(const char *path, uint32_t chunk_records) {
+  close();
+  if (chunk_records == 0) {
+    errno = EINVAL;
+    return false;
+  }
+
+  fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0)
+    return false;
+
+  CaptureFileHeader header{};
+  header.magic = CAPTURE_MAGIC;
+  header.version = CAPTURE_VERSION;
+  header.record_size = sizeof(CaptureRecord);
+  header.chunk_records = chunk_records;
+  header.index_size = sizeof(CaptureIndexBlock);
+
+  chunk_records_ = chunk_records;
+  record_count_ = 0;
+  last_timestamp_us_ = 0;
+  buffered_ = 0;
+  start_chunk_();
+  if (!write_all_(&header, sizeof(header))) {
+    int error = errno;
+    close();
+    errno = error;
+    return false;
+  }
+  return true;
+}
+
+bool CaptureWriter::open_append(const char *path) {
+  close();
+  int fd = ::open(path, O_RDWR | O_CLOEXEC);
+  if (fd < 0)
+    return errno == ENOENT ? open(path) : false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int error = errno;
+    ::close(fd);
+    errno = error;
+    return false;
+  }
+  if (st.st_size == 0) {
+    ::close(fd);
+    return open(path);
+  }
+
+  CaptureFileHeader header;
+  if (pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header) || !is_compatible(header)) {
+    ::close(fd);
+    errno = EPROTO;
+    return false;
+  }
+
+  // Keep whole chunks, and the whole records of a trailing partial chunk; a chunk whose index block is missing or
+  // torn has its index rebuilt below
+  size_t stride = chunk_stride(header.chunk_records);
+  uint64_t body = st.st_size - sizeof(header);
+  uint64_t chunks = body / stride;
+  uint64_t partial = (body % stride) / sizeof(CaptureRecord);
+  if (partial > header.chunk_records)
+    partial = header.chunk_records;
+
+  off_t end = sizeof(header) + chunks * stride + partial * sizeof(CaptureRecord);
+  if (ftruncate(fd, end) != 0 || lseek(fd, end, SEEK_SET) != end) {
+    int error = errno;
+    ::close(fd);
+    errno = error;
+    return false;
+  }
+
+  fd_ = fd;
+  chunk_records_ = header.chunk_records;
+  record_count_ = chunks * chunk_records_;
+  last_timestamp_us_ = 0;
+  buffered_ = 0;
+  start_chunk_();
+
+  if (chunks > 0) {
+    CaptureIndexBlock last_index;
+    if (pread(fd_, &last_index, sizeof(last_index), sizeof(header) + chunks * stride - sizeof(last_index)) ==
+        (ssize_t) sizeof(last_index))
+      last_timestamp_us_ = last_index.last_timestamp_us;
+  }
+
+  // Account for the partial chunk's records as though they had just been appended
+  off_t offset = sizeof(header) + chunks * stride;
+  for (uint64_t i = 0; i < partial; i++, offset += sizeof(CaptureRecord)) {
+    CaptureRecord record;
+    if (pread(fd_, &record, sizeof(record), offset) != (ssize_t) sizeof(record)) {
+      int error = errno;
+      close();
+      errno = error;
+      return false;
+    }
+    if (index_.record_count == 0) {
+      index_.first_record = record_count_;
+      index_.first_timestamp_us = record.timestamp_us;
+    }
+    index_.add(record.get_packet_type(), record.get_command());
+    index_.last_timestamp_us = record.timestamp_us;
+    index_.record_count++;
+    record_count_++;
+    last_timestamp_us_ = record.timestamp_us;
+  }
+
+  // A full chunk without its index block gets one now
+  return flush();
+}
+
+void CaptureWriter::close() {
+  if (fd_ < 0)
+    return;
+  flush();
+  ::close(fd_);
+  fd_ = -1;
+}
+
+bool CaptureWriter::append(const RawPacketView &frame, SourceBridge source_bridge,
+                           ControllerAssociation controller_association, uint64_t timestamp_us) {
+  return append(CaptureRecord::from_view(frame, source_bridge, controller_association, timestamp_us));
+}
+
+bool CaptureWriter::append(const CaptureRecord &record) {
+  if (buffered_ == BUFFER_RECORDS && !flush())
+    return false;
+
+  CaptureRecord &slot = buffer_[buffered_++];
+  slot = record;
+  if (slot.timestamp_us < last_timestamp_us_)
+    slot.timestamp_us = last_timestamp_us_;
+  last_timestamp_us_ = slot.timestamp_us;
+
+  if (index_.record_count == 0) {
+    index_.first_record = record_count_;
+    index_.first_timestamp_us = slot.timestamp_us;
+  }
+  index_.add(slot.get_packet_type(), slot.get_command());
+  index_.last_timestamp_us = slot.timestamp_us;
+  index_.record_count++;
+  record_count_++;
+
+  // The index block has to follow the chunk's last record directly
+  if (index_.record_count == chunk_records_)
+    return flush();
+  return true;
+}
+
+bool CaptureWriter::flush() {
+  if (fd_ < 0)
+    return false;
+
+  if (buffered_ > 0) {
+    if (!write_all_(buffer_, buffered_ * sizeof(CaptureRecord)))
+      return false;
+    buffered_ = 0;
+  }
+
+  if (index_.record_count == chunk_records_) {
+    if (!write_all_(&index_, sizeof(index_)))
+      return false;
+    start_chunk_();
+  }
+  return true;
+}
+
+bool CaptureWriter::write_all_(const void *data, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  while (size > 0) {
+    ssize_t written = ::write(fd_, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+
+void CaptureWriter::start_chunk_() {
+  index_ = CaptureIndexBlock{};
+  index_.magic = CAPTURE_INDEX_MAGIC;
+}
+
+// CaptureReader functions
+
+bool CaptureReader::open(const char *path) {
+  close();
+  fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0)
+    return false;
+
+  if (!map_()) {
+    int error = errno;
+    ::close(fd_);
+    fd_ = -1;
+    errno = error;
+    return false;
+  }
+  return true;
+}
+
+bool CaptureReader::refresh() {
+  if (fd_ < 0) {
+    errno = EBADF;
+    return false;
+  }
+  unmap_();
+  return map_();
+}
+
+void CaptureReader::close() {
+  unmap_();
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool CaptureReader::map_() {
+  struct stat st;
+  if (fstat(fd_, &st) != 0)
+    return false;
+  if ((size_t) st.st_size < sizeof(CaptureFileHeader)) {
+    errno = EPROTO;
+    return false;
+  }
+
+  void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapping == MAP_FAILED)
+    return false;
+
+  const CaptureFileHeader *header = static_cast<const CaptureFileHeader *>(mapping);
+  if (!is_compatible(*header)) {
+    munmap(mapping, st.st_size);
+    errno = EPROTO;
+    return false;
+  }
+
+  data_ = static_cast<const uint8_t *>(mapping);
+  mapped_size_ = st.st_size;
+  chunk_records_ = header->chunk_records;
+
+  // A chunk only counts as indexed once its index block is complete
+  size_t stride = chunk_stride(chunk_records_);
+  uint64_t body = mapped_size_ - sizeof(CaptureFileHeader);
+  uint64_t partial = (body % stride) / sizeof(CaptureRecord);
+  indexed_chunks_ = body / stride;
+  record_count_ = indexed_chunks_ * chunk_records_ + (partial < chunk_records_ ? partial : chunk_records_);
+  return true;
+}
+
+void CaptureReader::unmap_() {
+  if (data_ != nullptr)
+    munmap(const_cast<uint8_t *>(data_), mapped_size_);
+  data_ = nullptr;
+  mapped_size_ = 0;
+  record_count_ = 0;
+  indexed_chunks_ = 0;
+}
+
+const CaptureRecord *CaptureReader::record_at_(uint64_t position) const {
+  size_t offset = sizeof(CaptureFileHeader) + (position / chunk_records_) * chunk_stride(chunk_records_) +
+                  (position % chunk_records_) * sizeof(CaptureRecord);
+  return reinterpret_cast<const CaptureRecord *>(data_ + offset);
+}
+
+const CaptureIndexBlock &CaptureReader::get_index(uint64_t chunk) const {
+  size_t offset = sizeof(CaptureFileHeader) + (chunk + 1) * chunk_stride(chunk_records_) - sizeof(CaptureIndexBlock);
+  return *reinterpret_cast<const CaptureIndexBlock *>(data_ + offset);
+}
+
+uint64_t CaptureReader::find_time(uint64_t timestamp_us) const {
+  // First the chunk: the earliest indexed chunk that ends at or after timestamp_us, else the partial chunk
+  uint64_t low = 0, high = indexed_chunks_;
+  while (low < high) {
+    uint64_t mid = low + (high - low) / 2;
+    if (get_index(mid).last_timestamp_us < timestamp_us) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  // Then the record within it
+  uint64_t begin = low * chunk_records_;
+  if (begin >= record_count_)
+    return record_count_;
+  uint64_t end = begin + chunk_records_ < record_count_ ? begin + chunk_records_ : record_count_;
+  while (begin < end) {
+    uint64_t mid = begin + (end - begin) / 2;
+    if (record_at_(mid)->timestamp_us < timestamp_us) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return begin;
+}
+
+}  // namespace itp_packet
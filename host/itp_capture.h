@@ -0,0 +1,219 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "itp_rawpacketview.h"
+
+namespace itp_packet {
+
+// File layout; readers refuse to open a capture with a different version
+static const uint32_t CAPTURE_MAGIC = 0x43505449;        // "ITPC"
+static const uint32_t CAPTURE_INDEX_MAGIC = 0x49505449;  // "ITPI"
+static const uint16_t CAPTURE_VERSION = 1;
+
+/* One captured frame.  Records are 32 bytes with no padding, so a capture is an array of them that can be mapped
+and read in place.  Timestamps are microseconds from a monotonic clock (e.g. CLOCK_MONOTONIC), and never decrease
+within a capture.
+*/
+struct CaptureRecord {
+  uint64_t timestamp_us;
+  uint8_t bytes[PACKET_MAX_SIZE];  // Unused bytes are zero
+  uint8_t length;
+  uint8_t origin;  // SourceBridge in the low nibble, ControllerAssociation in the high nibble
+
+  static CaptureRecord from_view(const RawPacketView &view, SourceBridge source_bridge,
+                                 ControllerAssociation controller_association, uint64_t timestamp_us);
+
+  RawPacketView view() const { return RawPacketView(bytes, length); }
+  SourceBridge get_source_bridge() const { return static_cast<SourceBridge>(origin & 0x0F); }
+  ControllerAssociation get_controller_association() const {
+    return static_cast<ControllerAssociation>(origin >> 4);
+  }
+  uint8_t get_packet_type() const { return bytes[PACKET_HEADER_INDEX_PACKET_TYPE]; }
+  uint8_t get_command() const { return length > PACKET_HEADER_SIZE ? bytes[PACKET_HEADER_SIZE] : 0; }
+};
+
+static_assert(sizeof(CaptureRecord) == 32, "CaptureRecord is part of the capture file format");
+
+struct CaptureFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;    // sizeof(CaptureRecord)
+  uint32_t chunk_records;  // Records between two index blocks
+  uint32_t index_size;     // sizeof(CaptureIndexBlock)
+  uint8_t reserved[48];
+};
+
+static_assert(sizeof(CaptureFileHeader) == 64, "CaptureFileHeader is part of the capture file format");
+
+/* Written after every chunk_records records, summarizing them so that readers can skip whole chunks.  Packet types
+and commands are summarized as a bitmap with one bit per (type, command) pair; unrecognized packet types share one
+row of it.
+*/
+struct CaptureIndexBlock {
+  static const size_t TYPE_ROWS = 9;
+
+  uint32_t magic;
+  uint32_t record_count;
+  uint64_t first_record;  // Position of the chunk's first record in the capture
+  uint64_t first_timestamp_us;
+  uint64_t last_timestamp_us;
+  uint8_t reserved[32];
+  uint64_t keys[TYPE_ROWS][256 / 64];
+
+  // Which bitmap row a packet type uses
+  static size_t type_row(uint8_t packet_type);
+
+  void add(uint8_t packet_type, uint8_t command) {
+    size_t row = type_row(packet_type);
+    keys[row][command / 64] |= uint64_t{1} << (command % 64);
+  }
+  bool contains(uint8_t packet_type, uint8_t command) const {
+    size_t row = type_row(packet_type);
+    return keys[row][command / 64] & (uint64_t{1} << (command % 64));
+  }
+};
+
+static_assert(sizeof(CaptureIndexBlock) % sizeof(CaptureRecord) == 0, "Index blocks must keep records aligned");
+
+/* Appends frames to a capture file: a header, then chunks of chunk_records CaptureRecords, each followed by a
+CaptureIndexBlock.  The records after the last index block form a partial chunk, which readers scan directly.  A
+capture cut short (e.g. by a crash) loses at most the records not yet flushed, and can be appended to.
+
+Records are buffered; call flush() to write them out (e.g. once a second).  Not thread-safe.
+*/
+class CaptureWriter {
+ public:
+  static const uint32_t DEFAULT_CHUNK_RECORDS = 4096;
+  static const size_t BUFFER_RECORDS = 64;
+
+  CaptureWriter() = default;
+  CaptureWriter(const CaptureWriter &) = delete;
+  CaptureWriter &operator=(const CaptureWriter &) = delete;
+  ~CaptureWriter() { close(); }
+
+  // Creates (or truncates) a capture at path.  Returns false and sets errno on failure.
+  bool open(const char *path, uint32_t chunk_records = DEFAULT_CHUNK_RECORDS);
+  // Continues an existing capture (any torn record at its end is discarded), or creates it if it doesn't exist.
+  // Returns false and sets errno on failure (EPROTO if the file isn't a compatible capture).
+  bool open_append(const char *path);
+  // Flushes and closes the file
+  void close();
+  bool is_open() const { return fd_ >= 0; }
+
+  // Appends a frame.  A timestamp earlier than the previous record's is raised to it, keeping the capture ordered.
+  // Returns false and sets errno if buffered records couldn't be written.
+  bool append(const RawPacketView &frame, SourceBridge source_bridge, ControllerAssociation controller_association,
+              uint64_t timestamp_us);
+  bool append(const CaptureRecord &record);
+  // Writes buffered records to the file
+  bool flush();
+
+  uint64_t get_record_count() const { return record_count_; }
+
+ private:
+  int fd_ = -1;
+  uint32_t chunk_records_ = DEFAULT_CHUNK_RECORDS;
+  uint64_t record_count_ = 0;
+  uint64_t last_timestamp_us_ = 0;
+  CaptureIndexBlock index_{};
+  CaptureRecord buffer_[BUFFER_RECORDS];
+  size_t buffered_ = 0;
+
+  bool write_all_(const void *data, size_t size);
+  void start_chunk_();
+};
+
+/* Reads a capture by mapping it, without copying or parsing: opening a capture of any size costs a few system
+calls, and records are read straight from the page cache.  Records can be read by position, found by time with a
+binary search over the index blocks, or scanned for a packet type and command, skipping every chunk whose index
+shows it has none.
+
+The reader sees the capture as it was when opened (or last refreshed); it can be used from several threads at once.
+*/
+class CaptureReader {
+ public:
+  CaptureReader() = default;
+  CaptureReader(const CaptureReader &) = delete;
+  CaptureReader &operator=(const CaptureReader &) = delete;
+  ~CaptureReader() { close(); }
+
+  // Maps the capture at path read-only.  Returns false and sets errno on failure (EPROTO if the file isn't a
+  // compatible capture).
+  bool open(const char *path);
+  // Remaps the file to pick up records appended since it was opened (e.g. to follow a capture being written)
+  bool refresh();
+  void close();
+  bool is_open() const { return data_ != nullptr; }
+
+  uint64_t size() const { return record_count_; }
+  const CaptureRecord &operator[](uint64_t position) const { return *record_at_(position); }
+
+  // Position of the first record at or after timestamp_us (size() if there is none)
+  uint64_t find_time(uint64_t timestamp_us) const;
+
+  // Number of chunks that have an index block, and the index block of one of them
+  uint64_t get_indexed_chunks() const { return indexed_chunks_; }
+  const CaptureIndexBlock &get_index(uint64_t chunk) const;
+
+  // Calls fn(position, record) for every record in [begin, end)
+  template<typename F> void for_each(uint64_t begin, uint64_t end, F &&fn) const {
+    if (end > record_count_)
+      end = record_count_;
+    while (begin < end) {
+      // Records are contiguous within a chunk
+      uint64_t chunk_end = (begin / chunk_records_ + 1) * chunk_records_;
+      uint64_t stop = chunk_end < end ? chunk_end : end;
+      const CaptureRecord *record = record_at_(begin);
+      for (; begin < stop; begin++, record++) {
+        fn(begin, *record);
+      }
+    }
+  }
+
+  // Calls fn(position, record) for every record with timestamps in [begin_us, end_us)
+  template<typename F> void for_each_in_time(uint64_t begin_us, uint64_t end_us, F &&fn) const {
+    for_each(find_time(begin_us), find_time(end_us), fn);
+  }
+
+  // Calls fn(position, record) for every record in [begin, end) with the given packet type and command.  Returns
+  // the number of matching records.
+  template<typename F>
+  uint64_t for_each_matching(uint8_t packet_type, uint8_t command, uint64_t begin, uint64_t end, F &&fn) const {
+    uint64_t matches = 0;
+    if (end > record_count_)
+      end = record_count_;
+    while (begin < end) {
+      uint64_t chunk = begin / chunk_records_;
+      uint64_t chunk_end = (chunk + 1) * chunk_records_;
+      uint64_t stop = chunk_end < end ? chunk_end : end;
+      if (chunk < indexed_chunks_ && !get_index(chunk).contains(packet_type, command)) {
+        begin = stop;
+        continue;
+      }
+
+      const CaptureRecord *record = record_at_(begin);
+      for (; begin < stop; begin++, record++) {
+        if (record->get_packet_type() == packet_type && record->get_command() == command) {
+          matches++;
+          fn(begin, *record);
+        }
+      }
+    }
+    return matches;
+  }
+
+ private:
+  int fd_ = -1;
+  const uint8_t *data_ = nullptr;
+  size_t mapped_size_ = 0;
+  uint32_t chunk_records_ = 0;
+  uint64_t record_count_ = 0;
+  uint64_t indexed_chunks_ = 0;
+
+  bool map_();
+  void unmap_();
+  const CaptureRecord *record_at_(uint64_t position) const;
+};
+
+}  // namespace itp_packet
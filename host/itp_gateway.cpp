@@ -0,0 +1,404 @@
+#include "itp_gateway.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace itp_packet {
+
+// Events handled per epoll_wait(); more ready links are picked up by the next call
+static const int MAX_EVENTS = 64;
+
+// True if time a is at or after time b, allowing for wraparound
+static bool is_due(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) >= 0; }
+
+static int64_t monotonic_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static speed_t speed_for(uint32_t baud_rate) {
+  switch (baud_rate) {
+    case 1200:
+      return B1200;
+    case 4800:
+      return B4800;
+    case 9600:
+      return B9600;
+    case 19200:
+      return B19200;
+    default:
+      return B2400;
+  }
+}
+
+// Raw 8E1 at the link's baud rate, as ITP uses; does nothing to descriptors that aren't ttys
+static bool configure_serial(int fd, uint32_t baud_rate) {
+  if (!isatty(fd))
+    return true;
+
+  struct termios tio;
+  if (tcgetattr(fd, &tio) != 0)
+    return false;
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD | PARENB;
+  tio.c_cflag &= ~(PARODD | CSTOPB);
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  cfsetispeed(&tio, speed_for(baud_rate));
+  cfsetospeed(&tio, speed_for(baud_rate));
+  return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+const char *gateway_link_state_name(GatewayLinkState state) {
+  switch (state) {
+    case GatewayLinkState::CLOSED:
+      return "closed";
+    case GatewayLinkState::CONNECTING:
+      return "connecting";
+    case GatewayLinkState::ONLINE:
+      return "online";
+    default:
+      return "unknown";
+  }
+}
+
+GatewayLink::GatewayLink(Gateway &gateway, size_t index, const char *name, bool reopen, uint32_t now_ms)
+    : gateway_{gateway},
+      index_{index},
+      reopen_{reopen},
+      engine_{[this](const RawPacketView &frame) { gateway_.send_(*this, frame); }, gateway.config_.engine},
+      scheduler_{gateway.config_.poll, now_ms} {
+  strncpy(name_, name, NAME_SIZE - 1);
+}
+
+GatewayLink::~GatewayLink() {
+  if (fd_ >= 0)
+    ::close(fd_);
+}
+
+void GatewayLink::reset_stats() {
+  stats_ = {};
+  engine_.reset_stats();
+  scheduler_.reset_stats();
+  framer_.reset_stats();
+}
+
+Gateway::Gateway(GatewayConfig config) : config_{config}, start_ns_{monotonic_ns()} {}
+
+Gateway::~Gateway() { close(); }
+
+bool Gateway::open() {
+  close();
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  return epoll_fd_ >= 0;
+}
+
+void Gateway::close() {
+  // Destroying the links closes their descriptors, without calling back for their outstanding requests
+  links_.clear();
+  if (epoll_fd_ >= 0)
+    ::close(epoll_fd_);
+  epoll_fd_ = -1;
+}
+
+uint32_t Gateway::now_ms() const { return (monotonic_ns() - start_ns_) / 1000000; }
+
+int Gateway::add_link(const char *device_path) {
+  int fd = ::open(device_path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+  return add_link_(fd, device_path, true);
+}
+
+int Gateway::adopt_link(int fd, const char *name) {
+  int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+    int error = errno;
+    ::close(fd);
+    errno = error;
+    return -1;
+  }
+  return add_link_(fd, name, false);
+}
+
+int Gateway::add_link_(int fd, const char *name, bool reopen) {
+  if (epoll_fd_ < 0 || (config_.configure_serial && !configure_serial(fd, config_.poll.baud_rate))) {
+    int error = epoll_fd_ < 0 ? EBADF : errno;
+    ::close(fd);
+    errno = error;
+    return -1;
+  }
+
+  current_ms_ = now_ms();
+  size_t index = links_.size();
+  links_.emplace_back(new GatewayLink(*this, index, name, reopen, current_ms_));
+  GatewayLink &link = *links_.back();
+  link.fd_ = fd;
+  if (!watch_(link, EPOLL_CTL_ADD, false)) {
+    int error = errno;
+    links_.pop_back();
+    errno = error;
+    return -1;
+  }
+
+  link.state_ = GatewayLinkState::CONNECTING;
+  link.retry_at_ms_ = current_ms_;
+  return index;
+}
+
+bool Gateway::open_device_(GatewayLink &link) {
+  int fd = ::open(link.name_, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  if (config_.configure_serial && !configure_serial(fd, config_.poll.baud_rate)) {
+    ::close(fd);
+    return false;
+  }
+
+  link.fd_ = fd;
+  if (!watch_(link, EPOLL_CTL_ADD, false)) {
+    ::close(fd);
+    link.fd_ = -1;
+    return false;
+  }
+  return true;
+}
+
+void Gateway::close_device_(GatewayLink &link, uint32_t now_ms) {
+  if (link.fd_ >= 0)
+    ::close(link.fd_);  // Also removes it from the epoll set
+  link.fd_ = -1;
+  link.want_write_ = false;
+  link.write_length_ = 0;
+  link.framer_.reset();
+  link.state_ = GatewayLinkState::CLOSED;
+  link.retry_at_ms_ = now_ms + config_.reconnect_ms;
+  link.engine_.cancel_all();
+}
+
+bool Gateway::watch_(GatewayLink &link, int op, bool want_write) {
+  epoll_event event = {};
+  event.events = EPOLLIN | (want_write ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+  event.data.u64 = link.index_;
+  if (epoll_ctl(epoll_fd_, op, link.fd_, &event) != 0)
+    return false;
+  link.want_write_ = want_write;
+  return true;
+}
+
+bool Gateway::submit(size_t index, const Packet &request, RequestCallback callback) {
+  GatewayLink &link = *links_[index];
+  if (link.state_ != GatewayLinkState::ONLINE)
+    return false;
+  return link.engine_.submit(request, std::move(callback), now_ms());
+}
+
+int Gateway::run_once(int timeout_ms) {
+  uint32_t now = now_ms();
+  uint32_t until_tick = is_due(now, next_tick_ms_) ? 0 : next_tick_ms_ - now;
+  if (timeout_ms < 0 || until_tick < (uint32_t) timeout_ms)
+    timeout_ms = until_tick;
+
+  epoll_event events[MAX_EVENTS];
+  int ready = epoll_wait(epoll_fd_, events, MAX_EVENTS, timeout_ms);
+  if (ready < 0) {
+    if (errno != EINTR)
+      return -1;
+    ready = 0;
+  }
+
+  current_ms_ = now_ms();
+  for (int i = 0; i < ready; i++) {
+    GatewayLink &link = *links_[events[i].data.u64];
+    if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+      link.lost_ = true;
+    } else {
+      if (events[i].events & EPOLLIN)
+        on_readable_(link, current_ms_);
+      if (events[i].events & EPOLLOUT)
+        on_writable_(link);
+    }
+    // Lets a response's successor go out without waiting for the tick
+    service_(link, current_ms_);
+  }
+
+  if (is_due(current_ms_, next_tick_ms_)) {
+    for (auto &link : links_) {
+      service_(*link, current_ms_);
+    }
+    next_tick_ms_ = current_ms_ + config_.tick_ms;
+  }
+  return ready;
+}
+
+void Gateway::run(const std::atomic<bool> &stop) {
+  while (!stop.load(std::memory_order_relaxed)) {
+    // Wake at least every 100 ms so that stop is noticed
+    if (run_once(100) < 0)
+      return;
+  }
+}
+
+void Gateway::on_readable_(GatewayLink &link, uint32_t now_ms) {
+  // One read per wakeup: epoll is level-triggered, so anything left over is reported again, and a busy link can't
+  // starve the others
+  uint8_t buffer[256];
+  ssize_t received = ::read(link.fd_, buffer, sizeof(buffer));
+  if (received <= 0) {
+    if (received == 0 || (errno != EAGAIN && errno != EINTR))
+      link.lost_ = true;
+    return;
+  }
+
+  link.stats_.bytes_received += received;
+  link.framer_.feed_views(buffer, received,
+                          [this, &link, now_ms](const RawPacketView &frame) { handle_frame_(link, frame, now_ms); });
+}
+
+void Gateway::handle_frame_(GatewayLink &link, const RawPacketView &frame, uint32_t now_ms) {
+  link.stats_.frames_received++;
+  // State first, so that request callbacks see it updated
+  link.heat_pump_state_.process_frame(frame, now_ms);
+  if (!link.engine_.handle_response(frame, now_ms))
+    link.stats_.unmatched_frames++;
+  if (frame_handler_)
+    frame_handler_(link, frame, now_ms);
+}
+
+void Gateway::on_writable_(GatewayLink &link) {
+  if (flush_(link) && link.write_length_ == 0)
+    watch_(link, EPOLL_CTL_MOD, false);
+}
+
+void Gateway::send_(GatewayLink &link, const RawPacketView &frame) {
+  if (link.fd_ < 0)
+    return;
+
+  if (link.write_length_ + frame.get_length() > GatewayLink::WRITE_BUFFER_SIZE) {
+    link.stats_.write_overflows++;
+    return;
+  }
+  memcpy(link.write_buffer_ + link.write_length_, frame.get_bytes(), frame.get_length());
+  link.write_length_ += frame.get_length();
+
+  if (!link.want_write_ && flush_(link) && link.write_length_ > 0) {
+    link.stats_.write_stalls++;
+    if (!watch_(link, EPOLL_CTL_MOD, true))
+      link.lost_ = true;
+  }
+}
+
+bool Gateway::flush_(GatewayLink &link) {
+  while (link.write_length_ > 0) {
+    ssize_t written = ::write(link.fd_, link.write_buffer_, link.write_length_);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN)
+        return true;
+      link.lost_ = true;
+      return false;
+    }
+
+    link.stats_.bytes_sent += written;
+    link.write_length_ -= written;
+    memmove(link.write_buffer_, link.write_buffer_ + written, link.write_length_);
+  }
+  return true;
+}
+
+void Gateway::service_(GatewayLink &link, uint32_t now_ms) {
+  if (link.lost_) {
+    link.lost_ = false;
+    close_device_(link, now_ms);
+  }
+
+  if (link.state_ == GatewayLinkState::CLOSED) {
+    if (!link.reopen_ || !is_due(now_ms, link.retry_at_ms_))
+      return;
+    if (!open_device_(link)) {
+      link.retry_at_ms_ = now_ms + config_.reconnect_ms;
+      return;
+    }
+    link.stats_.reopens++;
+    link.state_ = GatewayLinkState::CONNECTING;
+    link.retry_at_ms_ = now_ms;
+  }
+
+  if (link.reconnect_pending_) {
+    link.reconnect_pending_ = false;
+    link.stats_.reconnects++;
+    link.engine_.cancel_all();
+    link.state_ = GatewayLinkState::CONNECTING;
+    link.retry_at_ms_ = now_ms;
+  }
+
+  link.engine_.loop(now_ms);
+
+  if (link.state_ == GatewayLinkState::CONNECTING) {
+    if (!link.connect_pending_ && is_due(now_ms, link.retry_at_ms_))
+      connect_(link, now_ms);
+    return;
+  }
+
+  // Keep at most a window's worth of polls queued, leaving the rest of the queue for submit()
+  GetCommand command;
+  while (link.engine_.get_pending() < config_.engine.window && link.scheduler_.next(now_ms, command)) {
+    link.engine_.submit(
+        PollScheduler::request_for(command),
+        // Only &link and command are captured (reaching the gateway through the link), so the callback fits in
+        // std::function's inline storage and polling never allocates
+        [&link, command](RequestResult result, const RawPacketView &response) {
+          Gateway &gateway = link.gateway_;
+          if (result == RequestResult::RESPONDED) {
+            link.scheduler_.on_response(command, response, gateway.current_ms_);
+          } else if (result == RequestResult::TIMED_OUT) {
+            link.scheduler_.on_timeout(command, gateway.current_ms_);
+          } else {
+            // Cancelled by a reconnect or a lost device: poll again once the link is back, without counting a timeout
+            link.scheduler_.on_cancelled(command, gateway.current_ms_);
+          }
+          gateway.on_request_result_(link, result);
+        },
+        now_ms);
+  }
+}
+
+void Gateway::connect_(GatewayLink &link, uint32_t now_ms) {
+  link.connect_pending_ = true;
+  link.engine_.submit(
+      ConnectRequestPacket::instance(),
+      [this, &link](RequestResult result, const RawPacketView &) {
+        link.connect_pending_ = false;
+        if (result == RequestResult::TIMED_OUT) {
+          link.retry_at_ms_ = current_ms_ + config_.reconnect_ms;
+        } else if (result == RequestResult::RESPONDED) {
+          link.stats_.connects++;
+          link.state_ = GatewayLinkState::ONLINE;
+          link.consecutive_timeouts_ = 0;
+          if (config_.request_capabilities)
+            link.engine_.submit(CapabilitiesRequestPacket::instance(), nullptr, current_ms_);
+        }
+      },
+      now_ms);
+}
+
+void Gateway::on_request_result_(GatewayLink &link, RequestResult result) {
+  if (result != RequestResult::TIMED_OUT) {
+    if (result != RequestResult::CANCELLED)
+      link.consecutive_timeouts_ = 0;
+    return;
+  }
+
+  if (++link.consecutive_timeouts_ >= config_.max_timeouts && link.state_ == GatewayLinkState::ONLINE) {
+    link.consecutive_timeouts_ = 0;
+    link.reconnect_pending_ = true;
+  }
+}
+
+}  // namespace itp_packet
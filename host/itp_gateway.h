@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "itp_heatpumpstate.h"
+#include "itp_packetframer.h"
+#include "itp_pollscheduler.h"
+#include "itp_requestengine.h"
+
+namespace itp_packet {
+
+struct GatewayConfig {
+  RequestEngineConfig engine;        // Window, timeout and retries for every link's requests
+  PollSchedulerConfig poll;          // Baud rate and bus budget for every link's polling
+  uint32_t reconnect_ms = 2000;      // Delay before retrying a failed connect, or reopening a lost device
+  uint32_t max_timeouts = 3;         // Consecutive timed-out polls after which a link reconnects
+  uint32_t tick_ms = 10;             // How often every link's timers are serviced
+  bool configure_serial = true;      // Set tty devices to the ITP line settings (baud_rate, 8E1, raw)
+  bool request_capabilities = true;  // Request the unit's capabilities once connected
+};
+
+enum class GatewayLinkState : uint8_t {
+  CLOSED,      // The device isn't open; it is reopened after reconnect_ms
+  CONNECTING,  // Waiting for the unit to answer a connect request
+  ONLINE,      // Connected and polling
+};
+
+const char *gateway_link_state_name(GatewayLinkState state);
+
+// Counters describing one link's traffic since it was added (or the last reset_stats())
+struct GatewayLinkStats {
+  uint64_t bytes_received = 0;
+  uint64_t bytes_sent = 0;
+  uint32_t frames_received = 0;   // Checksum-valid frames, whether or not they answered a request
+  uint32_t unmatched_frames = 0;  // Frames that didn't answer one of our requests
+  uint32_t connects = 0;          // Successful connect handshakes
+  uint32_t reconnects = 0;        // Times the link went back to connecting after max_timeouts timeouts
+  uint32_t reopens = 0;           // Times the device was reopened after being lost
+  uint32_t write_stalls = 0;      // Writes that found the device full and waited for it to drain
+  uint32_t write_overflows = 0;   // Frames dropped because the write buffer was full (their requests are retried)
+};
+
+/* One serial link of a Gateway: an open device with its own framer, request engine (and so its own sequence space
+and in-flight window), poll scheduler, decoded state and stats.  Everything is held in fixed-size storage, so a link
+costs the same memory however busy it is; the gateway's own callbacks are small enough for std::function's inline
+storage, so connecting and polling never allocate (callbacks passed to Gateway::submit() may, if they capture more than
+two pointers).  Links are created by Gateway::add_link() and only accessed through the Gateway.
+*/
+class GatewayLink {
+ public:
+  // Bytes of frames waiting for the device to accept them; enough for a full window of requests
+  static const size_t WRITE_BUFFER_SIZE = 256;
+  static const size_t NAME_SIZE = 64;
+
+  GatewayLink(const GatewayLink &) = delete;
+  GatewayLink &operator=(const GatewayLink &) = delete;
+  ~GatewayLink();
+
+  const char *get_name() const { return name_; }
+  int get_fd() const { return fd_; }
+  GatewayLinkState get_state() const { return state_; }
+
+  // The unit's state, from the responses received on this link.  Snapshots may be taken from any thread.
+  const HeatPumpStateStore &get_heat_pump_state() const { return heat_pump_state_; }
+
+  const GatewayLinkStats &get_stats() const { return stats_; }
+  const RequestEngineStats &get_engine_stats() const { return engine_.get_stats(); }
+  const TransactionTracker &get_tracker() const { return engine_.get_tracker(); }
+  const PollSchedulerStats &get_poll_stats() const { return scheduler_.get_stats(); }
+  const PacketFramerStats &get_framer_stats() const { return framer_.get_stats(); }
+  void reset_stats();
+
+ private:
+  friend class Gateway;
+
+  GatewayLink(class Gateway &gateway, size_t index, const char *name, bool reopen, uint32_t now_ms);
+
+  Gateway &gateway_;
+  size_t index_;
+  char name_[NAME_SIZE] = {};
+  bool reopen_;  // Whether name is a device to reopen when it's lost (false for adopted descriptors)
+  int fd_ = -1;
+  GatewayLinkState state_ = GatewayLinkState::CLOSED;
+  uint32_t retry_at_ms_ = 0;
+  uint32_t consecutive_timeouts_ = 0;
+  bool connect_pending_ = false;
+  bool want_write_ = false;         // EPOLLOUT is registered
+  bool lost_ = false;               // The device failed; closed on the next service, outside any engine callback
+  bool reconnect_pending_ = false;  // Too many timeouts; reconnects on the next service
+
+  PacketFramer framer_;
+  RequestEngine engine_;
+  PollScheduler scheduler_;
+  HeatPumpStateStore heat_pump_state_;
+
+  uint8_t write_buffer_[WRITE_BUFFER_SIZE];
+  size_t write_length_ = 0;
+
+  GatewayLinkStats stats_;
+};
+
+// Called with every frame received on any link (e.g. to record a capture), after the link has processed it
+using GatewayFrameHandler = std::function<void(GatewayLink &link, const RawPacketView &frame, uint32_t now_ms)>;
+
+/* Drives any number of ITP links (UARTs, RS-485 adapters or ptys) from one thread, so a gateway can serve hundreds
+of indoor units from a single process instead of one process per unit.
+
+Each link connects to its unit, then polls it through its own PollScheduler and RequestEngine, decoding every
+response into its HeatPumpStateStore.  Requests from the integrator (e.g. settings changes) share the link's window
+through submit().  A link that stops answering reconnects after max_timeouts consecutive timeouts, and a device that
+disappears (e.g. a USB adapter unplugged) is reopened every reconnect_ms.
+
+All descriptors are non-blocking and multiplexed on one epoll(7) instance; frames that a device can't accept at once
+wait in the link's write buffer until it signals EPOLLOUT.  Every tick_ms, all links' timers (retries, polls,
+reconnects) are serviced.  Times are milliseconds from a monotonic clock, starting at construction.
+
+The gateway is not thread-safe: add_link(), submit() and run_once() must be called from the same thread, which is
+also the thread callbacks run on.  Heat pump state snapshots may be taken from any thread.
+*/
+class Gateway {
+ public:
+  Gateway(GatewayConfig config = {});
+  Gateway(const Gateway &) = delete;
+  Gateway &operator=(const Gateway &) = delete;
+  ~Gateway();
+
+  // Creates the epoll instance.  Returns false and sets errno on failure.
+  bool open();
+  // Closes every link and the epoll instance
+  void close();
+
+  // Opens device_path and adds a link for it, returning the link's index, or -1 (setting errno) if the device can't
+  // be opened.  The device is reopened whenever it's lost.
+  int add_link(const char *device_path);
+  // Adds a link for an already-open descriptor (which the gateway takes ownership of and makes non-blocking).  name
+  // is only used in reports; the link is not reopened if the descriptor fails.
+  int adopt_link(int fd, const char *name);
+
+  size_t get_link_count() const { return links_.size(); }
+  GatewayLink &get_link(size_t index) { return *links_[index]; }
+  const GatewayLink &get_link(size_t index) const { return *links_[index]; }
+
+  // Queues a request on a link, as RequestEngine::submit().  Returns false if the link isn't online or its queue is
+  // full, in which case the callback is not called.
+  bool submit(size_t index, const Packet &request, RequestCallback callback = nullptr);
+
+  void set_frame_handler(GatewayFrameHandler handler) { frame_handler_ = std::move(handler); }
+
+  // Waits up to timeout_ms for link activity, handles it, and services timers when a tick is due.  Returns the number
+  // of descriptors that were ready.
+  int run_once(int timeout_ms);
+  // Runs until stop is set
+  void run(const std::atomic<bool> &stop);
+
+  // Milliseconds since construction
+  uint32_t now_ms() const;
+
+ private:
+  friend class GatewayLink;
+
+  GatewayConfig config_;
+  int epoll_fd_ = -1;
+  std::vector<std::unique_ptr<GatewayLink>> links_;
+  GatewayFrameHandler frame_handler_;
+  int64_t start_ns_;
+  uint32_t current_ms_ = 0;  // now_ms() as of the latest wakeup, for request callbacks
+  uint32_t next_tick_ms_ = 0;
+
+  int add_link_(int fd, const char *name, bool reopen);
+  bool open_device_(GatewayLink &link);
+  void close_device_(GatewayLink &link, uint32_t now_ms);
+  // Registers a newly opened descriptor (EPOLL_CTL_ADD), or turns EPOLLOUT on or off for it (EPOLL_CTL_MOD)
+  bool watch_(GatewayLink &link, int op, bool want_write);
+
+  void on_readable_(GatewayLink &link, uint32_t now_ms);
+  void on_writable_(GatewayLink &link);
+  void handle_frame_(GatewayLink &link, const RawPacketView &frame, uint32_t now_ms);
+  void send_(GatewayLink &link, const RawPacketView &frame);
+  bool flush_(GatewayLink &link);
+  // Advances a link's connection, retries and polling
+  void service_(GatewayLink &link, uint32_t now_ms);
+  void connect_(GatewayLink &link, uint32_t now_ms);
+  void on_request_result_(GatewayLink &link, RequestResult result);
+};
+
+}  // namespace itp_packet
@@ -0,0 +1,397 @@
+#include "itp_heatpumpemulator.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
+#include "itp_pty.h"
+
+namespace itp_packet {
+
+// Capabilities reported by the emulated unit (taken from a capture of a real one): vane and swing supported,
+// 16-31 °C cool/dry and heat setpoints, 17-30 °C auto setpoints
+static const uint8_t CAPABILITIES_PAYLOAD[16] = {0xc9, 0x03, 0x10, 0x00, 0x00, 0x00, 0x00, 0x60,
+                                                 0x04, 0x01, 0xa0, 0xbe, 0xa0, 0xbe, 0xa2, 0xbc};
+
+// Function settings (one code and its setting per byte), as the emulated unit reports them: the first page is taken
+// from a capture of a real unit; the second reports codes 116-130 at setting 1
+static const uint8_t FUNCTIONS_1_PAYLOAD[16] = {0x20, 0x05, 0x0a, 0x0d, 0x11, 0x16, 0x1a, 0x1d,
+                                                0x22, 0x26, 0x2a, 0x2d, 0x31, 0x36, 0x3a, 0x3d};
+static const uint8_t FUNCTIONS_2_PAYLOAD[16] = {0x22, 0x41, 0x45, 0x49, 0x4d, 0x51, 0x55, 0x59,
+                                                0x5d, 0x61, 0x65, 0x69, 0x6d, 0x71, 0x75, 0x79};
+
+static const uint8_t SET_RESULT_REFUSED = 0x01;
+
+// Delay before retrying a response the pty wouldn't take (nothing is reading it)
+static const uint32_t WRITE_RETRY_MS = 10;
+
+// How fast the simulated room responds: a tenth of a degree every this many seconds
+static const uint32_t SECONDS_PER_DECI_C = 10;
+
+bool HeatPumpEmulator::open() {
+  close();
+  if (!open_pty(master_fd_, slave_fd_, device_path_, sizeof(device_path_)))
+    return false;
+
+  framer_.reset();
+  connected_ = false;
+  pending_count_ = 0;
+  written_ = 0;
+  write_blocked_ = false;
+  return true;
+}
+
+void HeatPumpEmulator::close() {
+  if (slave_fd_ >= 0)
+    ::close(slave_fd_);
+  if (master_fd_ >= 0)
+    ::close(master_fd_);
+  slave_fd_ = -1;
+  master_fd_ = -1;
+  device_path_[0] = '\0';
+}
+
+void HeatPumpEmulator::on_readable(uint32_t now_ms) {
+  uint8_t buffer[256];
+  while (master_fd_ >= 0) {
+    ssize_t received = ::read(master_fd_, buffer, sizeof(buffer));
+    if (received <= 0) {
+      if (received < 0 && errno == EINTR)
+        continue;
+      return;
+    }
+    framer_.feed_views(buffer, received, [this, now_ms](const RawPacketView &frame) { handle_frame_(frame, now_ms); });
+  }
+}
+
+void HeatPumpEmulator::poll(uint32_t now_ms) {
+  if (!simulation_started_) {
+    simulation_started_ = true;
+    simulated_ms_ = now_ms;
+  }
+  while ((int32_t) (now_ms - simulated_ms_) >= 1000) {
+    simulated_ms_ += 1000;
+    step_();
+  }
+
+  while (pending_count_ > 0 && master_fd_ >= 0) {
+    PendingResponse &response = pending_[pending_head_];
+    if ((int32_t) (now_ms - response.due_ms) < 0 || (write_blocked_ && (int32_t) (now_ms - write_retry_ms_) < 0))
+      return;
+
+    ssize_t written = ::write(master_fd_, response.bytes + written_, response.length - written_);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      // E.g. EAGAIN while nothing is reading the pty; the unwritten rest is retried after a pause
+      write_blocked_ = true;
+      write_retry_ms_ = now_ms + WRITE_RETRY_MS;
+      return;
+    }
+    write_blocked_ = false;
+    written_ += written;
+    if (written_ < response.length)
+      return;
+
+    stats_.responses++;
+    written_ = 0;
+    pending_head_ = (pending_head_ + 1) % MAX_PENDING_RESPONSES;
+    pending_count_--;
+  }
+}
+
+uint32_t HeatPumpEmulator::get_next_due_ms(uint32_t now_ms) const {
+  if (pending_count_ == 0)
+    return UINT32_MAX;
+  int32_t remaining = (int32_t) (pending_[pending_head_].due_ms - now_ms);
+  if (write_blocked_ && (int32_t) (write_retry_ms_ - now_ms) > remaining)
+    remaining = (int32_t) (write_retry_ms_ - now_ms);
+  return remaining > 0 ? remaining : 0;
+}
+
+bool HeatPumpEmulator::chance_(float rate) {
+  return rate > 0 && std::uniform_real_distribution<float>(0, 1)(rng_) < rate;
+}
+
+void HeatPumpEmulator::handle_frame_(const RawPacketView &frame, uint32_t now_ms) {
+  stats_.requests++;
+  PacketType type = static_cast<PacketType>(frame.get_packet_type());
+
+  if (type != PacketType::CONNECT_REQUEST && !connected_ && config_.require_connect) {
+    stats_.ignored++;
+    return;
+  }
+  if (chance_(config_.drop_rate)) {
+    stats_.dropped++;
+    return;
+  }
+
+  switch (type) {
+    case PacketType::CONNECT_REQUEST: {
+      connected_ = true;
+      respond_(RawPacket(PacketType::CONNECT_RESPONSE, 1), now_ms);
+      break;
+    }
+    case PacketType::IDENTIFY_REQUEST: {
+      if (frame.get_command() != CAPABILITIES_PAYLOAD[0]) {
+        stats_.ignored++;
+        break;
+      }
+      RawPacket response(PacketType::IDENTIFY_RESPONSE, sizeof(CAPABILITIES_PAYLOAD));
+      response.set_payload_bytes(0, CAPABILITIES_PAYLOAD, sizeof(CAPABILITIES_PAYLOAD));
+      respond_(response, now_ms);
+      break;
+    }
+    case PacketType::GET_REQUEST:
+      handle_get_(static_cast<GetCommand>(frame.get_command()), now_ms);
+      break;
+    case PacketType::SET_REQUEST:
+      handle_set_(frame, now_ms);
+      break;
+    default:
+      stats_.ignored++;
+      break;
+  }
+}
+
+void HeatPumpEmulator::handle_get_(GetCommand command, uint32_t now_ms) {
+  RawPacket response(PacketType::GET_RESPONSE, 16);
+  response.set_payload_byte(0, static_cast<uint8_t>(command));
+
+  switch (command) {
+    case GetCommand::SETTINGS: {
+      response.set_payload_byte(SettingsGetResponseView::PLINDEX_POWER, state_.power);
+      response.set_payload_byte(SettingsGetResponseView::PLINDEX_MODE, state_.mode);
+      response.set_payload_byte(SettingsGetResponseView::PLINDEX_TARGETTEMP_LEGACY,
+                                ITPUtils::deci_c_to_legacy_target_temp(state_.target_deci_c));
+      response.set_payload_byte(SettingsGetResponseView::PLINDEX_FAN, state_.fan);
+      response.set_payload_byte(SettingsGetResponseView::PLINDEX_VANE, state_.vane);
+      response.set_payload_byte(SettingsGetResponseView::PLINDEX_HVANE, state_.horizontal_vane);
+      response.set_payload_byte(SettingsGetResponseView::PLINDEX_TARGETTEMP,
+                                ITPUtils::deci_c_to_temp_scale_a(state_.target_deci_c));
+      break;
+    }
+    case GetCommand::CURRENT_TEMP: {
+      int16_t room_deci_c = state_.remote_deci_c != ITPUtils::DECI_C_UNAVAILABLE ? state_.remote_deci_c
+                                                                                  : state_.room_deci_c;
+      response.set_payload_byte(CurrentTempGetResponseView::PLINDEX_CURRENTTEMP_LEGACY,
+                                ITPUtils::deci_c_to_legacy_hp_room_temp(room_deci_c));
+      if (state_.outdoor_deci_c != ITPUtils::DECI_C_UNAVAILABLE)
+        response.set_payload_byte(CurrentTempGetResponseView::PLINDEX_OUTDOORTEMP,
+                                  ITPUtils::deci_c_to_temp_scale_a(state_.outdoor_deci_c));
+      response.set_payload_byte(CurrentTempGetResponseView::PLINDEX_CURRENTTEMP,
+                                ITPUtils::deci_c_to_temp_scale_a(room_deci_c));
+      response.set_payload_byte(CurrentTempGetResponseView::PLINDEX_RUNTIME, state_.runtime_minutes >> 16);
+      response.set_payload_byte(CurrentTempGetResponseView::PLINDEX_RUNTIME + 1, state_.runtime_minutes >> 8);
+      response.set_payload_byte(CurrentTempGetResponseView::PLINDEX_RUNTIME + 2, state_.runtime_minutes);
+      break;
+    }
+    case GetCommand::STATUS: {
+      uint16_t lifetime_deci_kwh = state_.lifetime_wh / 100;
+      response.set_payload_byte(StatusGetResponseView::PLINDEX_COMPRESSOR_FREQUENCY, state_.compressor_frequency);
+      response.set_payload_byte(StatusGetResponseView::PLINDEX_OPERATING, state_.compressor_frequency > 0);
+      response.set_payload_byte(StatusGetResponseView::PLINDEX_INPUT_WATTS, state_.input_watts >> 8);
+      response.set_payload_byte(StatusGetResponseView::PLINDEX_INPUT_WATTS + 1, state_.input_watts);
+      response.set_payload_byte(StatusGetResponseView::PLINDEX_LIFETIME_KWH, lifetime_deci_kwh >> 8);
+      response.set_payload_byte(StatusGetResponseView::PLINDEX_LIFETIME_KWH + 1, lifetime_deci_kwh);
+      break;
+    }
+    case GetCommand::RUN_STATE: {
+      // Actual fan speeds are numbered differently from the fan setting
+      uint8_t actual_fan = 0;
+      if (state_.power) {
+        switch (state_.fan) {
+          case SettingsSetRequestPacket::FAN_QUIET:
+            actual_fan = 6;
+            break;
+          case SettingsSetRequestPacket::FAN_1:
+            actual_fan = 1;
+            break;
+          case SettingsSetRequestPacket::FAN_2:
+            actual_fan = 2;
+            break;
+          case SettingsSetRequestPacket::FAN_3:
+            actual_fan = 3;
+            break;
+          case SettingsSetRequestPacket::FAN_4:
+            actual_fan = 4;
+            break;
+          default:
+            actual_fan = state_.compressor_frequency > 0 ? 3 : 1;
+            break;
+        }
+      }
+      response.set_payload_byte(RunStateGetResponseView::PLINDEX_STATUSFLAGS, state_.power ? 0x00 : 0x08);
+      response.set_payload_byte(RunStateGetResponseView::PLINDEX_ACTUALFAN, actual_fan);
+      break;
+    }
+    case GetCommand::ERROR_INFO: {
+      response.set_payload_byte(ErrorStateGetResponseView::PLINDEX_ERROR_CODE, state_.error_code >> 8);
+      response.set_payload_byte(ErrorStateGetResponseView::PLINDEX_ERROR_CODE + 1, state_.error_code);
+      response.set_payload_byte(ErrorStateGetResponseView::PLINDEX_SHORT_CODE, state_.error_short_code);
+      break;
+    }
+    case GetCommand::FUNCTIONS_1:
+      response.set_payload_bytes(0, FUNCTIONS_1_PAYLOAD, sizeof(FUNCTIONS_1_PAYLOAD));
+      break;
+    case GetCommand::FUNCTIONS_2:
+      response.set_payload_bytes(0, FUNCTIONS_2_PAYLOAD, sizeof(FUNCTIONS_2_PAYLOAD));
+      break;
+    default:
+      // Anything else (e.g. a thermostat's GETs) gets a well-formed response with an empty payload, as a unit
+      // with nothing to report would send
+      break;
+  }
+  respond_(response, now_ms);
+}
+
+void HeatPumpEmulator::handle_set_(const RawPacketView &frame, uint32_t now_ms) {
+  SetResponsePacket response;
+  if (chance_(config_.set_failure_rate)) {
+    stats_.sets_refused++;
+    response.raw_packet().set_payload_byte(0, SET_RESULT_REFUSED);
+    respond_(response.raw_packet(), now_ms);
+    return;
+  }
+
+  switch (static_cast<SetCommand>(frame.get_command())) {
+    case SetCommand::SETTINGS: {
+      SettingsSetRequestPacket request(frame.to_raw_packet());
+      uint8_t flags = request.get_flags();
+      if (flags & SettingsSetRequestPacket::SF_POWER)
+        state_.power = request.get_power();
+      if (flags & SettingsSetRequestPacket::SF_MODE)
+        state_.mode = request.get_mode();
+      if (flags & SettingsSetRequestPacket::SF_TARGET_TEMPERATURE)
+        state_.target_deci_c = request.get_target_temp_deci_c();
+      if (flags & SettingsSetRequestPacket::SF_FAN)
+        state_.fan = request.get_fan();
+      if (flags & SettingsSetRequestPacket::SF_VANE)
+        state_.vane = request.get_vane();
+      if (request.get_flags_2() & SettingsSetRequestPacket::SF2_HORIZONTAL_VANE)
+        state_.horizontal_vane = request.get_horizontal_vane();
+      stats_.sets_applied++;
+      break;
+    }
+    case SetCommand::REMOTE_TEMPERATURE: {
+      RemoteTemperatureSetRequestPacket request(frame.to_raw_packet());
+      state_.remote_deci_c = request.get_use_internal_temperature() ? ITPUtils::DECI_C_UNAVAILABLE
+                                                                    : request.get_remote_temperature_deci_c();
+      stats_.sets_applied++;
+      break;
+    }
+    default:
+      // Anything else (e.g. a filter reset) is acknowledged without effect
+      break;
+  }
+  respond_(response.raw_packet(), now_ms);
+}
+
+void HeatPumpEmulator::respond_(const RawPacket &response, uint32_t now_ms) {
+  if (pending_count_ == MAX_PENDING_RESPONSES) {
+    stats_.overflows++;
+    return;
+  }
+
+  uint32_t delay = config_.latency_ms;
+  if (config_.jitter_ms > 0)
+    delay += std::uniform_int_distribution<uint32_t>(0, config_.jitter_ms)(rng_);
+  // A serial line can't reorder, so jitter never lets a response overtake an earlier one
+  uint32_t due_ms = now_ms + delay;
+  if (pending_count_ > 0 && (int32_t) (due_ms - last_due_ms_) < 0)
+    due_ms = last_due_ms_;
+  last_due_ms_ = due_ms;
+
+  PendingResponse &slot = pending_[(pending_head_ + pending_count_) % MAX_PENDING_RESPONSES];
+  slot.due_ms = due_ms;
+  slot.length = response.get_length();
+  memcpy(slot.bytes, response.get_bytes(), slot.length);
+  if (chance_(config_.corrupt_rate)) {
+    slot.bytes[slot.length - 1] ^= 0x55;
+    stats_.corrupted++;
+  }
+  pending_count_++;
+}
+
+void HeatPumpEmulator::step_() {
+  simulated_seconds_++;
+  int16_t sensed_deci_c = state_.remote_deci_c != ITPUtils::DECI_C_UNAVAILABLE ? state_.remote_deci_c
+                                                                              : state_.room_deci_c;
+  int16_t demand = 0;  // +1 to heat, -1 to cool
+  if (state_.power) {
+    switch (state_.mode) {
+      case SettingsSetRequestPacket::MODE_BYTE_HEAT:
+        demand = sensed_deci_c < state_.target_deci_c ? 1 : 0;
+        break;
+      case SettingsSetRequestPacket::MODE_BYTE_COOL:
+      case SettingsSetRequestPacket::MODE_BYTE_DRY:
+        demand = sensed_deci_c > state_.target_deci_c ? -1 : 0;
+        break;
+      case SettingsSetRequestPacket::MODE_BYTE_AUTO:
+        demand = sensed_deci_c < state_.target_deci_c ? 1 : sensed_deci_c > state_.target_deci_c ? -1 : 0;
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (demand != 0) {
+    // The compressor works harder the further the room is from the target
+    int error = abs(sensed_deci_c - state_.target_deci_c);
+    state_.compressor_frequency = error > 80 ? 100 : 20 + error;
+    state_.input_watts = state_.compressor_frequency * 12;
+  } else {
+    state_.compressor_frequency = 0;
+    state_.input_watts = state_.power ? 20 : 0;  // The indoor fan alone
+  }
+
+  if (simulated_seconds_ % SECONDS_PER_DECI_C == 0) {
+    if (demand != 0) {
+      state_.room_deci_c += demand;
+    } else if (!state_.power && state_.room_deci_c != state_.ambient_deci_c) {
+      state_.room_deci_c += state_.room_deci_c < state_.ambient_deci_c ? 1 : -1;
+    }
+  }
+
+  energy_ws_ += state_.input_watts;
+  state_.lifetime_wh = energy_ws_ / 3600;
+  if (state_.power && simulated_seconds_ % 60 == 0)
+    state_.runtime_minutes++;
+}
+
+void run_heat_pump_emulators(HeatPumpEmulator *const *emulators, size_t count, const std::atomic<bool> &stop) {
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+  std::vector<pollfd> fds(count);
+  for (size_t i = 0; i < count; i++) {
+    fds[i].fd = emulators[i]->get_fd();
+    fds[i].events = POLLIN;
+  }
+
+  while (!stop.load(std::memory_order_relaxed)) {
+    uint32_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+    // Wake at least every 100 ms so the simulation advances and stop is noticed
+    uint32_t timeout_ms = 100;
+    for (size_t i = 0; i < count; i++) {
+      uint32_t due_ms = emulators[i]->get_next_due_ms(now_ms);
+      if (due_ms < timeout_ms)
+        timeout_ms = due_ms;
+    }
+
+    int ready = ::poll(fds.data(), fds.size(), timeout_ms);
+    if (ready < 0 && errno != EINTR)
+      return;
+
+    now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+    for (size_t i = 0; i < count; i++) {
+      if (ready > 0 && (fds[i].revents & POLLIN))
+        emulators[i]->on_readable(now_ms);
+      emulators[i]->poll(now_ms);
+    }
+  }
+}
+
+}  // namespace itp_packet
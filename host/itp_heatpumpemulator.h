@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <random>
+#include <stddef.h>
+#include <stdint.h>
+#include "itp_packetframer.h"
+#include "itp_packets.h"
+
+namespace itp_packet {
+
+struct HeatPumpEmulatorConfig {
+  uint32_t latency_ms = 10;     // Delay between a request arriving and its response being written
+  uint32_t jitter_ms = 0;       // Extra random delay, uniform in [0, jitter_ms]
+  float drop_rate = 0;          // Fraction of requests that get no response at all
+  float corrupt_rate = 0;       // Fraction of responses sent with a bad checksum
+  float set_failure_rate = 0;   // Fraction of set requests that are refused (and not applied)
+  bool require_connect = true;  // Ignore everything but a connect request until one has been answered
+  uint32_t seed = 1;            // Seeds the random number generator behind jitter and error injection
+};
+
+// The simulated unit.  Temperatures are in tenths of a degree; settings use the wire encodings.
+struct EmulatedHeatPumpState {
+  uint8_t power = 0;
+  uint8_t mode = SettingsSetRequestPacket::MODE_BYTE_COOL;
+  int16_t target_deci_c = 220;
+  uint8_t fan = SettingsSetRequestPacket::FAN_AUTO;
+  uint8_t vane = SettingsSetRequestPacket::VANE_AUTO;
+  uint8_t horizontal_vane = SettingsSetRequestPacket::HV_CENTER;
+
+  int16_t room_deci_c = 250;
+  int16_t outdoor_deci_c = 300;
+  int16_t remote_deci_c = ITPUtils::DECI_C_UNAVAILABLE;  // Set by remote temperature requests; replaces room_deci_c
+  int16_t ambient_deci_c = 250;  // What the room drifts towards while the unit is off
+
+  uint16_t error_code = 0x8000;  // 0x8000 means no error
+  uint8_t error_short_code = 0;
+  uint32_t runtime_minutes = 0;
+  uint32_t lifetime_wh = 0;
+  uint8_t compressor_frequency = 0;
+  uint16_t input_watts = 0;
+};
+
+// Counters describing an emulator's activity since construction (or the last reset_stats()).
+struct HeatPumpEmulatorStats {
+  uint32_t requests = 0;      // Valid frames received
+  uint32_t responses = 0;     // Responses written
+  uint32_t ignored = 0;       // Requests not answered because they arrived before a connect, or aren't emulated
+  uint32_t dropped = 0;       // Requests deliberately not answered (drop_rate)
+  uint32_t corrupted = 0;     // Responses deliberately sent with a bad checksum (corrupt_rate)
+  uint32_t sets_applied = 0;  // Settings and remote temperature requests applied
+  uint32_t sets_refused = 0;  // Set requests deliberately refused (set_failure_rate)
+  uint32_t overflows = 0;     // Responses discarded because too many were waiting to be written
+};
+
+/* Emulates an indoor unit on a pseudo-terminal, for testing anything that talks ITP without hardware.  open() creates
+a pty; point the software under test at get_device_path() as though it were the unit's serial port.
+
+The emulator answers the connect handshake, the capabilities request, every GET request (the function pages with
+fixed settings, and commands it doesn't model with an empty payload), and settings, remote temperature and run state
+SET requests.  Settings, current temperature, status, run state and error responses come from a simple simulation:
+while powered, the room temperature moves towards the target by a tenth of a degree every ten seconds (drifting
+towards ambient_deci_c while off), and the compressor, input power, runtime and energy figures follow.  Responses
+are written after latency_ms plus up to jitter_ms, in the order the requests arrived; drop_rate, corrupt_rate and
+set_failure_rate inject faults.
+
+Nothing here blocks or spawns threads: call on_readable() when get_fd() is readable and poll() regularly (at least
+as often as the shortest latency), so one thread can drive hundreds of emulators (see run_heat_pump_emulators()).
+*/
+class HeatPumpEmulator {
+ public:
+  static const size_t MAX_PENDING_RESPONSES = 8;
+
+  HeatPumpEmulator(HeatPumpEmulatorConfig config = {}) : config_{config}, rng_{config.seed} {}
+  HeatPumpEmulator(const HeatPumpEmulator &) = delete;
+  HeatPumpEmulator &operator=(const HeatPumpEmulator &) = delete;
+  ~HeatPumpEmulator() { close(); }
+
+  // Creates the pty.  Returns false and sets errno on failure.
+  bool open();
+  void close();
+  bool is_open() const { return master_fd_ >= 0; }
+
+  // The pty's device (e.g. /dev/pts/7), for the software under test to open
+  const char *get_device_path() const { return device_path_; }
+  // The non-blocking descriptor to wait on for readability
+  int get_fd() const { return master_fd_; }
+
+  // Reads and handles everything received so far
+  void on_readable(uint32_t now_ms);
+  // Advances the simulation and writes every response that is due
+  void poll(uint32_t now_ms);
+  // Milliseconds until the next response is due (0 if one is overdue), or UINT32_MAX if none is waiting
+  uint32_t get_next_due_ms(uint32_t now_ms) const;
+
+  // Forgets the handshake, as though the unit had been power cycled
+  void disconnect() { connected_ = false; }
+  bool is_connected() const { return connected_; }
+
+  // The simulated unit, which can be changed at any time (e.g. to raise an error code)
+  EmulatedHeatPumpState &get_state() { return state_; }
+  const EmulatedHeatPumpState &get_state() const { return state_; }
+
+  const HeatPumpEmulatorStats &get_stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+  const PacketFramerStats &get_framer_stats() const { return framer_.get_stats(); }
+
+ private:
+  struct PendingResponse {
+    uint32_t due_ms;
+    uint8_t length;
+    uint8_t bytes[PACKET_MAX_SIZE];
+  };
+
+  HeatPumpEmulatorConfig config_;
+  std::minstd_rand rng_;
+  int master_fd_ = -1;
+  int slave_fd_ = -1;  // Held open so the master never sees a hangup between clients
+  char device_path_[64] = {};
+
+  PacketFramer framer_{SourceBridge::HEATPUMP, ControllerAssociation::MITP};
+  bool connected_ = false;
+  EmulatedHeatPumpState state_;
+  bool simulation_started_ = false;
+  uint32_t simulated_ms_ = 0;  // Time the simulation has been advanced to
+  uint32_t simulated_seconds_ = 0;
+  uint64_t energy_ws_ = 0;  // Lifetime energy in watt-seconds, behind state_.lifetime_wh
+
+  PendingResponse pending_[MAX_PENDING_RESPONSES];
+  size_t pending_head_ = 0;
+  size_t pending_count_ = 0;
+  uint8_t written_ = 0;         // Bytes of the oldest pending response already written
+  bool write_blocked_ = false;  // The pty refused the last write; the rest is retried at write_retry_ms_
+  uint32_t write_retry_ms_ = 0;
+  uint32_t last_due_ms_ = 0;
+
+  HeatPumpEmulatorStats stats_;
+
+  bool chance_(float rate);
+  void handle_frame_(const RawPacketView &frame, uint32_t now_ms);
+  void handle_get_(GetCommand command, uint32_t now_ms);
+  void handle_set_(const RawPacketView &frame, uint32_t now_ms);
+  void respond_(const RawPacket &response, uint32_t now_ms);
+  // Advances the simulation by one second
+  void step_();
+};
+
+// Drives emulators from the calling thread until stop is set, waiting on all of them with poll(2)
+void run_heat_pump_emulators(HeatPumpEmulator *const *emulators, size_t count, const std::atomic<bool> &stop);
+
+}  // namespace itp_packet
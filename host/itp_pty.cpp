@@ -0,0 +1,39 @@
+#include "itp_pty.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace itp_packet {
+
+bool open_pty(int &master_fd, int &slave_fd, char *device_path, size_t device_path_size) {
+  master_fd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+  slave_fd = -1;
+  if (master_fd < 0)
+    return false;
+
+  struct termios tio;
+  bool opened = grantpt(master_fd) == 0 && unlockpt(master_fd) == 0 &&
+                ptsname_r(master_fd, device_path, device_path_size) == 0 &&
+                (slave_fd = ::open(device_path, O_RDWR | O_NOCTTY | O_CLOEXEC)) >= 0 && tcgetattr(slave_fd, &tio) == 0;
+  if (opened) {
+    cfmakeraw(&tio);
+    opened = tcsetattr(slave_fd, TCSANOW, &tio) == 0 &&
+             fcntl(master_fd, F_SETFL, fcntl(master_fd, F_GETFL) | O_NONBLOCK) == 0;
+  }
+  if (!opened) {
+    int error = errno;
+    if (slave_fd >= 0)
+      ::close(slave_fd);
+    ::close(master_fd);
+    master_fd = -1;
+    slave_fd = -1;
+    errno = error;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace itp_packet
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace itp_packet {
+
+// Creates a pseudo-terminal for an emulated device.  master_fd is non-blocking; slave_fd is set to raw mode (so bytes
+// pass through untouched, as on a UART) and should be held open for as long as the pty is used, so that the master
+// doesn't see a hangup whenever the software under test closes its end.  device_path receives the slave's path (e.g.
+// /dev/pts/7).  Returns false and sets errno on failure.
+bool open_pty(int &master_fd, int &slave_fd, char *device_path, size_t device_path_size);
+
+}  // namespace itp_packet
@@ -0,0 +1,118 @@
+#include "itp_replay.h"
+
+#include <cerrno>
+#include <vector>
+
+namespace itp_packet {
+
+const char *packet_kind_name(PacketKind kind) {
+  switch (kind) {
+    case PacketKind::CONNECT_REQUEST:
+      return "connect_request";
+    case PacketKind::CONNECT_RESPONSE:
+      return "connect_response";
+    case PacketKind::CAPABILITIES_REQUEST:
+      return "capabilities_request";
+    case PacketKind::CAPABILITIES_RESPONSE:
+      return "capabilities_response";
+    case PacketKind::IDENTIFY_CD_REQUEST:
+      return "identify_cd_request";
+    case PacketKind::IDENTIFY_CD_RESPONSE:
+      return "identify_cd_response";
+    case PacketKind::GET_REQUEST:
+      return "get_request";
+    case PacketKind::THERMOSTAT_STATE_DOWNLOAD_REQUEST:
+      return "thermostat_state_download_request";
+    case PacketKind::THERMOSTAT_AB_GET_REQUEST:
+      return "thermostat_ab_get_request";
+    case PacketKind::SETTINGS_GET_RESPONSE:
+      return "settings_get_response";
+    case PacketKind::CURRENT_TEMP_GET_RESPONSE:
+      return "current_temp_get_response";
+    case PacketKind::ERROR_STATE_GET_RESPONSE:
+      return "error_state_get_response";
+    case PacketKind::STATUS_GET_RESPONSE:
+      return "status_get_response";
+    case PacketKind::RUN_STATE_GET_RESPONSE:
+      return "run_state_get_response";
+    case PacketKind::FUNCTIONS_1_GET_RESPONSE:
+      return "functions_1_get_response";
+    case PacketKind::FUNCTIONS_2_GET_RESPONSE:
+      return "functions_2_get_response";
+    case PacketKind::THERMOSTAT_STATE_DOWNLOAD_RESPONSE:
+      return "thermostat_state_download_response";
+    case PacketKind::THERMOSTAT_AB_GET_RESPONSE:
+      return "thermostat_ab_get_response";
+    case PacketKind::SETTINGS_SET_REQUEST:
+      return "settings_set_request";
+    case PacketKind::REMOTE_TEMPERATURE_SET_REQUEST:
+      return "remote_temperature_set_request";
+    case PacketKind::THERMOSTAT_SENSOR_STATUS:
+      return "thermostat_sensor_status";
+    case PacketKind::THERMOSTAT_HELLO:
+      return "thermostat_hello";
+    case PacketKind::THERMOSTAT_STATE_UPLOAD:
+      return "thermostat_state_upload";
+    case PacketKind::THERMOSTAT_AA_SET_REQUEST:
+      return "thermostat_aa_set_request";
+    case PacketKind::SET_RESPONSE:
+      return "set_response";
+    default:
+      return "unknown";
+  }
+}
+
+void ReplayStats::merge(const ReplayStats &other) {
+  frames += other.frames;
+  accepted += other.accepted;
+  invalid += other.invalid;
+  handler_ns += other.handler_ns;
+  if (other.elapsed_ns > elapsed_ns)
+    elapsed_ns = other.elapsed_ns;
+  if (other.max_lag_us > max_lag_us)
+    max_lag_us = other.max_lag_us;
+  for (size_t i = 0; i < PACKET_KIND_COUNT; i++) {
+    kind_frames[i] += other.kind_frames[i];
+    kind_ns[i] += other.kind_ns[i];
+  }
+}
+
+void ReplayStats::format_to(PacketFormatter &out) const {
+  out.append("Frames: ").append_uint(frames).append(" (").append_uint(accepted).append(" handled, ");
+  out.append_uint(invalid).append(" invalid) in ").append_uint(elapsed_ns / 1000000).append(" ms => ");
+  out.append_uint((uint32_t) get_frames_per_second()).append(" frames/s");
+  if (max_lag_us > 0)
+    out.append(", max lag ").append_uint(max_lag_us).append(" us");
+
+  for (size_t i = 0; i < PACKET_KIND_COUNT; i++) {
+    if (kind_frames[i] == 0)
+      continue;
+    out.append("\n  ").append(packet_kind_name(static_cast<PacketKind>(i))).append(": ");
+    out.append_uint(kind_frames[i]).append(" frames, ");
+    out.append_uint(kind_ns[i] / kind_frames[i]).append(" ns/frame");
+  }
+}
+
+bool replay_parallel(ReplayJob *jobs, size_t count) {
+  std::vector<std::thread> threads;
+  threads.reserve(count);
+
+  for (size_t i = 0; i < count; i++) {
+    threads.emplace_back([job = &jobs[i]] {
+      CaptureReader reader;
+      job->opened = reader.open(job->path);
+      job->error = job->opened ? 0 : errno;
+      if (job->opened)
+        job->stats = replay_capture(reader, *job->processor, job->config);
+    });
+  }
+
+  bool all_opened = true;
+  for (size_t i = 0; i < count; i++) {
+    threads[i].join();
+    all_opened &= jobs[i].opened;
+  }
+  return all_opened;
+}
+
+}  // namespace itp_packet
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include "itp_capture.h"
+#include "itp_packetdispatch.h"
+#include "itp_packetformatter.h"
+#include "itp_packetprocessor.h"
+
+namespace itp_packet {
+
+static const size_t PACKET_KIND_COUNT = static_cast<size_t>(PacketKind::SET_RESPONSE) + 1;
+
+// A short name for a PacketKind, for reports
+const char *packet_kind_name(PacketKind kind);
+
+enum class ReplayMode {
+  FAST,   // Deliver frames back to back, to measure throughput
+  TIMED,  // Deliver frames with their recorded spacing (divided by speed), to reproduce behavior
+};
+
+struct ReplayConfig {
+  ReplayMode mode = ReplayMode::FAST;
+  double speed = 1.0;  // TIMED only: 10 replays an hour of traffic in six minutes
+  uint64_t begin_us = 0;           // Only frames recorded in [begin_us, end_us) are replayed
+  uint64_t end_us = UINT64_MAX;
+  bool skip_invalid = true;         // Skip frames whose checksum doesn't match
+  bool time_handlers = true;        // Time each handler call (costs two clock reads per frame)
+  const std::atomic<bool> *cancel = nullptr;  // Stops the replay early once set
+};
+
+// What a replay did and how long it took.  Per-kind figures are indexed by PacketKind.
+struct ReplayStats {
+  uint64_t frames = 0;     // Frames delivered to the handler
+  uint64_t accepted = 0;   // Frames the handler had an overload for
+  uint64_t invalid = 0;    // Frames skipped for a bad checksum
+  uint64_t elapsed_ns = 0;
+  uint64_t handler_ns = 0;  // Time spent inside the handler (if timed)
+  uint64_t max_lag_us = 0;  // TIMED only: furthest any frame was delivered behind schedule
+  uint64_t kind_frames[PACKET_KIND_COUNT] = {};
+  uint64_t kind_ns[PACKET_KIND_COUNT] = {};
+
+  double get_frames_per_second() const { return elapsed_ns > 0 ? frames * 1e9 / elapsed_ns : 0; }
+  // Adds another replay's figures to these (elapsed time is the longer of the two, as for parallel replays)
+  void merge(const ReplayStats &other);
+  // A multi-line summary: totals, then frames and mean handler time per packet kind
+  void format_to(PacketFormatter &out) const;
+};
+
+/* Replays captured traffic into a handler: each record in the capture is rebuilt as a RawPacket (with its original
+SourceBridge and ControllerAssociation), classified and passed to the handler through dispatch_packet(), exactly as
+live frames would be.  The handler can be a PacketProcessor or any type with process_packet() overloads.
+
+In FAST mode frames are delivered back to back, for throughput regression tests; in TIMED mode they keep their
+recorded spacing, sped up by config.speed, to reproduce timing-dependent behavior without a unit.
+*/
+template<typename Handler>
+ReplayStats replay_capture(const CaptureReader &capture, Handler &handler, const ReplayConfig &config = {}) {
+  using Clock = std::chrono::steady_clock;
+  ReplayStats stats;
+
+  uint64_t begin = capture.find_time(config.begin_us);
+  uint64_t end = config.end_us == UINT64_MAX ? capture.size() : capture.find_time(config.end_us);
+  if (begin >= end)
+    return stats;
+
+  const Clock::time_point start = Clock::now();
+  const uint64_t first_us = capture[begin].timestamp_us;
+  const double speed = config.speed > 0 ? config.speed : 1.0;
+
+  for (uint64_t position = begin; position < end; position++) {
+    const CaptureRecord &record = capture[position];
+    if (config.cancel != nullptr && config.cancel->load(std::memory_order_relaxed))
+      break;
+
+    RawPacketView frame = record.view();
+    if (config.skip_invalid && !frame.is_checksum_valid()) {
+      stats.invalid++;
+      continue;
+    }
+
+    if (config.mode == ReplayMode::TIMED) {
+      auto due = start + std::chrono::nanoseconds((uint64_t) ((record.timestamp_us - first_us) * 1000 / speed));
+      Clock::time_point now = Clock::now();
+      if (now < due) {
+        std::this_thread::sleep_until(due);
+      } else {
+        uint64_t lag_us = std::chrono::duration_cast<std::chrono::microseconds>(now - due).count();
+        if (lag_us > stats.max_lag_us)
+          stats.max_lag_us = lag_us;
+      }
+    }
+
+    size_t kind = static_cast<size_t>(classify_packet(frame.get_packet_type(), frame.get_command()));
+    RawPacket pkt = frame.to_raw_packet(record.get_source_bridge(), record.get_controller_association());
+
+    if (config.time_handlers) {
+      Clock::time_point before = Clock::now();
+      stats.accepted += dispatch_packet(handler, std::move(pkt));
+      uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - before).count();
+      stats.handler_ns += ns;
+      stats.kind_ns[kind] += ns;
+    } else {
+      stats.accepted += dispatch_packet(handler, std::move(pkt));
+    }
+    stats.kind_frames[kind]++;
+    stats.frames++;
+  }
+
+  stats.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+  return stats;
+}
+
+// One capture to replay into one processor with replay_parallel()
+struct ReplayJob {
+  const char *path;
+  PacketProcessor *processor;
+  ReplayConfig config;
+
+  // Filled in by replay_parallel()
+  bool opened = false;
+  int error = 0;  // errno from opening the capture, if it couldn't be opened
+  ReplayStats stats;
+};
+
+// Replays every job on its own thread (each with its own reader), and waits for them all.  Returns true if every
+// capture could be opened.  Processors must not be shared between jobs unless they are thread-safe.
+bool replay_parallel(ReplayJob *jobs, size_t count);
+
+}  // namespace itp_packet
@@ -0,0 +1,211 @@
+#include "itp_sharedbus.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace itp_packet {
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory needs address-free 32-bit atomics");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory needs address-free 64-bit atomics");
+static_assert(sizeof(PacketRecord) % sizeof(uint32_t) == 0, "PacketRecord must be a whole number of words");
+
+// Offsets of the state and the frame ring within the region
+static size_t state_offset() { return (sizeof(SharedBusHeader) + 63) & ~size_t(63); }
+static size_t slots_offset() { return (state_offset() + sizeof(HeatPumpStateStore) + 63) & ~size_t(63); }
+static size_t region_size(uint32_t frame_capacity) {
+  return slots_offset() + (size_t) frame_capacity * sizeof(SharedBusSlot);
+}
+
+bool SharedBusPublisher::open(const char *name, uint32_t frame_capacity) {
+  close();
+  if (frame_capacity == 0 || (frame_capacity & (frame_capacity - 1)) != 0 || strlen(name) >= sizeof(name_)) {
+    errno = EINVAL;
+    return false;
+  }
+
+  // Start from a fresh region, so readers still attached to an old one see it closed rather than reused
+  shm_unlink(name);
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0)
+    return false;
+
+  size_t size = region_size(frame_capacity);
+  if (ftruncate(fd, size) != 0) {
+    int error = errno;
+    ::close(fd);
+    shm_unlink(name);
+    errno = error;
+    return false;
+  }
+
+  void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  int error = errno;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    shm_unlink(name);
+    errno = error;
+    return false;
+  }
+
+  strcpy(name_, name);
+  mapping_ = mapping;
+  mapping_size_ = size;
+  mask_ = frame_capacity - 1;
+  next_frame_ = 0;
+
+  auto *base = static_cast<uint8_t *>(mapping);
+  header_ = new (base) SharedBusHeader();
+  state_ = new (base + state_offset()) HeatPumpStateStore();
+  slots_ = reinterpret_cast<SharedBusSlot *>(base + slots_offset());
+  for (uint32_t i = 0; i < frame_capacity; i++) {
+    new (&slots_[i]) SharedBusSlot();
+  }
+
+  header_->magic = SHARED_BUS_MAGIC;
+  header_->version = SHARED_BUS_VERSION;
+  header_->record_size = sizeof(PacketRecord);
+  header_->state_size = sizeof(HeatPumpState);
+  header_->frame_capacity = frame_capacity;
+  header_->frames_written.store(0, std::memory_order_relaxed);
+  header_->closed.store(0, std::memory_order_relaxed);
+  header_->ready.store(1, std::memory_order_release);
+  return true;
+}
+
+void SharedBusPublisher::close() {
+  if (header_ == nullptr)
+    return;
+
+  header_->closed.store(1, std::memory_order_release);
+  munmap(mapping_, mapping_size_);
+  shm_unlink(name_);
+
+  mapping_ = nullptr;
+  header_ = nullptr;
+  state_ = nullptr;
+  slots_ = nullptr;
+}
+
+void SharedBusPublisher::publish_frame(const PacketRecord &record) {
+  uint64_t index = next_frame_++;
+  SharedBusSlot &slot = slots_[index & mask_];
+
+  uint32_t words[SharedBusSlot::WORD_COUNT];
+  memcpy(words, &record, sizeof(words));
+
+  slot.sequence.store(static_cast<uint32_t>(index * 2 + 1), std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < SharedBusSlot::WORD_COUNT; i++) {
+    slot.words[i].store(words[i], std::memory_order_relaxed);
+  }
+  slot.sequence.store(static_cast<uint32_t>((index + 1) * 2), std::memory_order_release);
+  header_->frames_written.store(index + 1, std::memory_order_release);
+}
+
+void SharedBusPublisher::publish(const RawPacketView &frame, SourceBridge source_bridge,
+                                 ControllerAssociation controller_association, uint32_t timestamp) {
+  state_->process_frame(frame, timestamp);
+  publish_frame(PacketRecord::from_view(frame, source_bridge, controller_association, timestamp));
+}
+
+bool SharedBusReader::attach(const char *name, bool from_oldest) {
+  detach();
+
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t) st.st_size < slots_offset()) {
+    ::close(fd);
+    errno = EAGAIN;  // Exists but not sized yet; the publisher is still starting
+    return false;
+  }
+
+  void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  int error = errno;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    errno = error;
+    return false;
+  }
+
+  auto *base = static_cast<const uint8_t *>(mapping);
+  auto *header = reinterpret_cast<const SharedBusHeader *>(base);
+  if (header->ready.load(std::memory_order_acquire) == 0) {
+    munmap(mapping, st.st_size);
+    errno = EAGAIN;
+    return false;
+  }
+  if (header->magic != SHARED_BUS_MAGIC || header->version != SHARED_BUS_VERSION ||
+      header->record_size != sizeof(PacketRecord) || header->state_size != sizeof(HeatPumpState) ||
+      region_size(header->frame_capacity) != (size_t) st.st_size) {
+    munmap(mapping, st.st_size);
+    errno = EPROTO;
+    return false;
+  }
+
+  mapping_ = mapping;
+  mapping_size_ = st.st_size;
+  header_ = header;
+  state_ = reinterpret_cast<const HeatPumpStateStore *>(base + state_offset());
+  slots_ = reinterpret_cast<const SharedBusSlot *>(base + slots_offset());
+  capacity_ = header->frame_capacity;
+
+  uint64_t written = header->frames_written.load(std::memory_order_acquire);
+  cursor_ = !from_oldest ? written : written > capacity_ ? written - capacity_ : 0;
+  return true;
+}
+
+void SharedBusReader::detach() {
+  if (header_ == nullptr)
+    return;
+
+  munmap(mapping_, mapping_size_);
+  mapping_ = nullptr;
+  header_ = nullptr;
+  state_ = nullptr;
+  slots_ = nullptr;
+}
+
+size_t SharedBusReader::read_frames(PacketRecord *out, size_t max_count, uint64_t *lost) {
+  uint64_t written = header_->frames_written.load(std::memory_order_acquire);
+  uint64_t skipped = 0;
+  if (written - cursor_ > capacity_) {
+    skipped = written - cursor_ - capacity_;
+    cursor_ = written - capacity_;
+  }
+
+  size_t count = 0;
+  while (count < max_count && cursor_ < written) {
+    const SharedBusSlot &slot = slots_[cursor_ & (capacity_ - 1)];
+    uint32_t expected = static_cast<uint32_t>((cursor_ + 1) * 2);
+    cursor_++;
+
+    uint32_t words[SharedBusSlot::WORD_COUNT];
+    uint32_t before = slot.sequence.load(std::memory_order_acquire);
+    for (size_t i = 0; i < SharedBusSlot::WORD_COUNT; i++) {
+      words[i] = slot.words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t after = slot.sequence.load(std::memory_order_relaxed);
+
+    // The publisher lapped us while we were reading this slot
+    if (before != expected || after != expected) {
+      skipped++;
+      continue;
+    }
+    memcpy(&out[count++], words, sizeof(words));
+  }
+
+  if (lost != nullptr)
+    *lost += skipped;
+  return count;
+}
+
+}  // namespace itp_packet
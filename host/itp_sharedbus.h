@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "itp_heatpumpstate.h"
+#include "itp_packetrecord.h"
+
+namespace itp_packet {
+
+// Layout of the shared region; readers refuse to attach to a region with a different version
+static const uint32_t SHARED_BUS_MAGIC = 0x49545042;  // "ITPB"
+static const uint16_t SHARED_BUS_VERSION = 1;
+
+struct SharedBusHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;   // sizeof(PacketRecord)
+  uint32_t state_size;    // sizeof(HeatPumpState)
+  uint32_t frame_capacity;
+  std::atomic<uint32_t> ready;   // Set once the publisher has initialized the region
+  std::atomic<uint32_t> closed;  // Set when the publisher shuts down; readers should detach (and may reattach)
+  alignas(64) std::atomic<uint64_t> frames_written;
+};
+
+// One slot of the frame ring.  sequence is odd while the slot is being written, and 2 * (frame index + 1) after.
+struct SharedBusSlot {
+  static const size_t WORD_COUNT = sizeof(PacketRecord) / sizeof(uint32_t);
+
+  std::atomic<uint32_t> sequence;
+  std::atomic<uint32_t> words[WORD_COUNT];
+};
+
+/* Publishes decoded heat pump state and every frame seen on a link into a POSIX shared-memory region, so that any
+number of processes on the same host can read them without sockets or serialization.
+
+The region holds a HeatPumpStateStore (readers take seqlocked snapshots of it) and a broadcast ring of PacketRecords
+in which every slot carries its own sequence number.  The publisher never waits for readers: a reader that falls more
+than a ring's length behind loses the oldest frames, and is told how many.  Readers attach and detach at any time
+without telling the publisher.
+
+Only one thread of one process may publish to a region.
+*/
+class SharedBusPublisher {
+ public:
+  static const uint32_t DEFAULT_FRAME_CAPACITY = 4096;
+
+  SharedBusPublisher() = default;
+  SharedBusPublisher(const SharedBusPublisher &) = delete;
+  SharedBusPublisher &operator=(const SharedBusPublisher &) = delete;
+  ~SharedBusPublisher() { close(); }
+
+  // Creates (replacing any stale region of the same name) and maps the region.  name follows shm_open() rules,
+  // e.g. "/itp-heatpump".  frame_capacity must be a power of two.  Returns false and sets errno on failure.
+  bool open(const char *name, uint32_t frame_capacity = DEFAULT_FRAME_CAPACITY);
+  // Marks the region closed, unmaps and unlinks it.  Attached readers keep their mapping until they detach.
+  void close();
+  bool is_open() const { return header_ != nullptr; }
+
+  // The shared state; update it from the decoding thread (e.g. with process_frame()).  Only valid while open.
+  HeatPumpStateStore &state() { return *state_; }
+
+  // Appends a frame to the ring
+  void publish_frame(const PacketRecord &record);
+  void publish_frame(const RawPacket &pkt, uint32_t timestamp) {
+    publish_frame(PacketRecord::from_raw_packet(pkt, timestamp));
+  }
+  // Updates the state from a received frame and appends it to the ring
+  void publish(const RawPacketView &frame, SourceBridge source_bridge, ControllerAssociation controller_association,
+               uint32_t timestamp);
+
+  uint64_t get_frames_written() const { return next_frame_; }
+
+ private:
+  char name_[64]{};
+  void *mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  SharedBusHeader *header_ = nullptr;
+  HeatPumpStateStore *state_ = nullptr;
+  SharedBusSlot *slots_ = nullptr;
+  uint32_t mask_ = 0;
+  uint64_t next_frame_ = 0;
+};
+
+// Reads a region created by a SharedBusPublisher, usually in another process.
+class SharedBusReader {
+ public:
+  SharedBusReader() = default;
+  SharedBusReader(const SharedBusReader &) = delete;
+  SharedBusReader &operator=(const SharedBusReader &) = delete;
+  ~SharedBusReader() { detach(); }
+
+  // Maps an existing region read-only.  By default only frames published after attaching are read; with
+  // from_oldest, reading starts at the oldest frame still in the ring.  Returns false and sets errno on failure
+  // (ENOENT if there is no publisher yet, EPROTO if the region's layout doesn't match this build).
+  bool attach(const char *name, bool from_oldest = false);
+  void detach();
+  bool is_attached() const { return header_ != nullptr; }
+
+  // True once the publisher has shut down; detach and attach again to follow a restarted publisher
+  bool is_publisher_closed() const { return header_->closed.load(std::memory_order_acquire) != 0; }
+
+  // A consistent snapshot of the published state
+  HeatPumpState read_state() const { return state_->snapshot(); }
+  // Changes whenever the state does, so callers can skip unchanged snapshots
+  uint32_t get_state_version() const { return state_->get_version(); }
+
+  // Copies up to max_count frames published since the last call into out, returning the number copied.  Frames
+  // overwritten before they could be read are added to lost.
+  size_t read_frames(PacketRecord *out, size_t max_count, uint64_t *lost = nullptr);
+  // Frames published but not yet read
+  uint64_t get_backlog() const { return header_->frames_written.load(std::memory_order_acquire) - cursor_; }
+
+ private:
+  void *mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  const SharedBusHeader *header_ = nullptr;
+  const HeatPumpStateStore *state_ = nullptr;
+  const SharedBusSlot *slots_ = nullptr;
+  uint32_t capacity_ = 0;
+  uint64_t cursor_ = 0;
+};
+
+}  // namespace itp_packet
@@ -0,0 +1,313 @@
+#include "itp_thermostatemulator.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
+#include "itp_pty.h"
+
+namespace itp_packet {
+
+// One polling cycle; the last three are only sent with poll_heat_pump
+static const ThermostatExchange CYCLE[] = {
+    ThermostatExchange::STATE_DOWNLOAD,   ThermostatExchange::SENSOR_STATUS, ThermostatExchange::STATE_UPLOAD,
+    ThermostatExchange::AB_GET,           ThermostatExchange::AA_SET,        ThermostatExchange::SETTINGS_GET,
+    ThermostatExchange::CURRENT_TEMP_GET, ThermostatExchange::REMOTE_TEMPERATURE,
+};
+static const size_t THERMOSTAT_ONLY_CYCLE_LENGTH = 5;
+
+const char *thermostat_exchange_name(ThermostatExchange exchange) {
+  switch (exchange) {
+    case ThermostatExchange::CONNECT:
+      return "connect";
+    case ThermostatExchange::HELLO:
+      return "hello";
+    case ThermostatExchange::STATE_DOWNLOAD:
+      return "state_download";
+    case ThermostatExchange::SENSOR_STATUS:
+      return "sensor_status";
+    case ThermostatExchange::STATE_UPLOAD:
+      return "state_upload";
+    case ThermostatExchange::AB_GET:
+      return "ab_get";
+    case ThermostatExchange::AA_SET:
+      return "aa_set";
+    case ThermostatExchange::SETTINGS_GET:
+      return "settings_get";
+    case ThermostatExchange::CURRENT_TEMP_GET:
+      return "current_temp_get";
+    case ThermostatExchange::REMOTE_TEMPERATURE:
+      return "remote_temperature";
+    default:
+      return "unknown";
+  }
+}
+
+bool ThermostatEmulator::open() {
+  close();
+  if (!open_pty(master_fd_, slave_fd_, device_path_, sizeof(device_path_)))
+    return false;
+
+  framer_.reset();
+  connected_ = false;
+  outstanding_ = false;
+  write_length_ = 0;
+  written_ = 0;
+  next_request_us_ = 0;
+  consecutive_timeouts_ = 0;
+  return true;
+}
+
+void ThermostatEmulator::close() {
+  if (slave_fd_ >= 0)
+    ::close(slave_fd_);
+  if (master_fd_ >= 0)
+    ::close(master_fd_);
+  slave_fd_ = -1;
+  master_fd_ = -1;
+  device_path_[0] = '\0';
+}
+
+void ThermostatEmulator::on_readable(uint64_t now_us) {
+  uint8_t buffer[256];
+  while (master_fd_ >= 0) {
+    ssize_t received = ::read(master_fd_, buffer, sizeof(buffer));
+    if (received <= 0) {
+      if (received < 0 && errno == EINTR)
+        continue;
+      return;
+    }
+    framer_.feed_views(buffer, received, [this, now_us](const RawPacketView &frame) { handle_frame_(frame, now_us); });
+  }
+}
+
+void ThermostatEmulator::poll(uint64_t now_us) {
+  if (master_fd_ < 0)
+    return;
+
+  if (outstanding_) {
+    if (now_us - sent_us_ < (uint64_t) config_.response_timeout_ms * 1000)
+      return;
+
+    stats_for_(outstanding_exchange_).timeouts++;
+    outstanding_ = false;
+    if (outstanding_exchange_ == ThermostatExchange::CONNECT || ++consecutive_timeouts_ >= config_.max_timeouts) {
+      // Start over with a new connect, after a full cycle's pause
+      if (connected_)
+        stats_.reconnects++;
+      connected_ = false;
+      consecutive_timeouts_ = 0;
+      next_request_us_ = now_us + (uint64_t) config_.cycle_interval_ms * 1000;
+    } else {
+      next_request_us_ = now_us + (uint64_t) config_.request_gap_ms * 1000;
+    }
+    return;
+  }
+
+  if (now_us < next_request_us_)
+    return;
+
+  if (written_ < write_length_) {
+    flush_(now_us);
+  } else if (!connected_) {
+    send_(ThermostatExchange::CONNECT, now_us);
+  } else if (!hello_sent_) {
+    send_(ThermostatExchange::HELLO, now_us);
+  } else if (cycle_position_ < (config_.poll_heat_pump ? sizeof(CYCLE) / sizeof(CYCLE[0])
+                                                        : THERMOSTAT_ONLY_CYCLE_LENGTH)) {
+    if (cycle_position_ == 0)
+      cycle_start_us_ = now_us;
+    send_(CYCLE[cycle_position_], now_us);
+  } else {
+    stats_.cycles++;
+    cycle_position_ = 0;
+    uint64_t next_cycle_us = cycle_start_us_ + (uint64_t) config_.cycle_interval_ms * 1000;
+    next_request_us_ = next_cycle_us > now_us ? next_cycle_us : now_us;
+  }
+}
+
+uint64_t ThermostatEmulator::get_next_due_us(uint64_t now_us) const {
+  uint64_t due_us = outstanding_ ? sent_us_ + (uint64_t) config_.response_timeout_ms * 1000 : next_request_us_;
+  return due_us > now_us ? due_us - now_us : 0;
+}
+
+bool ThermostatEmulator::send_(ThermostatExchange exchange, uint64_t now_us) {
+  RawPacket request(PacketType::GET_REQUEST, 1);
+  expected_type_ = static_cast<uint8_t>(PacketType::SET_RESPONSE);
+  expected_command_ = 0;
+
+  switch (exchange) {
+    case ThermostatExchange::CONNECT:
+      request = RawPacket(ConnectRequestPacket::FRAME.data(), ConnectRequestPacket::FRAME.size());
+      expected_type_ = static_cast<uint8_t>(PacketType::CONNECT_RESPONSE);
+      break;
+    case ThermostatExchange::HELLO: {
+      ThermostatHelloPacket hello;
+      hello.set_thermostat_model(config_.model).set_thermostat_serial(config_.serial);
+      hello.set_thermostat_version(config_.version[0], config_.version[1], config_.version[2]);
+      request = hello.raw_packet();
+      break;
+    }
+    case ThermostatExchange::STATE_DOWNLOAD:
+      expected_command_ = static_cast<uint8_t>(GetCommand::THERMOSTAT_STATE_DOWNLOAD);
+      request.set_payload_byte(0, expected_command_);
+      expected_type_ = static_cast<uint8_t>(PacketType::GET_RESPONSE);
+      break;
+    case ThermostatExchange::SENSOR_STATUS: {
+      ThermostatSensorStatusPacket status;
+      status.set_indoor_humidity_percent(state_.humidity_percent).set_thermostat_battery_state(state_.battery_state);
+      request = status.raw_packet();
+      break;
+    }
+    case ThermostatExchange::STATE_UPLOAD: {
+      // The thermostat's clock, in the fields get_thermostat_timestamp() uses
+      time_t now = time(nullptr);
+      struct tm local;
+      localtime_r(&now, &local);
+      local.tm_year += 1900;
+      local.tm_mon += 1;
+
+      ThermostatStateUploadPacket upload;
+      upload.set_thermostat_timestamp(local).set_auto_mode(state_.auto_mode);
+      upload.set_heat_setpoint_deci_c(state_.heat_setpoint_deci_c);
+      upload.set_cool_setpoint_deci_c(state_.cool_setpoint_deci_c);
+      request = upload.raw_packet();
+      break;
+    }
+    case ThermostatExchange::AB_GET:
+      expected_command_ = static_cast<uint8_t>(GetCommand::THERMOSTAT_GET_AB);
+      request.set_payload_byte(0, expected_command_);
+      expected_type_ = static_cast<uint8_t>(PacketType::GET_RESPONSE);
+      break;
+    case ThermostatExchange::AA_SET:
+      request = ThermostatAASetRequestPacket().raw_packet();
+      break;
+    case ThermostatExchange::SETTINGS_GET:
+      request = RawPacket(GetRequestPacket::SETTINGS_FRAME.data(), GetRequestPacket::SETTINGS_FRAME.size());
+      expected_command_ = static_cast<uint8_t>(GetCommand::SETTINGS);
+      expected_type_ = static_cast<uint8_t>(PacketType::GET_RESPONSE);
+      break;
+    case ThermostatExchange::CURRENT_TEMP_GET:
+      request = RawPacket(GetRequestPacket::CURRENT_TEMP_FRAME.data(), GetRequestPacket::CURRENT_TEMP_FRAME.size());
+      expected_command_ = static_cast<uint8_t>(GetCommand::CURRENT_TEMP);
+      expected_type_ = static_cast<uint8_t>(PacketType::GET_RESPONSE);
+      break;
+    case ThermostatExchange::REMOTE_TEMPERATURE:
+      request = RemoteTemperatureSetRequestPacket().set_remote_temperature_deci_c(state_.room_deci_c).raw_packet();
+      break;
+  }
+
+  memcpy(write_buffer_, request.get_bytes(), request.get_length());
+  write_length_ = request.get_length();
+  written_ = 0;
+  writing_exchange_ = exchange;
+  return flush_(now_us);
+}
+
+bool ThermostatEmulator::flush_(uint64_t now_us) {
+  while (written_ < write_length_) {
+    ssize_t written = ::write(master_fd_, write_buffer_ + written_, write_length_ - written_);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      // E.g. EAGAIN while nothing is reading the pty: the unwritten rest is retried after a gap
+      next_request_us_ = now_us + (uint64_t) config_.request_gap_ms * 1000;
+      return false;
+    }
+    written_ += written;
+  }
+
+  ThermostatExchange exchange = writing_exchange_;
+  stats_for_(exchange).requests++;
+  if (exchange == ThermostatExchange::HELLO) {
+    // Not answered, so the cycle carries on after a gap
+    hello_sent_ = true;
+    next_request_us_ = now_us + (uint64_t) config_.request_gap_ms * 1000;
+    return true;
+  }
+
+  if (exchange != ThermostatExchange::CONNECT)
+    cycle_position_++;
+  outstanding_ = true;
+  outstanding_exchange_ = exchange;
+  sent_us_ = now_us;
+  return true;
+}
+
+void ThermostatEmulator::handle_frame_(const RawPacketView &frame, uint64_t now_us) {
+  if (!outstanding_ || frame.get_packet_type() != expected_type_) {
+    stats_.unexpected++;
+    return;
+  }
+
+  ThermostatExchangeStats &stats = stats_for_(outstanding_exchange_);
+  if (expected_type_ == static_cast<uint8_t>(PacketType::GET_RESPONSE) &&
+      (frame.get_command() != expected_command_ || frame.get_length() != PACKET_MAX_SIZE)) {
+    stats.mismatched++;
+  } else {
+    uint64_t latency_us = now_us - sent_us_;
+    stats.responses++;
+    stats.total_latency_us += latency_us;
+    if (latency_us > stats.max_latency_us)
+      stats.max_latency_us = latency_us;
+
+    if (expected_type_ == static_cast<uint8_t>(PacketType::SET_RESPONSE) &&
+        !SetResponseView(frame.get_bytes(), frame.get_length()).is_successful())
+      stats.refused++;
+
+    if (outstanding_exchange_ == ThermostatExchange::CONNECT) {
+      connected_ = true;
+      hello_sent_ = false;
+      cycle_position_ = 0;
+    } else if (outstanding_exchange_ == ThermostatExchange::STATE_DOWNLOAD) {
+      state_download_ = ThermostatStateDownloadResponsePacket(frame.to_raw_packet(SourceBridge::THERMOSTAT));
+      has_state_download_ = true;
+    }
+  }
+
+  consecutive_timeouts_ = 0;
+  finish_exchange_(now_us);
+}
+
+void ThermostatEmulator::finish_exchange_(uint64_t now_us) {
+  outstanding_ = false;
+  next_request_us_ = now_us + (uint64_t) config_.request_gap_ms * 1000;
+}
+
+void run_thermostat_emulators(ThermostatEmulator *const *emulators, size_t count, const std::atomic<bool> &stop) {
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+  std::vector<pollfd> fds(count);
+  for (size_t i = 0; i < count; i++) {
+    fds[i].fd = emulators[i]->get_fd();
+    fds[i].events = POLLIN;
+  }
+
+  while (!stop.load(std::memory_order_relaxed)) {
+    uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    // Wake at least every 100 ms so that stop is noticed
+    uint64_t timeout_us = 100000;
+    for (size_t i = 0; i < count; i++) {
+      uint64_t due_us = emulators[i]->get_next_due_us(now_us);
+      if (due_us < timeout_us)
+        timeout_us = due_us;
+    }
+
+    int ready = ::poll(fds.data(), fds.size(), (int) ((timeout_us + 999) / 1000));
+    if (ready < 0 && errno != EINTR)
+      return;
+
+    // Responses are timestamped as soon as poll() returns, before any emulator's handling adds to their latency
+    now_us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    for (size_t i = 0; i < count; i++) {
+      if (ready > 0 && (fds[i].revents & POLLIN))
+        emulators[i]->on_readable(now_us);
+      emulators[i]->poll(now_us);
+    }
+  }
+}
+
+}  // namespace itp_packet
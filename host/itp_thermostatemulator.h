@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "itp_packetframer.h"
+#include "itp_packets.h"
+
+namespace itp_packet {
+
+// The request/response exchanges a thermostat performs, in the order of a polling cycle
+enum class ThermostatExchange : uint8_t {
+  CONNECT,
+  HELLO,  // Not answered
+  STATE_DOWNLOAD,
+  SENSOR_STATUS,
+  STATE_UPLOAD,
+  AB_GET,
+  AA_SET,
+  SETTINGS_GET,
+  CURRENT_TEMP_GET,
+  REMOTE_TEMPERATURE,
+};
+
+static const size_t THERMOSTAT_EXCHANGE_COUNT = static_cast<size_t>(ThermostatExchange::REMOTE_TEMPERATURE) + 1;
+
+// A short name for an exchange, for reports
+const char *thermostat_exchange_name(ThermostatExchange exchange);
+
+struct ThermostatEmulatorConfig {
+  char model[ThermostatHelloPacket::MODEL_BUFFER_SIZE] = "MHK2";
+  char serial[ThermostatHelloPacket::SERIAL_BUFFER_SIZE] = "EMU000000001";
+  uint8_t version[3] = {1, 9, 0};
+  uint32_t cycle_interval_ms = 3000;    // A polling cycle starts this often
+  uint32_t request_gap_ms = 40;         // Pause between one exchange finishing and the next request of a cycle
+  uint32_t response_timeout_ms = 1000;  // How long to wait for a response before giving up on an exchange
+  uint32_t max_timeouts = 3;            // Consecutive timeouts after which the thermostat reconnects
+  bool poll_heat_pump = true;           // Include the settings and current temperature GETs and a remote temperature
+                                        // SET in each cycle, as an MHK2 does
+};
+
+// What the emulated thermostat reports.  Temperatures are in tenths of a degree.
+struct EmulatedThermostatState {
+  int16_t room_deci_c = 215;
+  uint8_t humidity_percent = 45;
+  ThermostatSensorStatusPacket::ThermostatBatteryState battery_state =
+      ThermostatSensorStatusPacket::THERMOSTAT_BATTERY_OK;
+  uint8_t auto_mode = 0;
+  int16_t heat_setpoint_deci_c = 200;
+  int16_t cool_setpoint_deci_c = 250;
+};
+
+// Counters and response times for one kind of exchange
+struct ThermostatExchangeStats {
+  uint32_t requests = 0;
+  uint32_t responses = 0;   // Well-formed responses
+  uint32_t timeouts = 0;    // Requests with no response within response_timeout_ms
+  uint32_t mismatched = 0;  // Responses of the right type but for another command, or of the wrong size
+  uint32_t refused = 0;     // Set responses reporting failure
+  uint64_t total_latency_us = 0;
+  uint32_t max_latency_us = 0;
+
+  uint32_t get_mean_latency_us() const { return responses > 0 ? total_latency_us / responses : 0; }
+};
+
+// Counters describing an emulator's activity since construction (or the last reset_stats()), per exchange
+struct ThermostatEmulatorStats {
+  uint32_t cycles = 0;      // Polling cycles completed
+  uint32_t reconnects = 0;  // Connections abandoned after max_timeouts consecutive timeouts
+  uint32_t unexpected = 0;  // Frames received that didn't answer the outstanding request
+  ThermostatExchangeStats exchanges[THERMOSTAT_EXCHANGE_COUNT];
+
+  const ThermostatExchangeStats &get(ThermostatExchange exchange) const {
+    return exchanges[static_cast<size_t>(exchange)];
+  }
+};
+
+/* Emulates an MHK2-style thermostat on a pseudo-terminal, for exercising and profiling the thermostat side of an
+adapter without a thermostat on the bus.  open() creates a pty; point the adapter's thermostat port at
+get_device_path().
+
+Like a real thermostat, the emulator is the bus master: it connects, sends a hello (carrying its model and serial as
+6-bit strings), and then every cycle_interval_ms runs a polling cycle of one request at a time, request_gap_ms apart:
+the state download and AB GETs, sensor status, state upload and AA SETs and, with poll_heat_pump, the settings and
+current temperature GETs and a remote temperature SET.  Each response is checked (type, command and size, and the
+result of set responses) and timed; the latest state download is kept for inspection.
+
+Times are microseconds from a monotonic clock, so that response times can be measured precisely.  Nothing here blocks:
+call on_readable() when get_fd() is readable and poll() regularly (see run_thermostat_emulators()).
+*/
+class ThermostatEmulator {
+ public:
+  ThermostatEmulator(ThermostatEmulatorConfig config = {}) : config_{config} {}
+  ThermostatEmulator(const ThermostatEmulator &) = delete;
+  ThermostatEmulator &operator=(const ThermostatEmulator &) = delete;
+  ~ThermostatEmulator() { close(); }
+
+  // Creates the pty.  Returns false and sets errno on failure.
+  bool open();
+  void close();
+  bool is_open() const { return master_fd_ >= 0; }
+
+  // The pty's device (e.g. /dev/pts/7), for the adapter to open
+  const char *get_device_path() const { return device_path_; }
+  // The non-blocking descriptor to wait on for readability
+  int get_fd() const { return master_fd_; }
+
+  // Reads and checks everything received so far
+  void on_readable(uint64_t now_us);
+  // Sends the next request when it's due, and gives up on an unanswered one once it times out
+  void poll(uint64_t now_us);
+  // Microseconds until poll() next has something to do
+  uint64_t get_next_due_us(uint64_t now_us) const;
+
+  bool is_connected() const { return connected_; }
+
+  // What the thermostat reports, which can be changed at any time (e.g. to move a setpoint)
+  EmulatedThermostatState &get_state() { return state_; }
+  const EmulatedThermostatState &get_state() const { return state_; }
+
+  // The adapter's latest state download response, if one has been received
+  bool has_state_download() const { return has_state_download_; }
+  const ThermostatStateDownloadResponsePacket &get_state_download() const { return state_download_; }
+
+  const ThermostatEmulatorStats &get_stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+  const PacketFramerStats &get_framer_stats() const { return framer_.get_stats(); }
+
+ private:
+  ThermostatEmulatorConfig config_;
+  int master_fd_ = -1;
+  int slave_fd_ = -1;  // Held open so the master never sees a hangup between clients
+  char device_path_[64] = {};
+
+  PacketFramer framer_{SourceBridge::THERMOSTAT, ControllerAssociation::THERMOSTAT};
+  EmulatedThermostatState state_;
+  bool connected_ = false;
+  bool hello_sent_ = false;
+  size_t cycle_position_ = 0;
+  uint64_t cycle_start_us_ = 0;
+  uint64_t next_request_us_ = 0;
+  uint32_t consecutive_timeouts_ = 0;
+
+  bool outstanding_ = false;
+  ThermostatExchange outstanding_exchange_ = ThermostatExchange::CONNECT;
+  uint8_t expected_type_ = 0;
+  uint8_t expected_command_ = 0;
+  uint64_t sent_us_ = 0;
+
+  // The request being written; a write the pty only partly accepts is finished before anything else is sent
+  uint8_t write_buffer_[PACKET_MAX_SIZE];
+  uint8_t write_length_ = 0;
+  uint8_t written_ = 0;
+  ThermostatExchange writing_exchange_ = ThermostatExchange::CONNECT;
+
+  bool has_state_download_ = false;
+  ThermostatStateDownloadResponsePacket state_download_;
+
+  ThermostatEmulatorStats stats_;
+
+  ThermostatExchangeStats &stats_for_(ThermostatExchange exchange) {
+    return stats_.exchanges[static_cast<size_t>(exchange)];
+  }
+  // Builds and writes the request for an exchange; returns false if it couldn't all be written yet
+  bool send_(ThermostatExchange exchange, uint64_t now_us);
+  // Writes the rest of the current request, starting its exchange once it's all out.  Backs off for request_gap_ms
+  // if the pty won't take it.
+  bool flush_(uint64_t now_us);
+  void handle_frame_(const RawPacketView &frame, uint64_t now_us);
+  // Ends the outstanding exchange and schedules the next request
+  void finish_exchange_(uint64_t now_us);
+};
+
+// Drives emulators from the calling thread until stop is set, waiting on all of them with poll(2)
+void run_thermostat_emulators(ThermostatEmulator *const *emulators, size_t count, const std::atomic<bool> &stop);
+
+}  // namespace itp_packet
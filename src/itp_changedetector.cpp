@@ -0,0 +1,168 @@
+#include "itp_changedetector.h"
+
+#include <bit>
+#include <cstring>
+#include "packets/get.h"
+
+namespace itp_packet {
+
+namespace {
+
+struct FieldInfo {
+  PacketType packet_type;
+  GetCommand command;
+  uint16_t bytes;
+  const char *name;
+};
+
+constexpr uint16_t payload_bit(int index) { return 1 << index; }
+
+// Indexed by PacketField
+const FieldInfo FIELDS[PACKET_FIELD_COUNT] = {
+    {PacketType::GET_RESPONSE, GetCommand::SETTINGS, payload_bit(SettingsGetResponseView::PLINDEX_POWER), "Power"},
+    {PacketType::GET_RESPONSE, GetCommand::SETTINGS, payload_bit(SettingsGetResponseView::PLINDEX_MODE), "Mode"},
+    {PacketType::GET_RESPONSE, GetCommand::SETTINGS,
+     payload_bit(SettingsGetResponseView::PLINDEX_TARGETTEMP_LEGACY) |
+         payload_bit(SettingsGetResponseView::PLINDEX_TARGETTEMP),
+     "TargetTemp"},
+    {PacketType::GET_RESPONSE, GetCommand::SETTINGS, payload_bit(SettingsGetResponseView::PLINDEX_FAN), "Fan"},
+    {PacketType::GET_RESPONSE, GetCommand::SETTINGS, payload_bit(SettingsGetResponseView::PLINDEX_VANE), "Vane"},
+    {PacketType::GET_RESPONSE, GetCommand::SETTINGS, payload_bit(SettingsGetResponseView::PLINDEX_PROHIBITFLAGS),
+     "ProhibitFlags"},
+    {PacketType::GET_RESPONSE, GetCommand::SETTINGS, payload_bit(SettingsGetResponseView::PLINDEX_HVANE),
+     "HorizontalVane"},
+    {PacketType::GET_RESPONSE, GetCommand::CURRENT_TEMP,
+     payload_bit(CurrentTempGetResponseView::PLINDEX_CURRENTTEMP_LEGACY) |
+         payload_bit(CurrentTempGetResponseView::PLINDEX_CURRENTTEMP),
+     "RoomTemp"},
+    {PacketType::GET_RESPONSE, GetCommand::CURRENT_TEMP, payload_bit(CurrentTempGetResponseView::PLINDEX_OUTDOORTEMP),
+     "OutdoorTemp"},
+    {PacketType::GET_RESPONSE, GetCommand::CURRENT_TEMP,
+     payload_bit(CurrentTempGetResponseView::PLINDEX_RUNTIME) |
+         payload_bit(CurrentTempGetResponseView::PLINDEX_RUNTIME + 1) |
+         payload_bit(CurrentTempGetResponseView::PLINDEX_RUNTIME + 2),
+     "RuntimeMinutes"},
+    {PacketType::GET_RESPONSE, GetCommand::STATUS, payload_bit(StatusGetResponseView::PLINDEX_COMPRESSOR_FREQUENCY),
+     "CompressorFrequency"},
+    {PacketType::GET_RESPONSE, GetCommand::STATUS, payload_bit(StatusGetResponseView::PLINDEX_OPERATING),
+     "Operating"},
+    {PacketType::GET_RESPONSE, GetCommand::STATUS,
+     payload_bit(StatusGetResponseView::PLINDEX_INPUT_WATTS) |
+         payload_bit(StatusGetResponseView::PLINDEX_INPUT_WATTS + 1),
+     "InputWatts"},
+    {PacketType::GET_RESPONSE, GetCommand::STATUS,
+     payload_bit(StatusGetResponseView::PLINDEX_LIFETIME_KWH) |
+         payload_bit(StatusGetResponseView::PLINDEX_LIFETIME_KWH + 1),
+     "LifetimeKWh"},
+    {PacketType::GET_RESPONSE, GetCommand::RUN_STATE, payload_bit(RunStateGetResponseView::PLINDEX_STATUSFLAGS),
+     "RunStateFlags"},
+    {PacketType::GET_RESPONSE, GetCommand::RUN_STATE, payload_bit(RunStateGetResponseView::PLINDEX_ACTUALFAN),
+     "ActualFan"},
+    {PacketType::GET_RESPONSE, GetCommand::RUN_STATE, payload_bit(RunStateGetResponseView::PLINDEX_AUTOMODE),
+     "AutoMode"},
+    {PacketType::GET_RESPONSE, GetCommand::ERROR_INFO,
+     payload_bit(ErrorStateGetResponseView::PLINDEX_ERROR_CODE) |
+         payload_bit(ErrorStateGetResponseView::PLINDEX_ERROR_CODE + 1) |
+         payload_bit(ErrorStateGetResponseView::PLINDEX_SHORT_CODE),
+     "ErrorCodes"},
+    {PacketType::GET_RESPONSE, GetCommand::FUNCTIONS_1, 0xFFFE, "Functions1"},
+    {PacketType::GET_RESPONSE, GetCommand::FUNCTIONS_2, 0xFFFE, "Functions2"},
+};
+
+// Collapses each non-zero byte of x to a single bit (bit n = byte n, in memory order)
+uint8_t nonzero_bytes(uint64_t x) {
+  x |= x >> 4;
+  x |= x >> 2;
+  x |= x >> 1;
+  x &= 0x0101010101010101ull;
+  if constexpr (std::endian::native == std::endian::big) {
+    x = __builtin_bswap64(x);
+  }
+  // Gathers the low bit of every byte into the top byte
+  return (x * 0x0102040810204080ull) >> 56;
+}
+
+}  // namespace
+
+uint16_t ChangeDetector::diff_bytes(const uint8_t a[MAX_PAYLOAD_SIZE], const uint8_t b[MAX_PAYLOAD_SIZE]) {
+  uint64_t a_words[2], b_words[2];
+  memcpy(a_words, a, sizeof(a_words));
+  memcpy(b_words, b, sizeof(b_words));
+
+  uint64_t low = a_words[0] ^ b_words[0];
+  uint64_t high = a_words[1] ^ b_words[1];
+  if ((low | high) == 0)
+    return 0;
+  return nonzero_bytes(low) | nonzero_bytes(high) << 8;
+}
+
+uint16_t ChangeDetector::update(const RawPacketView &packet) {
+  uint8_t packet_type = packet.get_packet_type();
+  uint8_t command = packet.get_command();
+  uint8_t length = packet.get_length() > PACKET_HEADER_SIZE ? packet.get_length() - PACKET_HEADER_SIZE - 1 : 0;
+  if (length > MAX_PAYLOAD_SIZE)
+    length = MAX_PAYLOAD_SIZE;
+
+  alignas(8) uint8_t payload[MAX_PAYLOAD_SIZE] = {};
+  memcpy(payload, packet.get_payload_bytes(), length);
+  const uint16_t all_bytes = (1u << length) - 1;
+
+  for (size_t i = 0; i < tracked_count_; i++) {
+    Tracked &tracked = tracked_[i];
+    if (tracked.packet_type != packet_type || tracked.command != command)
+      continue;
+
+    uint16_t changed = tracked.length == length ? diff_bytes(tracked.payload, payload) : all_bytes;
+    if (changed != 0) {
+      memcpy(tracked.payload, payload, sizeof(payload));
+      tracked.length = length;
+    }
+    return changed;
+  }
+
+  if (tracked_count_ < MAX_TRACKED) {
+    Tracked &tracked = tracked_[tracked_count_++];
+    memcpy(tracked.payload, payload, sizeof(payload));
+    tracked.packet_type = packet_type;
+    tracked.command = command;
+    tracked.length = length;
+  }
+  return all_bytes;
+}
+
+uint32_t ChangeDetector::process(const RawPacketView &packet) {
+  uint16_t changed_bytes = update(packet);
+  if (changed_bytes == 0)
+    return 0;
+
+  uint8_t packet_type = packet.get_packet_type();
+  uint8_t command = packet.get_command();
+  uint32_t changed_fields = 0;
+  for (size_t i = 0; i < PACKET_FIELD_COUNT; i++) {
+    const FieldInfo &field = FIELDS[i];
+    if (static_cast<uint8_t>(field.packet_type) == packet_type && static_cast<uint8_t>(field.command) == command &&
+        (field.bytes & changed_bytes) != 0) {
+      changed_fields |= 1u << i;
+    }
+  }
+
+  for (size_t i = 0; i < PACKET_FIELD_COUNT; i++) {
+    if ((changed_fields & (1u << i)) && callbacks_[i])
+      callbacks_[i](static_cast<PacketField>(i), packet);
+  }
+  return changed_fields;
+}
+
+uint16_t ChangeDetector::get_field_bytes(PacketField field) { return FIELDS[static_cast<size_t>(field)].bytes; }
+
+uint8_t ChangeDetector::get_field_packet_type(PacketField field) {
+  return static_cast<uint8_t>(FIELDS[static_cast<size_t>(field)].packet_type);
+}
+
+uint8_t ChangeDetector::get_field_command(PacketField field) {
+  return static_cast<uint8_t>(FIELDS[static_cast<size_t>(field)].command);
+}
+
+const char *ChangeDetector::get_field_name(PacketField field) { return FIELDS[static_cast<size_t>(field)].name; }
+
+}  // namespace itp_packet
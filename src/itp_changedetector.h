@@ -0,0 +1,86 @@
+#pragma once
+
+#include <functional>
+#include "itp_rawpacketview.h"
+
+namespace itp_packet {
+
+// Decoded values that ChangeDetector reports changes to.  Each maps to the payload bytes it's decoded from.
+enum class PacketField : uint8_t {
+  SETTINGS_POWER,
+  SETTINGS_MODE,
+  SETTINGS_TARGET_TEMP,
+  SETTINGS_FAN,
+  SETTINGS_VANE,
+  SETTINGS_PROHIBIT_FLAGS,
+  SETTINGS_HORIZONTAL_VANE,
+  CURRENT_TEMP_ROOM,
+  CURRENT_TEMP_OUTDOOR,
+  CURRENT_TEMP_RUNTIME,
+  STATUS_COMPRESSOR_FREQUENCY,
+  STATUS_OPERATING,
+  STATUS_INPUT_WATTS,
+  STATUS_LIFETIME_KWH,
+  RUN_STATE_FLAGS,
+  RUN_STATE_ACTUAL_FAN,
+  RUN_STATE_AUTO_MODE,
+  ERROR_STATE_CODES,
+  FUNCTIONS_1,
+  FUNCTIONS_2,
+  COUNT
+};
+
+static const size_t PACKET_FIELD_COUNT = static_cast<size_t>(PacketField::COUNT);
+
+/* Remembers the last payload seen for each (packet type, command) and reports which payload bytes, and which decoded
+fields, differ in the next one.  Most responses repeat poll after poll, so handlers built on this only decode and
+publish the fields that actually changed.
+
+Payloads are compared eight bytes at a time with XOR and turned into a mask of changed bytes without a per-byte
+loop; an unchanged packet costs two word compares.  The first packet of each kind reports everything as changed.
+Storage is fixed (MAX_TRACKED kinds of packet); packets beyond that are always reported as fully changed.
+*/
+class ChangeDetector {
+ public:
+  static const size_t MAX_TRACKED = 16;
+  static const size_t MAX_PAYLOAD_SIZE = 16;
+
+  // Called with the field that changed and the packet it changed in
+  using FieldCallback = std::function<void(PacketField field, const RawPacketView &packet)>;
+
+  // Compares packet against the last one of its type and command, and remembers it.  Returns a mask of the payload
+  // bytes that changed (bit n = payload byte n).
+  uint16_t update(const RawPacketView &packet);
+
+  // As update(), then calls the callbacks of every field that changed.  Returns a mask of changed fields
+  // (bit n = PacketField n).
+  uint32_t process(const RawPacketView &packet);
+
+  void on_change(PacketField field, FieldCallback callback) { callbacks_[static_cast<size_t>(field)] = callback; }
+
+  // Forgets every remembered payload, so the next packet of each kind reports everything as changed
+  void reset() { tracked_count_ = 0; }
+
+  // Payload bytes a field is decoded from, and the packet type and command it appears in
+  static uint16_t get_field_bytes(PacketField field);
+  static uint8_t get_field_packet_type(PacketField field);
+  static uint8_t get_field_command(PacketField field);
+  static const char *get_field_name(PacketField field);
+
+  // Mask of the bytes that differ between two MAX_PAYLOAD_SIZE-byte buffers
+  static uint16_t diff_bytes(const uint8_t a[MAX_PAYLOAD_SIZE], const uint8_t b[MAX_PAYLOAD_SIZE]);
+
+ private:
+  struct Tracked {
+    alignas(8) uint8_t payload[MAX_PAYLOAD_SIZE];
+    uint8_t packet_type;
+    uint8_t command;
+    uint8_t length;
+  };
+
+  Tracked tracked_[MAX_TRACKED];
+  size_t tracked_count_ = 0;
+  FieldCallback callbacks_[PACKET_FIELD_COUNT];
+};
+
+}  // namespace itp_packet
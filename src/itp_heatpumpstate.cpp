@@ -0,0 +1,103 @@
+#include "itp_heatpumpstate.h"
+
+#include "itp_packetdispatch.h"
+
+namespace itp_packet {
+
+void HeatPumpStateStore::update(const SettingsGetResponseView &response, uint32_t now_ms) {
+  state_.update([&](HeatPumpState &state) {
+    state.power.set(response.get_power(), now_ms);
+    state.mode.set(response.get_mode(), now_ms);
+    state.target_temp.set(response.get_target_temp(), now_ms);
+    state.fan.set(response.get_fan(), now_ms);
+    state.vane.set(response.get_vane(), now_ms);
+    state.horizontal_vane.set(response.get_horizontal_vane(), now_ms);
+    state.horizontal_vane_msb.set(response.get_horizontal_vane_msb(), now_ms);
+    state.i_see_enabled.set(response.is_i_see_enabled(), now_ms);
+    state.prohibit_flags.set(
+        response.locked_power() | response.locked_mode() << 1 | response.locked_temp() << 2, now_ms);
+  });
+}
+
+void HeatPumpStateStore::update(const CurrentTempGetResponseView &response, uint32_t now_ms) {
+  state_.update([&](HeatPumpState &state) {
+    state.room_temp.set(response.get_current_temp(), now_ms);
+    state.outdoor_temp.set(response.get_outdoor_temp(), now_ms);
+    state.runtime_minutes.set(response.get_runtime_minutes(), now_ms);
+  });
+}
+
+void HeatPumpStateStore::update(const StatusGetResponseView &response, uint32_t now_ms) {
+  state_.update([&](HeatPumpState &state) {
+    state.compressor_frequency.set(response.get_compressor_frequency(), now_ms);
+    state.operating.set(response.get_operating(), now_ms);
+    state.input_watts.set(response.get_input_watts(), now_ms);
+    state.lifetime_kwh.set(response.get_lifetime_kwh(), now_ms);
+  });
+}
+
+void HeatPumpStateStore::update(const RunStateGetResponseView &response, uint32_t now_ms) {
+  state_.update([&](HeatPumpState &state) {
+    state.service_filter.set(response.service_filter(), now_ms);
+    state.in_defrost.set(response.in_defrost(), now_ms);
+    state.in_preheat.set(response.in_preheat(), now_ms);
+    state.in_standby.set(response.in_standby(), now_ms);
+    state.actual_fan_speed.set(response.get_actual_fan_speed(), now_ms);
+    state.auto_mode.set(response.get_auto_mode(), now_ms);
+  });
+}
+
+void HeatPumpStateStore::update(const ErrorStateGetResponseView &response, uint32_t now_ms) {
+  state_.update([&](HeatPumpState &state) {
+    state.error_code.set(response.get_error_code(), now_ms);
+    state.raw_short_code.set(response.get_raw_short_code(), now_ms);
+    state.error_present.set(response.error_present(), now_ms);
+  });
+}
+
+void HeatPumpStateStore::update(const CapabilitiesResponseView &response, uint32_t now_ms) {
+  state_.update([&](HeatPumpState &state) {
+    state.min_cool_dry_setpoint.set(response.get_min_cool_dry_setpoint(), now_ms);
+    state.max_cool_dry_setpoint.set(response.get_max_cool_dry_setpoint(), now_ms);
+    state.min_heating_setpoint.set(response.get_min_heating_setpoint(), now_ms);
+    state.max_heating_setpoint.set(response.get_max_heating_setpoint(), now_ms);
+    state.min_auto_setpoint.set(response.get_min_auto_setpoint(), now_ms);
+    state.max_auto_setpoint.set(response.get_max_auto_setpoint(), now_ms);
+    state.supported_fan_speeds.set(response.get_supported_fan_speeds(), now_ms);
+    state.heat_disabled.set(response.is_heat_disabled(), now_ms);
+    state.dry_disabled.set(response.is_dry_disabled(), now_ms);
+    state.fan_disabled.set(response.is_fan_disabled(), now_ms);
+    state.supports_vane.set(response.supports_vane(), now_ms);
+    state.supports_vane_swing.set(response.supports_vane_swing(), now_ms);
+  });
+}
+
+bool HeatPumpStateStore::process_frame(const RawPacketView &frame, uint32_t now_ms) {
+  const uint8_t *bytes = frame.get_bytes();
+  uint8_t length = frame.get_length();
+
+  switch (classify_packet(frame.get_packet_type(), frame.get_command())) {
+    case PacketKind::SETTINGS_GET_RESPONSE:
+      update(SettingsGetResponseView(bytes, length), now_ms);
+      return true;
+    case PacketKind::CURRENT_TEMP_GET_RESPONSE:
+      update(CurrentTempGetResponseView(bytes, length), now_ms);
+      return true;
+    case PacketKind::STATUS_GET_RESPONSE:
+      update(StatusGetResponseView(bytes, length), now_ms);
+      return true;
+    case PacketKind::RUN_STATE_GET_RESPONSE:
+      update(RunStateGetResponseView(bytes, length), now_ms);
+      return true;
+    case PacketKind::ERROR_STATE_GET_RESPONSE:
+      update(ErrorStateGetResponseView(bytes, length), now_ms);
+      return true;
+    case PacketKind::CAPABILITIES_RESPONSE:
+      update(CapabilitiesResponseView(bytes, length), now_ms);
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace itp_packet
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cmath>
+#include "itp_packets.h"
+#include "itp_rawpacketview.h"
+#include "itp_seqlock.h"
+
+namespace itp_packet {
+
+// A decoded value and when it was last received (in the caller's clock, e.g. millis()).  received is false until
+// the first packet carrying the value arrives.
+template<typename T> struct Timestamped {
+  T value{};
+  uint32_t updated_ms = 0;
+  bool received = false;
+
+  void set(T new_value, uint32_t now_ms) {
+    value = new_value;
+    updated_ms = now_ms;
+    received = true;
+  }
+  // Milliseconds since the value was last received (meaningless if it never was)
+  uint32_t age_ms(uint32_t now_ms) const { return now_ms - updated_ms; }
+};
+
+// Everything known about a heat pump, gathered from the responses it has sent
+struct HeatPumpState {
+  // SettingsGetResponse
+  Timestamped<uint8_t> power;
+  Timestamped<uint8_t> mode;
+  Timestamped<float> target_temp;
+  Timestamped<uint8_t> fan;
+  Timestamped<uint8_t> vane;
+  Timestamped<uint8_t> horizontal_vane;
+  Timestamped<bool> horizontal_vane_msb;
+  Timestamped<bool> i_see_enabled;
+  Timestamped<uint8_t> prohibit_flags;  // Bit 0 power, bit 1 mode, bit 2 temperature
+
+  // CurrentTempGetResponse
+  Timestamped<float> room_temp;
+  Timestamped<float> outdoor_temp;  // NAN if the unit doesn't report it
+  Timestamped<uint32_t> runtime_minutes;
+
+  // StatusGetResponse
+  Timestamped<uint8_t> compressor_frequency;
+  Timestamped<bool> operating;
+  Timestamped<uint16_t> input_watts;
+  Timestamped<float> lifetime_kwh;
+
+  // RunStateGetResponse
+  Timestamped<bool> service_filter;
+  Timestamped<bool> in_defrost;
+  Timestamped<bool> in_preheat;
+  Timestamped<bool> in_standby;
+  Timestamped<uint8_t> actual_fan_speed;
+  Timestamped<uint8_t> auto_mode;
+
+  // ErrorStateGetResponse
+  Timestamped<uint16_t> error_code;
+  Timestamped<uint8_t> raw_short_code;
+  Timestamped<bool> error_present;
+
+  // CapabilitiesResponse
+  Timestamped<float> min_cool_dry_setpoint;
+  Timestamped<float> max_cool_dry_setpoint;
+  Timestamped<float> min_heating_setpoint;
+  Timestamped<float> max_heating_setpoint;
+  Timestamped<float> min_auto_setpoint;
+  Timestamped<float> max_auto_setpoint;
+  Timestamped<uint8_t> supported_fan_speeds;
+  Timestamped<bool> heat_disabled;
+  Timestamped<bool> dry_disabled;
+  Timestamped<bool> fan_disabled;
+  Timestamped<bool> supports_vane;
+  Timestamped<bool> supports_vane_swing;
+};
+
+/* Maintains a HeatPumpState from the responses a heat pump sends, and lets other threads read consistent snapshots
+of it without ever blocking the thread doing the decoding.  Each update() (or process_frame()) writes only the fields
+carried by that response, stamping them with now_ms; readers take whole-state copies through a SeqLock.
+
+update() and process_frame() must only be called from one thread (normally the one reading the UART); snapshot()
+may be called from any number of threads.
+*/
+class HeatPumpStateStore {
+ public:
+  void update(const SettingsGetResponseView &response, uint32_t now_ms);
+  void update(const CurrentTempGetResponseView &response, uint32_t now_ms);
+  void update(const StatusGetResponseView &response, uint32_t now_ms);
+  void update(const RunStateGetResponseView &response, uint32_t now_ms);
+  void update(const ErrorStateGetResponseView &response, uint32_t now_ms);
+  void update(const CapabilitiesResponseView &response, uint32_t now_ms);
+
+  template<typename P> auto update(const P &packet, uint32_t now_ms) -> decltype(packet.view(), void()) {
+    update(packet.view(), now_ms);
+  }
+
+  // Classifies a received frame and applies it if it's one of the responses above.  Returns false (changing
+  // nothing) for any other frame.
+  bool process_frame(const RawPacketView &frame, uint32_t now_ms);
+
+  // A consistent copy of the whole state
+  HeatPumpState snapshot() const { return state_.read(); }
+  // Changes every time the state is updated, so readers can skip copying an unchanged state
+  uint32_t get_version() const { return state_.get_sequence(); }
+
+ private:
+  SeqLock<HeatPumpState> state_;
+};
+
+}  // namespace itp_packet
@@ -11,60 +11,65 @@ Packet::Packet() {
 //   return format_hex_pretty(&pkt_.getBytes()[0], pkt_.getLength());
 // }
 
-static char format_hex_pretty_char(uint8_t v) { return v >= 10 ? 'A' + (v - 10) : '0' + v; }
-
 std::string Packet::to_string() const {
+  char buffer[PACKET_FORMAT_BUFFER_SIZE];
+  size_t length = format(buffer, sizeof(buffer));
+  return std::string(buffer, length);
+}
+
+size_t Packet::format(char *buffer, size_t size, bool use_colors) const {
+  PacketFormatter out(buffer, size, use_colors);
+  format_to(out);
+  return out.length();
+}
+
+void Packet::format_to(PacketFormatter &out) const {
   // Based on `format_hex_pretty` from ESPHome
   if (pkt_.get_length() < PACKET_HEADER_SIZE)
-    return "";
-  std::stringstream stream;
+    return;
 
-  stream << CONSOLE_COLOR_GRAY;
-  stream << '(' << std::to_string(this->get_sequence()) << ')';
+  out.append_color(CONSOLE_COLOR_GRAY);
+  out.append('(').append_uint(this->get_sequence()).append(')');
 
-  stream << CONSOLE_COLOR_CYAN;
-  stream << '[';
+  out.append_color(CONSOLE_COLOR_CYAN);
+  out.append('[');
 
   for (size_t i = 0; i < PACKET_HEADER_SIZE; i++) {
     if (i == 1) {
-      stream << CONSOLE_COLOR_CYAN_BOLD;
+      out.append_color(CONSOLE_COLOR_CYAN_BOLD);
     }
-    stream << format_hex_pretty_char((pkt_.get_bytes()[i] & 0xF0) >> 4);
-    stream << format_hex_pretty_char(pkt_.get_bytes()[i] & 0x0F);
+    out.append_hex_pretty(pkt_.get_bytes()[i]);
     if (i < PACKET_HEADER_SIZE - 1) {
-      stream << '.';
+      out.append('.');
     }
     if (i == 1) {
-      stream << CONSOLE_COLOR_CYAN;
+      out.append_color(CONSOLE_COLOR_CYAN);
     }
   }
   // Header close-bracket
-  stream << ']';
-  stream << CONSOLE_COLOR_WHITE;  // White
+  out.append(']');
+  out.append_color(CONSOLE_COLOR_WHITE);  // White
 
   // Payload
   for (size_t i = PACKET_HEADER_SIZE; i < pkt_.get_length() - 1; i++) {
-    stream << format_hex_pretty_char((pkt_.get_bytes()[i] & 0xF0) >> 4);
-    stream << format_hex_pretty_char(pkt_.get_bytes()[i] & 0x0F);
+    out.append_hex_pretty(pkt_.get_bytes()[i]);
     if (i < pkt_.get_length() - 2) {
-      stream << '.';
+      out.append('.');
     }
   }
 
   // Space
-  stream << ' ';
-  stream << CONSOLE_COLOR_GREEN;  // Green
+  out.append(' ');
+  out.append_color(CONSOLE_COLOR_GREEN);  // Green
 
   // Checksum
-  stream << format_hex_pretty_char((pkt_.get_bytes()[pkt_.get_length() - 1] & 0xF0) >> 4);
-  stream << format_hex_pretty_char(pkt_.get_bytes()[pkt_.get_length() - 1] & 0x0F);
-
-  stream << CONSOLE_COLOR_NONE;  // Reset
+  out.append_hex_pretty(pkt_.get_bytes()[pkt_.get_length() - 1]);
 
-  return stream.str();
+  out.append_color(CONSOLE_COLOR_NONE);  // Reset
 }
 
 void Packet::set_flags(const uint8_t flag_value) { pkt_.set_payload_byte(PLINDEX_FLAGS, flag_value); }
+void Packet::set_flags_2(const uint8_t flag2_value) { pkt_.set_payload_byte(PLINDEX_FLAGS2, flag2_value); }
 
 // Adds a flag (ONLY APPLICABLE FOR SOME COMMANDS)
 void Packet::add_flag(const uint8_t flag_to_add) {
@@ -1,10 +1,14 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstring>
 #include <sstream>
 #include <string>
+#include <utility>
+#include "itp_packetformatter.h"
 #include "itp_rawpacket.h"
+#include "itp_rawpacketview.h"
 #include "itp_utils.h"
 
 namespace itp_packet {
@@ -33,11 +37,17 @@ class PacketProcessor;
 // Generic Base Packet wrapper over RawPacket
 class Packet {
  public:
-  Packet(RawPacket &&pkt) : pkt_(pkt){};  // TODO: Confirm this needs std::move if call to constructor ALSO has move
-  Packet();                               // For optional<> construction
+  Packet(RawPacket &&pkt) : pkt_(std::move(pkt)){};
+  Packet();  // For optional<> construction
 
   // Returns a (more) human-readable string of the packet
   virtual std::string to_string() const;
+  // Writes the same description as to_string() into buffer without allocating, returning the number of characters
+  // written (not counting the terminating NUL).  Output is truncated to fit.
+  size_t format(char *buffer, size_t size, bool use_colors = true) const;
+  // Appends the description to an existing formatter; subclasses override this to describe their fields.  The base
+  // implementation writes the sequence number and the frame bytes.
+  virtual void format_to(PacketFormatter &out) const;
 
   // Is a response packet expected when this packet is sent.  Defaults to true since
   // most requests receive a response.
@@ -46,6 +56,9 @@ class Packet {
 
   // Passthrough methods to RawPacket
   RawPacket &raw_packet() { return pkt_; };
+  const RawPacket &raw_packet() const { return pkt_; };
+  // Non-owning view over this packet's bytes; valid for the packet's lifetime
+  RawPacketView raw_view() const { return RawPacketView(pkt_); }
   uint8_t get_packet_type() const { return pkt_.get_packet_type(); }
   bool is_checksum_valid() const { return pkt_.is_checksum_valid(); };
 
@@ -55,6 +68,7 @@ class Packet {
   uint8_t get_flags_2() const { return pkt_.get_payload_byte(PLINDEX_FLAGS2); }
   // Sets flags (ONLY APPLICABLE FOR SOME COMMANDS)
   void set_flags(uint8_t flag_value);
+  void set_flags_2(uint8_t flag2_value);
   // Adds a flag (ONLY APPLICABLE FOR SOME COMMANDS)
   void add_flag(uint8_t flag_to_add);
   // Adds a flag2 (ONLY APPLICABLE FOR SOME COMMANDS)
@@ -71,8 +85,9 @@ class Packet {
   static const int PLINDEX_FLAGS2 = 2;
 
   RawPacket pkt_;
-  static inline uint8_t next_seq_ = 0;
-  uint8_t sequence_num_ = next_seq_++;  // Assign a new sequencenumber (not guaranteed contiguous)
+  static inline std::atomic<uint8_t> next_seq_{0};
+  // Assign a new sequence number (not guaranteed contiguous).  Use a TransactionTracker for per-link sequences.
+  uint8_t sequence_num_ = next_seq_.fetch_add(1, std::memory_order_relaxed);
 
  private:
   bool response_expected_ = true;
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <utility>
+#include "itp_packets.h"
+
+namespace itp_packet {
+
+// Every packet class the library knows how to build from a RawPacket
+enum class PacketKind : uint8_t {
+  UNKNOWN,
+  CONNECT_REQUEST,
+  CONNECT_RESPONSE,
+  CAPABILITIES_REQUEST,
+  CAPABILITIES_RESPONSE,
+  IDENTIFY_CD_REQUEST,
+  IDENTIFY_CD_RESPONSE,
+  GET_REQUEST,
+  THERMOSTAT_STATE_DOWNLOAD_REQUEST,
+  THERMOSTAT_AB_GET_REQUEST,
+  SETTINGS_GET_RESPONSE,
+  CURRENT_TEMP_GET_RESPONSE,
+  ERROR_STATE_GET_RESPONSE,
+  STATUS_GET_RESPONSE,
+  RUN_STATE_GET_RESPONSE,
+  FUNCTIONS_1_GET_RESPONSE,
+  FUNCTIONS_2_GET_RESPONSE,
+  THERMOSTAT_STATE_DOWNLOAD_RESPONSE,
+  THERMOSTAT_AB_GET_RESPONSE,
+  SETTINGS_SET_REQUEST,
+  REMOTE_TEMPERATURE_SET_REQUEST,
+  THERMOSTAT_SENSOR_STATUS,
+  THERMOSTAT_HELLO,
+  THERMOSTAT_STATE_UPLOAD,
+  THERMOSTAT_AA_SET_REQUEST,
+  SET_RESPONSE,
+};
+
+// Classifies a packet by its type and command bytes.  Everything the library recognizes is listed here, so all
+// integrations agree on which class a given frame belongs to.
+constexpr PacketKind classify_packet(const uint8_t packet_type, const uint8_t command) {
+  switch (static_cast<PacketType>(packet_type)) {
+    case PacketType::CONNECT_REQUEST:
+      return PacketKind::CONNECT_REQUEST;
+    case PacketType::CONNECT_RESPONSE:
+      return PacketKind::CONNECT_RESPONSE;
+
+    case PacketType::IDENTIFY_REQUEST:
+      switch (command) {
+        case IDENTIFY_COMMAND_CAPABILITIES:
+          return PacketKind::CAPABILITIES_REQUEST;
+        case IDENTIFY_COMMAND_CD:
+          return PacketKind::IDENTIFY_CD_REQUEST;
+        default:
+          return PacketKind::UNKNOWN;
+      }
+    case PacketType::IDENTIFY_RESPONSE:
+      switch (command) {
+        case IDENTIFY_COMMAND_CAPABILITIES:
+          return PacketKind::CAPABILITIES_RESPONSE;
+        case IDENTIFY_COMMAND_CD:
+          return PacketKind::IDENTIFY_CD_RESPONSE;
+        default:
+          return PacketKind::UNKNOWN;
+      }
+
+    case PacketType::GET_REQUEST:
+      switch (static_cast<GetCommand>(command)) {
+        case GetCommand::THERMOSTAT_STATE_DOWNLOAD:
+          return PacketKind::THERMOSTAT_STATE_DOWNLOAD_REQUEST;
+        case GetCommand::THERMOSTAT_GET_AB:
+          return PacketKind::THERMOSTAT_AB_GET_REQUEST;
+        default:
+          return PacketKind::GET_REQUEST;
+      }
+    case PacketType::GET_RESPONSE:
+      switch (static_cast<GetCommand>(command)) {
+        case GetCommand::SETTINGS:
+          return PacketKind::SETTINGS_GET_RESPONSE;
+        case GetCommand::CURRENT_TEMP:
+          return PacketKind::CURRENT_TEMP_GET_RESPONSE;
+        case GetCommand::ERROR_INFO:
+          return PacketKind::ERROR_STATE_GET_RESPONSE;
+        case GetCommand::STATUS:
+          return PacketKind::STATUS_GET_RESPONSE;
+        case GetCommand::RUN_STATE:
+          return PacketKind::RUN_STATE_GET_RESPONSE;
+        case GetCommand::FUNCTIONS_1:
+          return PacketKind::FUNCTIONS_1_GET_RESPONSE;
+        case GetCommand::FUNCTIONS_2:
+          return PacketKind::FUNCTIONS_2_GET_RESPONSE;
+        case GetCommand::THERMOSTAT_STATE_DOWNLOAD:
+          return PacketKind::THERMOSTAT_STATE_DOWNLOAD_RESPONSE;
+        case GetCommand::THERMOSTAT_GET_AB:
+          return PacketKind::THERMOSTAT_AB_GET_RESPONSE;
+        default:
+          return PacketKind::UNKNOWN;
+      }
+
+    case PacketType::SET_REQUEST:
+      switch (static_cast<SetCommand>(command)) {
+        case SetCommand::SETTINGS:
+          return PacketKind::SETTINGS_SET_REQUEST;
+        case SetCommand::REMOTE_TEMPERATURE:
+          return PacketKind::REMOTE_TEMPERATURE_SET_REQUEST;
+        case SetCommand::THERMOSTAT_SENSOR_STATUS:
+          return PacketKind::THERMOSTAT_SENSOR_STATUS;
+        case SetCommand::THERMOSTAT_HELLO:
+          return PacketKind::THERMOSTAT_HELLO;
+        case SetCommand::THERMOSTAT_STATE_UPLOAD:
+          return PacketKind::THERMOSTAT_STATE_UPLOAD;
+        case SetCommand::THERMOSTAT_SET_AA:
+          return PacketKind::THERMOSTAT_AA_SET_REQUEST;
+        default:
+          return PacketKind::UNKNOWN;
+      }
+    case PacketType::SET_RESPONSE:
+      return PacketKind::SET_RESPONSE;
+
+    default:
+      return PacketKind::UNKNOWN;
+  }
+}
+
+// Maps a PacketKind to the class used to wrap it
+template<PacketKind KIND> struct PacketKindTraits {
+  using type = Packet;
+};
+
+#define ITP_PACKET_KIND_TYPE(kind, packet_class) \
+  template<> struct PacketKindTraits<PacketKind::kind> { \
+    using type = packet_class; \
+  };
+
+ITP_PACKET_KIND_TYPE(CONNECT_REQUEST, ConnectRequestPacket)
+ITP_PACKET_KIND_TYPE(CONNECT_RESPONSE, ConnectResponsePacket)
+ITP_PACKET_KIND_TYPE(CAPABILITIES_REQUEST, CapabilitiesRequestPacket)
+ITP_PACKET_KIND_TYPE(CAPABILITIES_RESPONSE, CapabilitiesResponsePacket)
+ITP_PACKET_KIND_TYPE(IDENTIFY_CD_REQUEST, IdentifyCDRequestPacket)
+ITP_PACKET_KIND_TYPE(IDENTIFY_CD_RESPONSE, IdentifyCDResponsePacket)
+ITP_PACKET_KIND_TYPE(GET_REQUEST, GetRequestPacket)
+ITP_PACKET_KIND_TYPE(THERMOSTAT_STATE_DOWNLOAD_REQUEST, GetRequestPacket)
+ITP_PACKET_KIND_TYPE(THERMOSTAT_AB_GET_REQUEST, GetRequestPacket)
+ITP_PACKET_KIND_TYPE(SETTINGS_GET_RESPONSE, SettingsGetResponsePacket)
+ITP_PACKET_KIND_TYPE(CURRENT_TEMP_GET_RESPONSE, CurrentTempGetResponsePacket)
+ITP_PACKET_KIND_TYPE(ERROR_STATE_GET_RESPONSE, ErrorStateGetResponsePacket)
+ITP_PACKET_KIND_TYPE(STATUS_GET_RESPONSE, StatusGetResponsePacket)
+ITP_PACKET_KIND_TYPE(RUN_STATE_GET_RESPONSE, RunStateGetResponsePacket)
+ITP_PACKET_KIND_TYPE(FUNCTIONS_1_GET_RESPONSE, Functions1GetResponsePacket)
+ITP_PACKET_KIND_TYPE(FUNCTIONS_2_GET_RESPONSE, Functions2GetResponsePacket)
+ITP_PACKET_KIND_TYPE(THERMOSTAT_STATE_DOWNLOAD_RESPONSE, ThermostatStateDownloadResponsePacket)
+ITP_PACKET_KIND_TYPE(THERMOSTAT_AB_GET_RESPONSE, ThermostatABGetResponsePacket)
+ITP_PACKET_KIND_TYPE(SETTINGS_SET_REQUEST, SettingsSetRequestPacket)
+ITP_PACKET_KIND_TYPE(REMOTE_TEMPERATURE_SET_REQUEST, RemoteTemperatureSetRequestPacket)
+ITP_PACKET_KIND_TYPE(THERMOSTAT_SENSOR_STATUS, ThermostatSensorStatusPacket)
+ITP_PACKET_KIND_TYPE(THERMOSTAT_HELLO, ThermostatHelloPacket)
+ITP_PACKET_KIND_TYPE(THERMOSTAT_STATE_UPLOAD, ThermostatStateUploadPacket)
+ITP_PACKET_KIND_TYPE(THERMOSTAT_AA_SET_REQUEST, ThermostatAASetRequestPacket)
+ITP_PACKET_KIND_TYPE(SET_RESPONSE, SetResponsePacket)
+
+#undef ITP_PACKET_KIND_TYPE
+
+namespace dispatch_detail {
+// Builds the typed packet and hands it to the handler, but only if the handler can accept it.  Handler overloads
+// are resolved at compile time, so kinds the handler doesn't care about never construct a packet at all.
+template<PacketKind KIND, typename Handler> inline bool deliver(Handler &handler, RawPacket &&pkt) {
+  using PacketClass = typename PacketKindTraits<KIND>::type;
+
+  if constexpr (KIND == PacketKind::THERMOSTAT_STATE_DOWNLOAD_REQUEST &&
+                requires(const PacketClass &packet) { handler.handle_thermostat_state_download_request(packet); }) {
+    handler.handle_thermostat_state_download_request(PacketClass(std::move(pkt)));
+    return true;
+  } else if constexpr (KIND == PacketKind::THERMOSTAT_AB_GET_REQUEST &&
+                       requires(const PacketClass &packet) { handler.handle_thermostat_ab_get_request(packet); }) {
+    handler.handle_thermostat_ab_get_request(PacketClass(std::move(pkt)));
+    return true;
+  } else if constexpr (requires(const PacketClass &packet) { handler.process_packet(packet); }) {
+    handler.process_packet(PacketClass(std::move(pkt)));
+    return true;
+  } else {
+    return false;
+  }
+}
+}  // namespace dispatch_detail
+
+/* Classifies pkt, wraps it in the matching Packet subclass (on the stack) and calls the handler with it.
+
+The handler can be any type with `process_packet(const X &)` overloads for the packet classes it cares about
+(plus, optionally, the `handle_thermostat_*_request(const GetRequestPacket &)` hooks from PacketProcessor).  Calls
+are bound statically, so a handler that isn't a PacketProcessor pays no virtual dispatch, and kinds without a
+matching overload compile down to nothing.  Unrecognized packets are passed as a plain Packet.
+
+Returns true if the handler accepted the packet.
+*/
+template<typename Handler> inline bool dispatch_packet(Handler &handler, RawPacket &&pkt) {
+  using dispatch_detail::deliver;
+
+  switch (classify_packet(pkt.get_packet_type(), pkt.get_command())) {
+    case PacketKind::CONNECT_REQUEST:
+      return deliver<PacketKind::CONNECT_REQUEST>(handler, std::move(pkt));
+    case PacketKind::CONNECT_RESPONSE:
+      return deliver<PacketKind::CONNECT_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::CAPABILITIES_REQUEST:
+      return deliver<PacketKind::CAPABILITIES_REQUEST>(handler, std::move(pkt));
+    case PacketKind::CAPABILITIES_RESPONSE:
+      return deliver<PacketKind::CAPABILITIES_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::IDENTIFY_CD_REQUEST:
+      return deliver<PacketKind::IDENTIFY_CD_REQUEST>(handler, std::move(pkt));
+    case PacketKind::IDENTIFY_CD_RESPONSE:
+      return deliver<PacketKind::IDENTIFY_CD_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::GET_REQUEST:
+      return deliver<PacketKind::GET_REQUEST>(handler, std::move(pkt));
+    case PacketKind::THERMOSTAT_STATE_DOWNLOAD_REQUEST:
+      return deliver<PacketKind::THERMOSTAT_STATE_DOWNLOAD_REQUEST>(handler, std::move(pkt));
+    case PacketKind::THERMOSTAT_AB_GET_REQUEST:
+      return deliver<PacketKind::THERMOSTAT_AB_GET_REQUEST>(handler, std::move(pkt));
+    case PacketKind::SETTINGS_GET_RESPONSE:
+      return deliver<PacketKind::SETTINGS_GET_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::CURRENT_TEMP_GET_RESPONSE:
+      return deliver<PacketKind::CURRENT_TEMP_GET_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::ERROR_STATE_GET_RESPONSE:
+      return deliver<PacketKind::ERROR_STATE_GET_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::STATUS_GET_RESPONSE:
+      return deliver<PacketKind::STATUS_GET_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::RUN_STATE_GET_RESPONSE:
+      return deliver<PacketKind::RUN_STATE_GET_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::FUNCTIONS_1_GET_RESPONSE:
+      return deliver<PacketKind::FUNCTIONS_1_GET_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::FUNCTIONS_2_GET_RESPONSE:
+      return deliver<PacketKind::FUNCTIONS_2_GET_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::THERMOSTAT_STATE_DOWNLOAD_RESPONSE:
+      return deliver<PacketKind::THERMOSTAT_STATE_DOWNLOAD_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::THERMOSTAT_AB_GET_RESPONSE:
+      return deliver<PacketKind::THERMOSTAT_AB_GET_RESPONSE>(handler, std::move(pkt));
+    case PacketKind::SETTINGS_SET_REQUEST:
+      return deliver<PacketKind::SETTINGS_SET_REQUEST>(handler, std::move(pkt));
+    case PacketKind::REMOTE_TEMPERATURE_SET_REQUEST:
+      return deliver<PacketKind::REMOTE_TEMPERATURE_SET_REQUEST>(handler, std::move(pkt));
+    case PacketKind::THERMOSTAT_SENSOR_STATUS:
+      return deliver<PacketKind::THERMOSTAT_SENSOR_STATUS>(handler, std::move(pkt));
+    case PacketKind::THERMOSTAT_HELLO:
+      return deliver<PacketKind::THERMOSTAT_HELLO>(handler, std::move(pkt));
+    case PacketKind::THERMOSTAT_STATE_UPLOAD:
+      return deliver<PacketKind::THERMOSTAT_STATE_UPLOAD>(handler, std::move(pkt));
+    case PacketKind::THERMOSTAT_AA_SET_REQUEST:
+      return deliver<PacketKind::THERMOSTAT_AA_SET_REQUEST>(handler, std::move(pkt));
+    case PacketKind::SET_RESPONSE:
+      return deliver<PacketKind::SET_RESPONSE>(handler, std::move(pkt));
+    default:
+      return deliver<PacketKind::UNKNOWN>(handler, std::move(pkt));
+  }
+}
+
+// CRTP base for handlers that want a dispatch() member, e.g. `class MyBridge : public PacketDispatcher<MyBridge>`.
+template<typename Derived> class PacketDispatcher {
+ public:
+  bool dispatch(RawPacket &&pkt) { return dispatch_packet(static_cast<Derived &>(*this), std::move(pkt)); }
+};
+
+}  // namespace itp_packet
@@ -0,0 +1,77 @@
+#include "itp_packetformatter.h"
+
+#include <cstdio>
+#include <cstring>
+#include "itp_utils.h"
+
+namespace itp_packet {
+
+PacketFormatter::PacketFormatter(char *buffer, size_t size, bool use_colors)
+    : buffer_{buffer}, size_{size}, use_colors_{use_colors} {
+  if (size_ > 0)
+    buffer_[0] = '\0';
+}
+
+PacketFormatter &PacketFormatter::append(const char *str, size_t length) {
+  if (size_ == 0) {
+    truncated_ |= length > 0;
+    return *this;
+  }
+
+  size_t space = size_ - 1 - length_;
+  if (length > space) {
+    length = space;
+    truncated_ = true;
+  }
+
+  memcpy(&buffer_[length_], str, length);
+  length_ += length;
+  buffer_[length_] = '\0';
+  return *this;
+}
+
+PacketFormatter &PacketFormatter::append(const char *str) { return append(str, strlen(str)); }
+
+PacketFormatter &PacketFormatter::append(char c) { return append(&c, 1); }
+
+PacketFormatter &PacketFormatter::append_uint(uint32_t value) {
+  char digits[10];
+  size_t count = 0;
+  do {
+    digits[sizeof(digits) - 1 - count++] = '0' + (value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  return append(&digits[sizeof(digits) - count], count);
+}
+
+PacketFormatter &PacketFormatter::append_int(int32_t value) {
+  if (value < 0) {
+    append('-');
+    return append_uint(0u - (uint32_t) value);
+  }
+  return append_uint(value);
+}
+
+PacketFormatter &PacketFormatter::append_float(float value) {
+  char digits[64];
+  int count = snprintf(digits, sizeof(digits), "%f", value);
+  return append(digits, count > 0 ? count : 0);
+}
+
+PacketFormatter &PacketFormatter::append_hex(uint8_t value) {
+  char digits[2] = {ITPUtils::format_hex_char(value >> 4), ITPUtils::format_hex_char(value & 0x0F)};
+  return append(digits, sizeof(digits));
+}
+
+PacketFormatter &PacketFormatter::append_hex(uint16_t value) {
+  append_hex((uint8_t) (value >> 8));
+  return append_hex((uint8_t) (value & 0xFF));
+}
+
+PacketFormatter &PacketFormatter::append_hex_pretty(uint8_t value) {
+  char digits[2] = {ITPUtils::format_hex_pretty_char(value >> 4), ITPUtils::format_hex_pretty_char(value & 0x0F)};
+  return append(digits, sizeof(digits));
+}
+
+}  // namespace itp_packet
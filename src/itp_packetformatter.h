@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace itp_packet {
+
+// Large enough for the longest description any of the library's packets produce
+static const size_t PACKET_FORMAT_BUFFER_SIZE = 512;
+
+/* Appends text to a caller-supplied char buffer without allocating, for logging packets.  Output that doesn't fit
+is truncated, the buffer is always kept NUL-terminated, and length() reports the number of characters written.
+Numbers are formatted the same way std::to_string and ITPUtils::format_hex would format them.
+*/
+class PacketFormatter {
+ public:
+  PacketFormatter(char *buffer, size_t size, bool use_colors = true);
+
+  PacketFormatter &append(const char *str);
+  PacketFormatter &append(const char *str, size_t length);
+  PacketFormatter &append(char c);
+  // Appends an ANSI color sequence, unless colors are disabled
+  PacketFormatter &append_color(const char *color) { return use_colors_ ? append(color) : *this; }
+  PacketFormatter &append_yes_no(bool value) { return append(value ? "Yes" : "No"); }
+
+  // Decimal, as std::to_string
+  PacketFormatter &append_uint(uint32_t value);
+  PacketFormatter &append_int(int32_t value);
+  // Fixed with six decimals, as std::to_string
+  PacketFormatter &append_float(float value);
+  // Lowercase hex, most significant byte first, as ITPUtils::format_hex
+  PacketFormatter &append_hex(uint8_t value);
+  PacketFormatter &append_hex(uint16_t value);
+  // Two uppercase hex digits, as ITPUtils::format_hex_pretty
+  PacketFormatter &append_hex_pretty(uint8_t value);
+
+  size_t length() const { return length_; }
+  bool is_truncated() const { return truncated_; }
+  bool use_colors() const { return use_colors_; }
+  const char *c_str() const { return buffer_; }
+
+ private:
+  char *buffer_;
+  size_t size_;
+  size_t length_ = 0;
+  bool use_colors_;
+  bool truncated_ = false;
+};
+
+}  // namespace itp_packet
@@ -0,0 +1,141 @@
+#include "itp_packetframer.h"
+
+namespace itp_packet {
+
+size_t PacketFramer::scan_(const uint8_t *data, size_t length, const uint8_t *&frame, uint8_t &frame_length) {
+  frame = nullptr;
+  size_t pos = 0;
+
+  // Bytes left behind a frame emitted from the buffer on the previous call are moved to the front and rescanned
+  if (head_ > 0) {
+    memmove(buffer_, &buffer_[head_], tail_ - head_);
+    tail_ -= head_;
+    head_ = 0;
+    skip_to_sync_(0);
+  }
+
+  while (true) {
+    if (tail_ == 0) {
+      // Nothing buffered, so hunt for the next sync byte in the input
+      if (pos >= length)
+        return pos;
+
+      auto *sync = static_cast<const uint8_t *>(memchr(&data[pos], BYTE_CONTROL, length - pos));
+      if (sync == nullptr) {
+        count_skipped_(length - pos);
+        return length;
+      }
+      count_skipped_(sync - &data[pos]);
+      pos = sync - data;
+      resyncing_ = false;
+
+      // Fast path: the whole frame is in this chunk, so validate it in place
+      size_t available = length - pos;
+      if (available >= PACKET_HEADER_SIZE) {
+        uint8_t size = frame_size_(data[pos + PACKET_HEADER_INDEX_PAYLOAD_LENGTH]);
+        if (size == 0) {
+          stats_.length_errors++;
+          stats_.resynced_bytes++;
+          resyncing_ = true;
+          pos++;
+          continue;
+        }
+
+        if (available >= size) {
+          if (data[pos + size - 1] == RawPacket::calculate_checksum(&data[pos], size - 1)) {
+            frame = &data[pos];
+            frame_length = size;
+            stats_.frames++;
+            return pos + size;
+          }
+
+          stats_.checksum_errors++;
+          stats_.resynced_bytes++;
+          resyncing_ = true;
+          pos++;
+          continue;
+        }
+      }
+    }
+
+    // Frame is split across chunks (or being rescanned), so collect the header and then the rest in buffer_
+    if (tail_ < PACKET_HEADER_SIZE) {
+      pos += take_(&data[pos], length - pos, PACKET_HEADER_SIZE);
+      if (tail_ < PACKET_HEADER_SIZE)
+        return pos;
+    }
+
+    uint8_t size = frame_size_(buffer_[PACKET_HEADER_INDEX_PAYLOAD_LENGTH]);
+    if (size == 0) {
+      stats_.length_errors++;
+      resync_();
+      continue;
+    }
+
+    if (tail_ < size) {
+      pos += take_(&data[pos], length - pos, size);
+      if (tail_ < size)
+        return pos;
+    }
+
+    if (buffer_[size - 1] == RawPacket::calculate_checksum(buffer_, size - 1)) {
+      frame = buffer_;
+      frame_length = size;
+      stats_.frames++;
+
+      // Anything buffered past the end of this frame is kept for the next call
+      if (tail_ > size) {
+        head_ = size;
+      } else {
+        tail_ = 0;
+      }
+      return pos;
+    }
+
+    stats_.checksum_errors++;
+    resync_();
+  }
+}
+
+size_t PacketFramer::take_(const uint8_t *data, size_t length, uint8_t target) {
+  size_t count = target - tail_;
+  if (count > length)
+    count = length;
+
+  memcpy(&buffer_[tail_], data, count);
+  tail_ += count;
+  return count;
+}
+
+void PacketFramer::resync_() {
+  resyncing_ = true;
+  skip_to_sync_(1);
+}
+
+void PacketFramer::skip_to_sync_(uint8_t from) {
+  if (from >= tail_) {
+    count_skipped_(tail_);
+    tail_ = 0;
+    return;
+  }
+
+  auto *sync = static_cast<const uint8_t *>(memchr(&buffer_[from], BYTE_CONTROL, tail_ - from));
+  uint8_t next = sync == nullptr ? tail_ : sync - buffer_;
+
+  count_skipped_(next);
+  memmove(buffer_, &buffer_[next], tail_ - next);
+  tail_ -= next;
+
+  if (sync != nullptr)
+    resyncing_ = false;
+}
+
+void PacketFramer::count_skipped_(size_t skipped) {
+  if (resyncing_) {
+    stats_.resynced_bytes += skipped;
+  } else {
+    stats_.dropped_bytes += skipped;
+  }
+}
+
+}  // namespace itp_packet
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "itp_rawpacket.h"
+#include "itp_rawpacketview.h"
+
+namespace itp_packet {
+
+// Counters describing what the framer has seen since construction (or the last reset_stats()).
+struct PacketFramerStats {
+  uint32_t frames = 0;           // Complete frames with a valid checksum
+  uint32_t checksum_errors = 0;  // Candidate frames rejected for a bad checksum
+  uint32_t length_errors = 0;    // Candidate frames rejected for a payload length that can't fit in a packet
+  uint32_t dropped_bytes = 0;    // Bytes discarded while hunting for a sync byte
+  uint32_t resynced_bytes = 0;   // Bytes discarded after a rejected candidate frame, until the next sync byte
+};
+
+/* Turns a raw stream of bytes (e.g. from a UART) into complete, checksum-validated RawPackets.  Input can be
+supplied in chunks of any size, and a frame split across chunks is held in a small internal buffer until it
+completes; no heap allocation is ever performed.  Frames that arrive whole inside a single chunk are validated in
+place without being buffered.
+
+If a candidate frame has an impossible length or a bad checksum, the framer drops its sync byte and rescans the
+buffered bytes for the next BYTE_CONTROL, so a single corrupted byte only costs the frame it was in.
+*/
+class PacketFramer {
+ public:
+  PacketFramer(SourceBridge source_bridge = SourceBridge::NONE,
+               ControllerAssociation controller_association = ControllerAssociation::MITP)
+      : source_bridge_{source_bridge}, controller_association_{controller_association} {}
+
+  // Feeds a chunk of received bytes to the framer, calling on_packet(RawPacket &&) for every complete frame found.
+  // Returns the number of packets emitted.
+  template<typename F> size_t feed(const uint8_t *data, size_t length, F &&on_packet) {
+    return feed_views(data, length, [&](const RawPacketView &view) {
+      on_packet(RawPacket(view.get_bytes(), view.get_length(), source_bridge_, controller_association_));
+    });
+  }
+
+  // As feed(), but calls on_frame(const RawPacketView &) without copying the frame.  The view points into either
+  // data or the framer's own buffer, and is only valid until on_frame returns.
+  template<typename F> size_t feed_views(const uint8_t *data, size_t length, F &&on_frame) {
+    size_t packets = 0;
+    const uint8_t *frame;
+    uint8_t frame_length;
+
+    do {
+      size_t consumed = scan_(data, length, frame, frame_length);
+      data += consumed;
+      length -= consumed;
+
+      if (frame != nullptr) {
+        on_frame(RawPacketView(frame, frame_length));
+        packets++;
+      }
+    } while (frame != nullptr);
+
+    return packets;
+  }
+
+  // Discards any partially received frame (e.g. after the serial port is reopened).
+  void reset() {
+    head_ = 0;
+    tail_ = 0;
+    resyncing_ = false;
+  }
+
+  // Number of bytes currently held towards an incomplete frame
+  uint8_t get_buffered_length() const { return tail_ - head_; }
+
+  const PacketFramerStats &get_stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+
+  SourceBridge get_source_bridge() const { return source_bridge_; }
+  ControllerAssociation get_controller_association() const { return controller_association_; }
+
+ private:
+  uint8_t buffer_[PACKET_MAX_SIZE]{};
+  uint8_t head_ = 0;  // Start of the candidate frame in buffer_
+  uint8_t tail_ = 0;  // End of buffered bytes in buffer_
+  bool resyncing_ = false;
+
+  SourceBridge source_bridge_;
+  ControllerAssociation controller_association_;
+  PacketFramerStats stats_;
+
+  // Returns the full frame size for a payload length, or 0 if the frame would not fit in a packet.
+  static uint8_t frame_size_(uint8_t payload_length) {
+    return payload_length > PACKET_MAX_SIZE - PACKET_HEADER_SIZE - 1 ? 0 : payload_length + PACKET_HEADER_SIZE + 1;
+  }
+
+  // Consumes bytes from data until a complete frame is found or data runs out, and returns the number of bytes
+  // consumed.  On finding a frame, frame/frame_length point at it (in either data or buffer_) until the next call;
+  // otherwise frame is set to nullptr.
+  size_t scan_(const uint8_t *data, size_t length, const uint8_t *&frame, uint8_t &frame_length);
+  // Appends up to (target - buffered) bytes to buffer_, returning the number of bytes taken from data.
+  size_t take_(const uint8_t *data, size_t length, uint8_t target);
+  // Rejects the buffered candidate frame, dropping its sync byte and rescanning from the next one (if any)
+  void resync_();
+  // Discards buffered bytes from the front until one at or after index `from` is a sync byte
+  void skip_to_sync_(uint8_t from);
+  // Counts bytes skipped while looking for a sync byte against the appropriate counter
+  void count_skipped_(size_t skipped);
+};
+
+}  // namespace itp_packet
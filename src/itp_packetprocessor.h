@@ -3,6 +3,8 @@
 #include "itp_packets.h"
 
 namespace itp_packet {
+// Receives typed packets from dispatch_packet() (see itp_packetdispatch.h).  Handlers that don't need runtime
+// polymorphism can skip this interface and just declare the process_packet overloads they care about.
 class PacketProcessor {
  public:
   virtual void process_packet(const Packet &packet){};
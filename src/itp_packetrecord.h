@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+#include "itp_packet.h"
+#include "itp_rawpacketview.h"
+
+namespace itp_packet {
+
+/* A fixed 32-byte, trivially copyable snapshot of a packet: the frame bytes plus the metadata that RawPacket and
+Packet carry.  Unlike those classes it has no vtable and no padding, so records can be memcpy'd into ring buffers,
+arrays, files or shared memory in bulk, and two records with the same contents compare equal byte-for-byte (unused
+frame bytes are always zero).
+
+The timestamp is whatever the caller supplies (e.g. millis() when the frame was received); the library never
+interprets it.
+*/
+struct PacketRecord {
+  static const uint8_t FLAG_RESPONSE_EXPECTED = 0x01;
+
+  uint32_t timestamp;
+  uint8_t bytes[PACKET_MAX_SIZE];
+  uint8_t length;
+  uint8_t source_bridge;           // SourceBridge
+  uint8_t controller_association;  // ControllerAssociation
+  uint8_t sequence;
+  uint8_t flags;
+  uint8_t reserved;
+
+  static PacketRecord from_view(const RawPacketView &view, SourceBridge source_bridge,
+                                ControllerAssociation controller_association, uint32_t timestamp = 0,
+                                uint8_t sequence = 0) {
+    PacketRecord record;
+    uint8_t length = view.get_length() > PACKET_MAX_SIZE ? PACKET_MAX_SIZE : view.get_length();
+    memcpy(record.bytes, view.get_bytes(), length);
+    memset(record.bytes + length, 0, PACKET_MAX_SIZE - length);
+    record.timestamp = timestamp;
+    record.length = length;
+    record.source_bridge = static_cast<uint8_t>(source_bridge);
+    record.controller_association = static_cast<uint8_t>(controller_association);
+    record.sequence = sequence;
+    record.flags = FLAG_RESPONSE_EXPECTED;
+    record.reserved = 0;
+    return record;
+  }
+
+  static PacketRecord from_raw_packet(const RawPacket &pkt, uint32_t timestamp = 0, uint8_t sequence = 0) {
+    return from_view(pkt, pkt.get_source_bridge(), pkt.get_controller_association(), timestamp, sequence);
+  }
+
+  static PacketRecord from_packet(const Packet &packet, uint32_t timestamp = 0) {
+    PacketRecord record = from_raw_packet(packet.raw_packet(), timestamp, packet.get_sequence());
+    record.flags = packet.is_response_expected() ? FLAG_RESPONSE_EXPECTED : 0;
+    return record;
+  }
+
+  RawPacketView view() const { return RawPacketView(bytes, length); }
+
+  SourceBridge get_source_bridge() const { return static_cast<SourceBridge>(source_bridge); }
+  ControllerAssociation get_controller_association() const {
+    return static_cast<ControllerAssociation>(controller_association);
+  }
+  bool is_response_expected() const { return flags & FLAG_RESPONSE_EXPECTED; }
+
+  RawPacket to_raw_packet() const {
+    return RawPacket(bytes, length, get_source_bridge(), get_controller_association());
+  }
+
+  // Rebuilds a Packet (or any subclass constructible from a RawPacket), restoring its sequence number
+  template<typename P = Packet> P to_packet() const {
+    P packet(to_raw_packet());
+    packet.set_sequence(sequence);
+    packet.set_response_expected(is_response_expected());
+    return packet;
+  }
+};
+
+static_assert(sizeof(PacketRecord) == 32, "PacketRecord must stay 32 bytes");
+static_assert(std::is_trivially_copyable_v<PacketRecord>, "PacketRecord must be trivially copyable");
+static_assert(std::is_standard_layout_v<PacketRecord>, "PacketRecord must be standard layout");
+
+}  // namespace itp_packet
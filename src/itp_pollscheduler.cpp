@@ -0,0 +1,277 @@
+#include "itp_pollscheduler.h"
+
+#include <cstring>
+
+namespace itp_packet {
+
+// True if time a is at or after time b, allowing for wraparound
+static bool is_due(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) >= 0; }
+
+static constexpr uint16_t payload_bit(int index) { return 1 << index; }
+
+// Every payload byte except the command
+static const uint16_t ALL_FIELDS = 0xFFFE;
+
+static const PollPolicy DEFAULT_POLICIES[PollScheduler::POLLED_COMMAND_COUNT] = {
+    // SETTINGS: changes here usually mean the unit is about to change what it's doing
+    {1000, 10000, 3, ALL_FIELDS, PollScheduler::POLL_RUN_STATE | PollScheduler::POLL_STATUS},
+    // CURRENT_TEMP: temperatures only; the runtime counter ticks every minute
+    {5000, 30000, 2,
+     payload_bit(CurrentTempGetResponseView::PLINDEX_CURRENTTEMP_LEGACY) |
+         payload_bit(CurrentTempGetResponseView::PLINDEX_OUTDOORTEMP) |
+         payload_bit(CurrentTempGetResponseView::PLINDEX_CURRENTTEMP),
+     0},
+    // STATUS: compressor frequency, operating and input watts; not the lifetime energy counter
+    {2000, 30000, 2,
+     payload_bit(StatusGetResponseView::PLINDEX_COMPRESSOR_FREQUENCY) |
+         payload_bit(StatusGetResponseView::PLINDEX_OPERATING) |
+         payload_bit(StatusGetResponseView::PLINDEX_INPUT_WATTS) |
+         payload_bit(StatusGetResponseView::PLINDEX_INPUT_WATTS + 1),
+     0},
+    // RUN_STATE: defrost, preheat and standby flips change what status and temperatures will do next
+    {2000, 30000, 2,
+     payload_bit(RunStateGetResponseView::PLINDEX_STATUSFLAGS) |
+         payload_bit(RunStateGetResponseView::PLINDEX_ACTUALFAN) |
+         payload_bit(RunStateGetResponseView::PLINDEX_AUTOMODE),
+     PollScheduler::POLL_STATUS | PollScheduler::POLL_CURRENT_TEMP},
+    // ERROR_INFO
+    {30000, 300000, 1,
+     payload_bit(ErrorStateGetResponseView::PLINDEX_ERROR_CODE) |
+         payload_bit(ErrorStateGetResponseView::PLINDEX_ERROR_CODE + 1) |
+         payload_bit(ErrorStateGetResponseView::PLINDEX_SHORT_CODE),
+     0},
+    // FUNCTIONS_1 and FUNCTIONS_2: installer settings, which practically never change
+    {600000, 3600000, 0, ALL_FIELDS, 0},
+    {600000, 3600000, 0, ALL_FIELDS, 0},
+};
+
+PollScheduler::PollScheduler(PollSchedulerConfig config, uint32_t now_ms)
+    : aging_ms_{config.aging_ms}, last_refill_ms_{now_ms} {
+  // 8E1 framing puts 11 bits on the wire per byte
+  budget_bytes_per_s_ = config.baud_rate / 11 * config.bus_budget_percent / 100;
+  if (budget_bytes_per_s_ == 0)
+    budget_bytes_per_s_ = 1;
+  // Allow bursts of up to a second's budget (but always at least one poll)
+  capacity_milli_bytes_ = budget_bytes_per_s_ * 1000;
+  if (capacity_milli_bytes_ < POLL_COST_BYTES * 1000)
+    capacity_milli_bytes_ = POLL_COST_BYTES * 1000;
+  tokens_milli_bytes_ = capacity_milli_bytes_;
+
+  for (size_t i = 0; i < POLLED_COMMAND_COUNT; i++) {
+    CommandState &state = commands_[i];
+    state.policy = DEFAULT_POLICIES[i];
+    state.interval_ms = state.policy.min_interval_ms;
+    state.due_ms = now_ms;
+    state.has_payload = false;
+    state.in_flight = false;
+  }
+}
+
+int PollScheduler::index_of_(GetCommand command) {
+  switch (command) {
+    case GetCommand::SETTINGS:
+      return 0;
+    case GetCommand::CURRENT_TEMP:
+      return 1;
+    case GetCommand::STATUS:
+      return 2;
+    case GetCommand::RUN_STATE:
+      return 3;
+    case GetCommand::ERROR_INFO:
+      return 4;
+    case GetCommand::FUNCTIONS_1:
+      return 5;
+    case GetCommand::FUNCTIONS_2:
+      return 6;
+    default:
+      return -1;
+  }
+}
+
+GetCommand PollScheduler::command_at_(int index) {
+  static const GetCommand COMMANDS[POLLED_COMMAND_COUNT] = {
+      GetCommand::SETTINGS,   GetCommand::CURRENT_TEMP, GetCommand::STATUS,     GetCommand::RUN_STATE,
+      GetCommand::ERROR_INFO, GetCommand::FUNCTIONS_1,  GetCommand::FUNCTIONS_2};
+  return COMMANDS[index];
+}
+
+GetRequestPacket &PollScheduler::request_for(GetCommand command) {
+  switch (command) {
+    case GetCommand::CURRENT_TEMP:
+      return GetRequestPacket::get_current_temp_instance();
+    case GetCommand::STATUS:
+      return GetRequestPacket::get_status_instance();
+    case GetCommand::RUN_STATE:
+      return GetRequestPacket::get_runstate_instance();
+    case GetCommand::ERROR_INFO:
+      return GetRequestPacket::get_error_info_instance();
+    case GetCommand::FUNCTIONS_1:
+      return GetRequestPacket::get_functions_1_instance();
+    case GetCommand::FUNCTIONS_2:
+      return GetRequestPacket::get_functions_2_instance();
+    case GetCommand::SETTINGS:
+    default:
+      return GetRequestPacket::get_settings_instance();
+  }
+}
+
+const PollPolicy &PollScheduler::default_policy(GetCommand command) {
+  int index = index_of_(command);
+  return DEFAULT_POLICIES[index < 0 ? 0 : index];
+}
+
+bool PollScheduler::set_policy(GetCommand command, const PollPolicy &policy) {
+  int index = index_of_(command);
+  if (index < 0)
+    return false;
+
+  CommandState &state = commands_[index];
+  state.policy = policy;
+  state.interval_ms = policy.min_interval_ms;
+  state.due_ms = last_refill_ms_;
+  state.has_payload = false;
+  return true;
+}
+
+const PollPolicy *PollScheduler::get_policy(GetCommand command) const {
+  int index = index_of_(command);
+  return index < 0 ? nullptr : &commands_[index].policy;
+}
+
+void PollScheduler::refill_(uint32_t now_ms) {
+  uint32_t elapsed = now_ms - last_refill_ms_;
+  last_refill_ms_ = now_ms;
+
+  // budget_bytes_per_s_ bytes per second is the same number of thousandths of a byte per millisecond
+  uint64_t tokens = tokens_milli_bytes_ + (uint64_t) elapsed * budget_bytes_per_s_;
+  tokens_milli_bytes_ = tokens > capacity_milli_bytes_ ? capacity_milli_bytes_ : tokens;
+}
+
+uint32_t PollScheduler::effective_priority_(const CommandState &state, uint32_t now_ms) const {
+  if (aging_ms_ == 0)
+    return state.policy.priority;
+  return state.policy.priority + (now_ms - state.due_ms) / aging_ms_;
+}
+
+bool PollScheduler::next(uint32_t now_ms, GetCommand &command) {
+  refill_(now_ms);
+
+  int best = -1;
+  uint32_t best_priority = 0;
+  for (size_t i = 0; i < POLLED_COMMAND_COUNT; i++) {
+    const CommandState &state = commands_[i];
+    if (state.in_flight || state.policy.max_interval_ms == 0 || !is_due(now_ms, state.due_ms))
+      continue;
+
+    uint32_t priority = effective_priority_(state, now_ms);
+    if (best < 0 || priority > best_priority ||
+        (priority == best_priority && static_cast<int32_t>(state.due_ms - commands_[best].due_ms) < 0)) {
+      best = i;
+      best_priority = priority;
+    }
+  }
+  if (best < 0)
+    return false;
+
+  if (tokens_milli_bytes_ < POLL_COST_BYTES * 1000) {
+    stats_.budget_deferrals++;
+    return false;
+  }
+  tokens_milli_bytes_ -= POLL_COST_BYTES * 1000;
+
+  commands_[best].in_flight = true;
+  stats_.polls++;
+  command = command_at_(best);
+  return true;
+}
+
+bool PollScheduler::on_response(GetCommand command, const RawPacketView &response, uint32_t now_ms) {
+  int index = index_of_(command);
+  if (index < 0)
+    return false;
+
+  CommandState &state = commands_[index];
+  state.in_flight = false;
+  if (response.get_packet_type() != static_cast<uint8_t>(PacketType::GET_RESPONSE) ||
+      response.get_command() != static_cast<uint8_t>(command)) {
+    // Not the data we asked for; try again after the shortest interval, as for a timeout
+    state.due_ms = now_ms + state.policy.min_interval_ms;
+    return false;
+  }
+
+  size_t payload_length = response.get_length() - PACKET_HEADER_SIZE - 1;
+  if (payload_length > sizeof(state.last_payload))
+    payload_length = sizeof(state.last_payload);
+  const uint8_t *payload = response.get_payload_bytes();
+
+  bool changed = false;
+  if (state.has_payload) {
+    for (size_t i = 0; i < payload_length; i++) {
+      if ((state.policy.change_mask & (1 << i)) && payload[i] != state.last_payload[i]) {
+        changed = true;
+        break;
+      }
+    }
+  }
+  memcpy(state.last_payload, payload, payload_length);
+  state.has_payload = true;
+
+  if (changed) {
+    stats_.changes++;
+    state.interval_ms = state.policy.min_interval_ms;
+    for (size_t i = 0; i < POLLED_COMMAND_COUNT; i++) {
+      if (state.policy.boosts & (1 << i))
+        commands_[i].due_ms = now_ms;
+    }
+  } else {
+    uint32_t interval = state.interval_ms + state.interval_ms / 2;
+    state.interval_ms = interval > state.policy.max_interval_ms ? state.policy.max_interval_ms : interval;
+  }
+  state.due_ms = now_ms + state.interval_ms;
+
+  return changed;
+}
+
+void PollScheduler::on_timeout(GetCommand command, uint32_t now_ms) {
+  int index = index_of_(command);
+  if (index < 0)
+    return;
+
+  commands_[index].in_flight = false;
+  commands_[index].due_ms = now_ms + commands_[index].policy.min_interval_ms;
+}
+
+void PollScheduler::on_cancelled(GetCommand command, uint32_t now_ms) {
+  int index = index_of_(command);
+  if (index < 0)
+    return;
+
+  commands_[index].in_flight = false;
+  commands_[index].due_ms = now_ms;
+}
+
+void PollScheduler::poll_now(GetCommand command, uint32_t now_ms) {
+  int index = index_of_(command);
+  if (index >= 0)
+    commands_[index].due_ms = now_ms;
+}
+
+uint32_t PollScheduler::get_interval(GetCommand command) const {
+  int index = index_of_(command);
+  return index < 0 || commands_[index].policy.max_interval_ms == 0 ? 0 : commands_[index].interval_ms;
+}
+
+bool PollScheduler::get_next_due(uint32_t &due_ms) const {
+  bool found = false;
+  for (const CommandState &state : commands_) {
+    if (state.in_flight || state.policy.max_interval_ms == 0)
+      continue;
+    if (!found || static_cast<int32_t>(state.due_ms - due_ms) < 0) {
+      due_ms = state.due_ms;
+      found = true;
+    }
+  }
+  return found;
+}
+
+}  // namespace itp_packet
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "itp_rawpacketview.h"
+#include "packets/get.h"
+
+namespace itp_packet {
+
+// How often, and how urgently, one GetCommand is polled.  The interval adapts between min and max: it drops to
+// min_interval_ms whenever a response differs from the last one, and grows by half again each time a response is
+// unchanged.  A max_interval_ms of 0 disables polling for the command.
+struct PollPolicy {
+  uint32_t min_interval_ms;
+  uint32_t max_interval_ms;
+  uint8_t priority;      // Higher is polled first when several commands are due
+  uint16_t change_mask;  // Payload bytes (bit n = byte n) whose changes count as the data changing
+  uint8_t boosts;        // Other commands (as POLL bits) to poll immediately when this command's data changes
+};
+
+struct PollSchedulerConfig {
+  uint32_t baud_rate = 2400;
+  uint8_t bus_budget_percent = 50;  // Share of the link's capacity polling may use
+  uint32_t aging_ms = 10000;        // Each aging_ms a due command waits raises its priority by one (0 disables)
+};
+
+// Counters describing a scheduler's activity since construction (or the last reset_stats()).
+struct PollSchedulerStats {
+  uint32_t polls = 0;
+  uint32_t changes = 0;           // Responses that differed from the previous one
+  uint32_t budget_deferrals = 0;  // Times a due poll was held back by the bus budget
+};
+
+/* Decides which GetCommand to poll next, so that fast-changing data is refreshed often, slow-changing data rarely,
+and the total stays within a share of the bus.  The scheduler never sends anything itself: call next() to pick a
+command, send its request (e.g. request_for() through a RequestEngine), and report its outcome from the request's
+completion (e.g. the RequestEngine callback) with on_response(), on_timeout() or on_cancelled().  A command stays in
+flight until then, so responses to anyone else's requests for it (an integrator's, or a thermostat's on a shared bus)
+never complete a poll.
+
+Each command follows a PollPolicy.  Only the bytes in a policy's change_mask are compared, so ever-increasing counters
+(runtime minutes, lifetime kWh) don't keep a command at its fastest rate.  A change can also boost related commands;
+by default a run state change (e.g. entering defrost) polls status and current temperature straight away.
+
+Bus time is accounted with a token bucket refilled at bus_budget_percent of the link's byte rate (8E1 framing) and
+charged for each request and its expected response.  When the budget can't cover everything that's due, the highest
+priority goes first, but a due command gains a priority level for every aging_ms it has waited, so a low-priority
+command is delayed rather than starved.  Time is supplied by the caller (e.g. millis()).
+*/
+class PollScheduler {
+ public:
+  // Bits identifying the polled commands, for PollPolicy::boosts
+  static const uint8_t POLL_SETTINGS = 1 << 0;
+  static const uint8_t POLL_CURRENT_TEMP = 1 << 1;
+  static const uint8_t POLL_STATUS = 1 << 2;
+  static const uint8_t POLL_RUN_STATE = 1 << 3;
+  static const uint8_t POLL_ERROR_INFO = 1 << 4;
+  static const uint8_t POLL_FUNCTIONS_1 = 1 << 5;
+  static const uint8_t POLL_FUNCTIONS_2 = 1 << 6;
+  static const size_t POLLED_COMMAND_COUNT = 7;
+
+  PollScheduler(PollSchedulerConfig config = {}, uint32_t now_ms = 0);
+
+  // Replaces the policy for a command, and polls it on the next call to next().  Returns false if the command
+  // isn't one the scheduler polls.
+  bool set_policy(GetCommand command, const PollPolicy &policy);
+  const PollPolicy *get_policy(GetCommand command) const;
+
+  // Picks the command to poll now and marks it as in flight.  Returns false if nothing is due or the bus budget is
+  // spent.
+  bool next(uint32_t now_ms, GetCommand &command);
+
+  // Reports the response to a poll of command, which updates the command's interval.  Returns true if its data
+  // changed.  A response for a different command only ends the poll.
+  bool on_response(GetCommand command, const RawPacketView &response, uint32_t now_ms);
+  // Reports that a poll got no response; it is retried after the command's minimum interval.
+  void on_timeout(GetCommand command, uint32_t now_ms);
+  // Reports that a poll was abandoned unanswered (e.g. its link was reset).  It isn't counted against the command's
+  // interval, and is polled again on the next call to next().
+  void on_cancelled(GetCommand command, uint32_t now_ms);
+
+  // Polls a command on the next call to next(), e.g. after changing a setting
+  void poll_now(GetCommand command, uint32_t now_ms);
+
+  // Current adaptive interval for a command (0 if it isn't polled)
+  uint32_t get_interval(GetCommand command) const;
+  // Earliest time a command will be due; returns false if nothing is scheduled
+  bool get_next_due(uint32_t &due_ms) const;
+
+  const PollSchedulerStats &get_stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+
+  // The prebuilt request for a polled command
+  static GetRequestPacket &request_for(GetCommand command);
+  static const PollPolicy &default_policy(GetCommand command);
+
+ private:
+  struct CommandState {
+    PollPolicy policy;
+    uint32_t interval_ms;
+    uint32_t due_ms;
+    uint8_t last_payload[PACKET_MAX_SIZE - PACKET_HEADER_SIZE - 1];
+    bool has_payload;
+    bool in_flight;
+  };
+
+  // Bytes one poll costs on the wire: a 7-byte request plus the largest response
+  static const uint32_t POLL_COST_BYTES = PACKET_HEADER_SIZE + 2 + PACKET_MAX_SIZE;
+
+  CommandState commands_[POLLED_COMMAND_COUNT];
+  uint32_t aging_ms_;
+  uint32_t budget_bytes_per_s_;
+  uint32_t tokens_milli_bytes_;  // Thousandths of a byte, so slow links still refill every millisecond
+  uint32_t capacity_milli_bytes_;
+  uint32_t last_refill_ms_;
+  PollSchedulerStats stats_;
+
+  static int index_of_(GetCommand command);
+  static GetCommand command_at_(int index);
+  // A due command's priority, raised by how long it has been waiting
+  uint32_t effective_priority_(const CommandState &state, uint32_t now_ms) const;
+  void refill_(uint32_t now_ms);
+};
+
+}  // namespace itp_packet
@@ -26,6 +26,7 @@ RawPacket::RawPacket(const uint8_t packet_bytes[], const uint8_t packet_length,
   memcpy(packet_bytes_, packet_bytes, packet_length);
 
   if (!this->is_checksum_valid()) {
+    checksum_invalid_ = true;
     // For now, just log this as information (we can decide if we want to process it elsewhere)
     // TODO: ESP_LOGI(PTAG, "Packet of type %x has invalid checksum!", this->get_packet_type());
   }
@@ -37,31 +38,48 @@ RawPacket::RawPacket() {
 }
 
 uint8_t RawPacket::calculate_checksum_() const {  // NOLINT(readability-identifier-naming)
-  uint8_t sum = 0;
-  for (int i = 0; i < checksum_index_; i++) {
-    sum += packet_bytes_[i];
-  }
-
-  return (0xfc - sum) & 0xff;
+  return calculate_checksum(packet_bytes_, checksum_index_);
 }
 
 RawPacket &RawPacket::update_checksum_() {
   packet_bytes_[checksum_index_] = calculate_checksum_();
+  checksum_invalid_ = false;
   return *this;
 }
 
 bool RawPacket::is_checksum_valid() const { return packet_bytes_[checksum_index_] == calculate_checksum_(); }
 
-// Sets a payload byte and automatically updates the packet checksum
+// Sets a payload byte and automatically updates the packet checksum.  The checksum is a plain sum, so it's adjusted
+// by the change in the byte instead of re-summing the whole frame; building a packet field-by-field stays O(1) per
+// write.  Adjusting only works if the checksum was valid to begin with, so a bad one is recalculated instead.
 RawPacket &RawPacket::set_payload_byte(const uint8_t payload_byte_index, const uint8_t value) {
-  packet_bytes_[PACKET_HEADER_SIZE + payload_byte_index] = value;
-  update_checksum_();
+  const uint8_t byte_index = PACKET_HEADER_SIZE + payload_byte_index;
+  if (byte_index >= checksum_index_ || checksum_invalid_) {
+    // Writing past the payload (e.g. over the checksum itself), or repairing a bad checksum; recalculate everything
+    packet_bytes_[byte_index] = value;
+    return update_checksum_();
+  }
+
+  packet_bytes_[checksum_index_] -= value - packet_bytes_[byte_index];
+  packet_bytes_[byte_index] = value;
   return *this;
 }
 
 RawPacket &RawPacket::set_payload_bytes(const uint8_t begin_index, const void *value, const size_t size) {
-  memcpy(&packet_bytes_[PACKET_HEADER_SIZE + begin_index], value, size);
-  update_checksum_();
+  const uint8_t begin_byte_index = PACKET_HEADER_SIZE + begin_index;
+  if (begin_byte_index + size > checksum_index_ || checksum_invalid_) {
+    memcpy(&packet_bytes_[begin_byte_index], value, size);
+    return update_checksum_();
+  }
+
+  const auto *new_bytes = static_cast<const uint8_t *>(value);
+  uint8_t delta = 0;
+  for (size_t i = 0; i < size; i++) {
+    delta += new_bytes[i] - packet_bytes_[begin_byte_index + i];
+  }
+
+  memcpy(&packet_bytes_[begin_byte_index], value, size);
+  packet_bytes_[checksum_index_] -= delta;
   return *this;
 }
 
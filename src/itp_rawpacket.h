@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cstring>
 #include <stdint.h>
 #include <type_traits>
@@ -52,6 +53,10 @@ enum class SetCommand : uint8_t {
   THERMOSTAT_SET_AA = 0xaa,
 };
 
+// First payload byte of identify requests and responses
+static const uint8_t IDENTIFY_COMMAND_CAPABILITIES = 0xc9;
+static const uint8_t IDENTIFY_COMMAND_CD = 0xcd;
+
 // Which MITPBridge was the packet read from (used to determine flow direction of the packet)
 enum class SourceBridge { NONE, HEATPUMP, THERMOSTAT };
 
@@ -59,13 +64,13 @@ enum class SourceBridge { NONE, HEATPUMP, THERMOSTAT };
 // packet)
 enum class ControllerAssociation { MITP, THERMOSTAT };
 
-static const uint8_t EMPTY_PACKET[PACKET_MAX_SIZE] = {BYTE_CONTROL,        // Sync
-                                                      0x00,                // Packet type
-                                                      0x01,         0x30,  // Unknown
-                                                      0x00,                // Payload Size
-                                                      0x00,         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                                                      0x00,         0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Payload
-                                                      0x00};
+static constexpr uint8_t EMPTY_PACKET[PACKET_MAX_SIZE] = {BYTE_CONTROL,        // Sync
+                                                          0x00,                // Packet type
+                                                          0x01,         0x30,  // Unknown
+                                                          0x00,                // Payload Size
+                                                          0x00,         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                                          0x00,         0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Payload
+                                                          0x00};
 
 /* A class representing the raw packet sent to or from the Mitsubishi equipment with definitions
 for header indexes, checksum calculations, utility methods, etc.  These generally shouldn't be accessed
@@ -89,6 +94,38 @@ class RawPacket {
 
   bool is_checksum_valid() const;
 
+  // Calculates the checksum over the first checksum_index bytes of a frame (i.e. everything but the checksum itself)
+  static constexpr uint8_t calculate_checksum(const uint8_t packet_bytes[], uint8_t checksum_index) {
+    uint8_t sum = 0;
+    for (int i = 0; i < checksum_index; i++) {
+      sum += packet_bytes[i];
+    }
+
+    return (0xfc - sum) & 0xff;
+  }
+
+  // Builds a complete frame (header, payload and checksum) at compile time, for packets whose contents never change.
+  // The result can be written to the UART as-is, or passed to the byte-array constructor.
+  template<size_t PAYLOAD_SIZE>
+  static constexpr std::array<uint8_t, PAYLOAD_SIZE + PACKET_HEADER_SIZE + 1> make_frame(
+      PacketType packet_type, const std::array<uint8_t, PAYLOAD_SIZE> &payload) {
+    static_assert(PAYLOAD_SIZE + PACKET_HEADER_SIZE + 1 <= PACKET_MAX_SIZE, "Payload too large for a packet");
+
+    std::array<uint8_t, PAYLOAD_SIZE + PACKET_HEADER_SIZE + 1> frame{};
+    for (size_t i = 0; i < PACKET_HEADER_SIZE; i++) {
+      frame[i] = EMPTY_PACKET[i];
+    }
+    frame[PACKET_HEADER_INDEX_PACKET_TYPE] = static_cast<uint8_t>(packet_type);
+    frame[PACKET_HEADER_INDEX_PAYLOAD_LENGTH] = PAYLOAD_SIZE;
+
+    for (size_t i = 0; i < PAYLOAD_SIZE; i++) {
+      frame[PACKET_HEADER_SIZE + i] = payload[i];
+    }
+    frame[PAYLOAD_SIZE + PACKET_HEADER_SIZE] = calculate_checksum(frame.data(), PAYLOAD_SIZE + PACKET_HEADER_SIZE);
+
+    return frame;
+  }
+
   // Returns the packet type byte
   uint8_t get_packet_type() const { return packet_bytes_[PACKET_HEADER_INDEX_PACKET_TYPE]; };
   // Returns the first byte of the payload, often used as a command
@@ -97,6 +134,8 @@ class RawPacket {
   SourceBridge get_source_bridge() const { return source_bridge_; };
   ControllerAssociation get_controller_association() const { return controller_association_; };
 
+  // Payload writes keep the checksum valid.  Normally that's an O(1) adjustment by the change in value; a packet
+  // built from bytes with a bad checksum has it recalculated in full on its first write, and is valid from then on.
   RawPacket &set_payload_byte(uint8_t payload_byte_index, uint8_t value);
   RawPacket &set_payload_bytes(uint8_t begin_index, const void *value, size_t size);
   uint8_t get_payload_byte(const uint8_t payload_byte_index) const {
@@ -112,6 +151,7 @@ class RawPacket {
   uint8_t packet_bytes_[PACKET_MAX_SIZE]{};
   uint8_t length_;
   uint8_t checksum_index_;
+  bool checksum_invalid_ = false;  // Built from bytes with a bad checksum, so it can't be adjusted incrementally
 
   SourceBridge source_bridge_;
   ControllerAssociation controller_association_;
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "itp_rawpacket.h"
+
+namespace itp_packet {
+
+/* A non-owning, read-only view over the bytes of a packet, with the same accessors as RawPacket.  Views are two
+words wide, trivially copyable and have no vtable, so a frame can be decoded straight out of a receive buffer
+without copying it.  The bytes must stay valid (and unchanged) for as long as the view is used.
+*/
+class RawPacketView {
+ public:
+  constexpr RawPacketView(const uint8_t packet_bytes[], uint8_t packet_length)
+      : packet_bytes_{packet_bytes}, length_{packet_length} {}
+  RawPacketView(const RawPacket &pkt) : packet_bytes_{pkt.get_bytes()}, length_{pkt.get_length()} {}
+
+  uint8_t get_length() const { return length_; };
+  const uint8_t *get_bytes() const { return packet_bytes_; };
+
+  bool is_checksum_valid() const {
+    return packet_bytes_[length_ - 1] == RawPacket::calculate_checksum(packet_bytes_, length_ - 1);
+  }
+
+  // Returns the packet type byte
+  uint8_t get_packet_type() const { return packet_bytes_[PACKET_HEADER_INDEX_PACKET_TYPE]; };
+  // Returns the first byte of the payload, often used as a command
+  uint8_t get_command() const { return get_payload_byte(0); };
+
+  uint8_t get_payload_byte(const uint8_t payload_byte_index) const {
+    return packet_bytes_[PACKET_HEADER_SIZE + payload_byte_index];
+  };
+  const uint8_t *get_payload_bytes(size_t start_index = 0) const {
+    return &packet_bytes_[PACKET_HEADER_SIZE + start_index];
+  }
+
+  // Returns flags (ONLY APPLICABLE FOR SOME COMMANDS)
+  uint8_t get_flags() const { return get_payload_byte(PLINDEX_FLAGS); }
+  uint8_t get_flags_2() const { return get_payload_byte(PLINDEX_FLAGS2); }
+
+  // Copies the viewed bytes into an owning RawPacket
+  RawPacket to_raw_packet(SourceBridge source_bridge = SourceBridge::NONE,
+                          ControllerAssociation controller_association = ControllerAssociation::MITP) const {
+    return RawPacket(packet_bytes_, length_, source_bridge, controller_association);
+  }
+
+ private:
+  static const int PLINDEX_FLAGS = 1;
+  static const int PLINDEX_FLAGS2 = 2;
+
+  const uint8_t *packet_bytes_;
+  uint8_t length_;
+};
+
+}  // namespace itp_packet
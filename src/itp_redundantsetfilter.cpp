@@ -0,0 +1,184 @@
+#include "itp_redundantsetfilter.h"
+
+#include <cstring>
+
+namespace itp_packet {
+
+using SetRequest = SettingsSetRequestPacket;
+using GetResponse = SettingsGetResponseView;
+
+static const uint16_t SETTING_HORIZONTAL_VANE = static_cast<uint16_t>(SetRequest::SF2_HORIZONTAL_VANE) << 8;
+
+// A SetResponse carries a full 16-byte payload
+static const uint8_t SET_RESPONSE_LENGTH = PACKET_HEADER_SIZE + 16 + 1;
+
+static bool has_payload(const RawPacketView &frame, uint8_t last_index) {
+  return frame.get_length() >= PACKET_HEADER_SIZE + last_index + 2;
+}
+
+bool RedundantSetFilter::process_frame(const RawPacketView &frame, uint32_t now_ms, uint32_t generation) {
+  if (frame.get_packet_type() != static_cast<uint8_t>(PacketType::GET_RESPONSE) ||
+      frame.get_command() != static_cast<uint8_t>(GetCommand::SETTINGS) ||
+      !has_payload(frame, GetResponse::PLINDEX_TARGETTEMP))
+    return false;
+
+  update_state(GetResponse(frame.get_bytes(), frame.get_length()), now_ms, generation);
+  return true;
+}
+
+void RedundantSetFilter::update_state(const SettingsGetResponseView &settings, uint32_t now_ms, uint32_t generation) {
+  uint16_t learned = ALL_SETTINGS;
+  for (int bit = 0; bit < 16; bit++) {
+    if (generation == ANY_GENERATION)
+      unsettled_sets_[bit] = 0;
+    // Skip settings with a SET outstanding, or settled since the GET was sent
+    else if (unsettled_sets_[bit] != 0 || static_cast<int32_t>(generation - settled_generation_[bit]) < 0)
+      learned &= ~(1 << bit);
+  }
+
+  // Settings that aren't learned are already unknown, so their bytes can be overwritten too
+  size_t length = settings.get_length() - PACKET_HEADER_SIZE - 1;
+  memcpy(settings_, settings.get_payload_bytes(), length < sizeof(settings_) ? length : sizeof(settings_));
+  known_settings_ = learned;
+  settings_ms_ = now_ms;
+}
+
+void RedundantSetFilter::settle(const RawPacketView &request) {
+  if (request.get_packet_type() != static_cast<uint8_t>(PacketType::SET_REQUEST) ||
+      request.get_command() != static_cast<uint8_t>(SetCommand::SETTINGS) ||
+      !has_payload(request, SetRequest::PLINDEX_TARGET_TEMPERATURE))
+    return;
+
+  generation_++;
+  uint16_t sent = (request.get_flags() | request.get_flags_2() << 8) & ALL_SETTINGS;
+  for (int bit = 0; bit < 16; bit++) {
+    if (!(sent & (1 << bit)))
+      continue;
+    if (unsettled_sets_[bit] != 0)
+      unsettled_sets_[bit]--;
+    settled_generation_[bit] = generation_;
+  }
+}
+
+void RedundantSetFilter::invalidate() {
+  known_settings_ = 0;
+  has_remote_temperature_ = false;
+  // Responses to anything sent before now are stale
+  generation_++;
+  for (int bit = 0; bit < 16; bit++) {
+    unsettled_sets_[bit] = 0;
+    settled_generation_[bit] = generation_;
+  }
+}
+
+SetFilterResult RedundantSetFilter::filter(RawPacket &request, uint32_t now_ms) {
+  if (request.get_packet_type() != static_cast<uint8_t>(PacketType::SET_REQUEST))
+    return SetFilterResult::SEND;
+
+  const RawPacketView view(request);
+  switch (static_cast<SetCommand>(request.get_command())) {
+    case SetCommand::SETTINGS: {
+      if (!has_payload(view, SetRequest::PLINDEX_TARGET_TEMPERATURE))
+        return SetFilterResult::SEND;
+      stats_.examined++;
+
+      uint16_t redundant = find_redundant_settings_(view, now_ms);
+      uint16_t remaining = (view.get_flags() | view.get_flags_2() << 8) & ~redundant;
+      if (redundant) {
+        request.set_payload_byte(1, remaining & 0xFF);
+        request.set_payload_byte(2, remaining >> 8);
+      }
+      return finish_settings_(view, remaining, redundant);
+    }
+    case SetCommand::REMOTE_TEMPERATURE:
+      if (!has_payload(view, RemoteTemperatureSetRequestPacket::PLINDEX_REMOTE_TEMPERATURE))
+        return SetFilterResult::SEND;
+      stats_.examined++;
+      return filter_remote_temperature_(view, now_ms);
+    default:
+      return SetFilterResult::SEND;
+  }
+}
+
+SetFilterResult RedundantSetFilter::filter(SettingsSetRequestPacket &request, uint32_t now_ms) {
+  stats_.examined++;
+
+  const RawPacketView view = request.raw_view();
+  uint16_t redundant = find_redundant_settings_(view, now_ms);
+  uint16_t remaining = (view.get_flags() | view.get_flags_2() << 8) & ~redundant;
+  if (redundant) {
+    request.set_flags(remaining & 0xFF);
+    request.set_flags_2(remaining >> 8);
+  }
+  return finish_settings_(view, remaining, redundant);
+}
+
+SetFilterResult RedundantSetFilter::filter(RemoteTemperatureSetRequestPacket &request, uint32_t now_ms) {
+  stats_.examined++;
+  return filter_remote_temperature_(request.raw_view(), now_ms);
+}
+
+uint16_t RedundantSetFilter::find_redundant_settings_(const RawPacketView &request, uint32_t now_ms) const {
+  if (known_settings_ == 0 || now_ms - settings_ms_ > max_state_age_ms_)
+    return 0;
+
+  auto same = [&](int request_index, int state_index) {
+    return request.get_payload_byte(request_index) == settings_[state_index];
+  };
+
+  uint16_t redundant = 0;
+  if (same(SetRequest::PLINDEX_POWER, GetResponse::PLINDEX_POWER))
+    redundant |= SetRequest::SF_POWER;
+  // Exact match only: the unit reports i-see variants of some modes, which a plain mode request would turn off
+  if (same(SetRequest::PLINDEX_MODE, GetResponse::PLINDEX_MODE))
+    redundant |= SetRequest::SF_MODE;
+  // Units that report the enhanced target temperature are compared on it, older units on the legacy code
+  if (settings_[GetResponse::PLINDEX_TARGETTEMP] != 0x00
+          ? same(SetRequest::PLINDEX_TARGET_TEMPERATURE, GetResponse::PLINDEX_TARGETTEMP)
+          : same(SetRequest::PLINDEX_TARGET_TEMPERATURE_CODE, GetResponse::PLINDEX_TARGETTEMP_LEGACY))
+    redundant |= SetRequest::SF_TARGET_TEMPERATURE;
+  if (same(SetRequest::PLINDEX_FAN, GetResponse::PLINDEX_FAN))
+    redundant |= SetRequest::SF_FAN;
+  if (same(SetRequest::PLINDEX_VANE, GetResponse::PLINDEX_VANE))
+    redundant |= SetRequest::SF_VANE;
+  if (same(SetRequest::PLINDEX_HORIZONTAL_VANE, GetResponse::PLINDEX_HVANE))
+    redundant |= SETTING_HORIZONTAL_VANE;
+
+  return redundant & known_settings_ & (request.get_flags() | request.get_flags_2() << 8);
+}
+
+SetFilterResult RedundantSetFilter::finish_settings_(const RawPacketView &request, uint16_t remaining,
+                                                     uint16_t stripped) {
+  if (remaining == 0)
+    return suppress_(request);
+
+  // Until the unit confirms what it did with them, the settings being sent are unknown
+  known_settings_ &= ~remaining;
+  for (int bit = 0; bit < 16; bit++) {
+    if (remaining & ALL_SETTINGS & (1 << bit))
+      unsettled_sets_[bit]++;
+  }
+  stats_.fields_stripped += __builtin_popcount(stripped);
+  return stripped ? SetFilterResult::SEND_MODIFIED : SetFilterResult::SEND;
+}
+
+SetFilterResult RedundantSetFilter::filter_remote_temperature_(const RawPacketView &request, uint32_t now_ms) {
+  // Flags, then the legacy and scale A encodings of the temperature
+  const uint8_t *payload = request.get_payload_bytes(1);
+  if (has_remote_temperature_ && memcmp(payload, remote_temperature_, sizeof(remote_temperature_)) == 0 &&
+      now_ms - remote_temperature_ms_ < keepalive_ms_)
+    return suppress_(request);
+
+  memcpy(remote_temperature_, payload, sizeof(remote_temperature_));
+  has_remote_temperature_ = true;
+  remote_temperature_ms_ = now_ms;
+  return SetFilterResult::SEND;
+}
+
+SetFilterResult RedundantSetFilter::suppress_(const RawPacketView &request) {
+  stats_.suppressed++;
+  stats_.bytes_saved += request.get_length() + SET_RESPONSE_LENGTH;
+  return SetFilterResult::SUPPRESS;
+}
+
+}  // namespace itp_packet
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "itp_rawpacket.h"
+#include "itp_rawpacketview.h"
+#include "packets/get.h"
+#include "packets/set.h"
+
+namespace itp_packet {
+
+enum class SetFilterResult {
+  SEND,           // Send the request unchanged
+  SEND_MODIFIED,  // Send the request; fields the unit already has were removed from it
+  SUPPRESS,       // Don't send the request; the unit already has everything it asks for
+};
+
+// Counters describing a filter's activity since construction (or the last reset_stats()).
+struct RedundantSetFilterStats {
+  uint32_t examined = 0;         // Set requests passed to filter()
+  uint32_t suppressed = 0;       // Requests dropped entirely
+  uint32_t fields_stripped = 0;  // Settings removed from requests that were still sent
+  uint32_t bytes_saved = 0;      // Bus bytes not written because of suppressed requests (responses included)
+};
+
+/* Compares outgoing set requests with the unit's last known state and removes whatever wouldn't change anything, so
+re-asserting a setting the unit already has (e.g. power on, the same fan speed) costs no bus time.  Comparisons are
+made on the encoded bytes rather than on floats, so two temperatures that round to the same wire value count as
+equal.
+
+SettingsSetRequestPackets are compared against the last SettingsGetResponse passed to process_frame() or
+update_state(), if it's no older than max_state_age_ms; matching settings have their flags cleared.  Once a setting
+has been sent it's treated as unknown, so a change the unit refused is never filtered.  A GET already on the wire when
+a SET went out can be answered with the setting as it was, so the filter counts generations: settle() each sent
+request once it's been answered (or has failed), stamp each settings GET with get_generation() when it's sent, and
+pass that stamp with its response.  A setting is only learned again from a response to a GET sent after its SET was
+settled.  Responses passed without a generation update every setting, which is only safe when a GET is never sent
+while a SET is outstanding.
+
+RemoteTemperatureSetRequestPackets are compared against the last one sent, and are let through at least every
+keepalive_ms even if unchanged so the unit doesn't fall back to its own sensor.
+
+A suppressed request should be reported to its caller as having succeeded.  Other set commands always pass through
+untouched.  The filter is not thread-safe.
+*/
+class RedundantSetFilter {
+ public:
+  static const uint32_t DEFAULT_MAX_STATE_AGE_MS = 30000;
+  static const uint32_t DEFAULT_KEEPALIVE_MS = 20000;
+  // Passed as a response's generation to learn every setting from it, however stale
+  static const uint32_t ANY_GENERATION = UINT32_MAX;
+
+  RedundantSetFilter(uint32_t max_state_age_ms = DEFAULT_MAX_STATE_AGE_MS,
+                     uint32_t keepalive_ms = DEFAULT_KEEPALIVE_MS)
+      : max_state_age_ms_{max_state_age_ms}, keepalive_ms_{keepalive_ms} {}
+
+  // Learns the unit's settings from any SettingsGetResponse; other frames are ignored.  Returns true if the frame
+  // was used.  generation is get_generation() as of when the GET was sent.
+  bool process_frame(const RawPacketView &frame, uint32_t now_ms, uint32_t generation = ANY_GENERATION);
+  void update_state(const SettingsGetResponseView &settings, uint32_t now_ms,
+                    uint32_t generation = ANY_GENERATION);
+
+  // Removes redundant fields from request in place (its checksum is kept valid), and says whether it should be sent
+  SetFilterResult filter(RawPacket &request, uint32_t now_ms);
+  SetFilterResult filter(SettingsSetRequestPacket &request, uint32_t now_ms);
+  SetFilterResult filter(RemoteTemperatureSetRequestPacket &request, uint32_t now_ms);
+
+  // Marks the settings of a request that filter() let through (as it was sent) as answered, or failed, so responses
+  // to GETs sent from now on can update them.  Other requests are ignored.
+  void settle(const RawPacketView &request);
+  // The generation to stamp a settings GET with as it's sent
+  uint32_t get_generation() const { return generation_; }
+
+  // Forgets all known state (e.g. after the link is reset), so the next requests are sent in full
+  void invalidate();
+
+  const RedundantSetFilterStats &get_stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+
+ private:
+  // Bit per setting: SettingFlag values in the low byte, SettingFlag2 values in the high byte
+  static const uint16_t ALL_SETTINGS = 0x011F;
+
+  uint32_t max_state_age_ms_;
+  uint32_t keepalive_ms_;
+
+  // Last SettingsGetResponse payload, and which of its settings still reflect what the unit has
+  uint8_t settings_[PACKET_MAX_SIZE - PACKET_HEADER_SIZE - 1] = {};
+  uint16_t known_settings_ = 0;
+  uint32_t settings_ms_ = 0;
+
+  // Per settings bit: SET requests sent but not yet settled, and the generation its last SET was settled in
+  uint8_t unsettled_sets_[16] = {};
+  uint32_t settled_generation_[16] = {};
+  uint32_t generation_ = 0;
+
+  // Last RemoteTemperatureSetRequest payload (flags, legacy temperature, scale A temperature) sent
+  uint8_t remote_temperature_[3] = {};
+  bool has_remote_temperature_ = false;
+  uint32_t remote_temperature_ms_ = 0;
+
+  RedundantSetFilterStats stats_;
+
+  // Returns the settings flags (as in ALL_SETTINGS) of request that the unit already has
+  uint16_t find_redundant_settings_(const RawPacketView &request, uint32_t now_ms) const;
+  // Applies the outcome of filtering a settings request whose remaining flags are remaining
+  SetFilterResult finish_settings_(const RawPacketView &request, uint16_t remaining, uint16_t stripped);
+  SetFilterResult filter_remote_temperature_(const RawPacketView &request, uint32_t now_ms);
+  SetFilterResult suppress_(const RawPacketView &request);
+};
+
+}  // namespace itp_packet
@@ -0,0 +1,83 @@
+#include "itp_remotetemperaturefeed.h"
+
+#include <cassert>
+
+namespace itp_packet {
+
+bool RemoteTemperatureFeed::on_reading(float temperature_degrees_c, uint32_t now_ms) {
+  stats_.readings++;
+  // The range set_remote_temperature() accepts; written so NaN fails it too
+  if (!(temperature_degrees_c > -64.0f && temperature_degrees_c < 63.5f)) {
+    stats_.rejected++;
+    return false;
+  }
+
+  reading_c_ = temperature_degrees_c;
+  reading_ms_ = now_ms;
+  has_reading_ = true;
+  return true;
+}
+
+bool RemoteTemperatureFeed::poll(uint32_t now_ms, RemoteTemperatureSetRequestPacket &request) {
+  if (!has_reading_)
+    return false;
+
+  if (now_ms - reading_ms_ > config_.stale_after_ms) {
+    has_reading_ = false;
+    if (!remote_active_)
+      return false;
+
+    remote_active_ = false;
+    stats_.fallbacks++;
+    request = RemoteTemperatureSetRequestPacket();
+    request.set_use_internal_temperature();
+    return true;
+  }
+
+  uint32_t since_sent = now_ms - sent_ms_;
+  if (!remote_active_ || (since_sent >= config_.min_interval_ms && is_changed_())) {
+    stats_.updates++;
+    sent_c_ = reading_c_;
+  } else if (since_sent >= config_.keepalive_ms) {
+    // Repeat what the unit already has, even if the reading has drifted within the hysteresis band
+    stats_.keepalives++;
+  } else {
+    return false;
+  }
+
+  remote_active_ = true;
+  sent_ms_ = now_ms;
+  request = RemoteTemperatureSetRequestPacket();
+  request.set_remote_temperature(sent_c_);
+  // on_reading() only accepts temperatures set_remote_temperature() can encode
+  assert(request.get_flags() == 0x01);
+  return true;
+}
+
+bool RemoteTemperatureFeed::process_frame(const RawPacketView &frame) {
+  if (frame.get_packet_type() != static_cast<uint8_t>(PacketType::GET_RESPONSE) ||
+      frame.get_command() != static_cast<uint8_t>(GetCommand::SETTINGS) ||
+      frame.get_length() < PACKET_HEADER_SIZE + SettingsGetResponseView::PLINDEX_TARGETTEMP + 2)
+    return false;
+
+  encoding_ = frame.get_payload_byte(SettingsGetResponseView::PLINDEX_TARGETTEMP) != 0x00
+                  ? RemoteTemperatureEncoding::ENHANCED
+                  : RemoteTemperatureEncoding::LEGACY;
+  return true;
+}
+
+uint8_t RemoteTemperatureFeed::encode_(float temperature_degrees_c) const {
+  if (encoding_ == RemoteTemperatureEncoding::ENHANCED)
+    return ITPUtils::deg_c_to_temp_scale_a(temperature_degrees_c);
+  return ITPUtils::deg_c_to_legacy_ts_room_temp(temperature_degrees_c);
+}
+
+bool RemoteTemperatureFeed::is_changed_() const {
+  // The reading counts as changed only once the whole band around it, hysteresis_c either side, encodes to
+  // something other than what was sent.  Near a boundary that band straddles it, so nothing is sent.
+  uint8_t sent = encode_(sent_c_);
+  return encode_(reading_c_) != sent && encode_(reading_c_ - config_.hysteresis_c) != sent &&
+         encode_(reading_c_ + config_.hysteresis_c) != sent;
+}
+
+}  // namespace itp_packet
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "itp_rawpacketview.h"
+#include "packets/get.h"
+#include "packets/set.h"
+
+namespace itp_packet {
+
+// Which of the two remote temperature encodings the unit reads
+enum class RemoteTemperatureEncoding : uint8_t {
+  ENHANCED,  // The scale A byte: 0.5 °C steps, rounded to the nearest
+  LEGACY,    // The legacy byte: 0.5 °C steps, rounded down, for units without enhanced temperatures
+};
+
+struct RemoteTemperatureFeedConfig {
+  // The encoding hysteresis is applied to, until process_frame() learns the unit's from a settings response
+  RemoteTemperatureEncoding encoding = RemoteTemperatureEncoding::ENHANCED;
+  float hysteresis_c = 0.1f;         // How far past an encoding boundary a reading must go before it's sent
+  uint32_t min_interval_ms = 5000;   // Shortest time between two updates caused by changes
+  uint32_t keepalive_ms = 20000;     // Longest time between two updates while the reading is current
+  uint32_t stale_after_ms = 120000;  // Age at which a reading is abandoned and the unit's own sensor is used
+};
+
+// Counters describing a feed's activity since construction (or the last reset_stats()).
+struct RemoteTemperatureFeedStats {
+  uint32_t readings = 0;    // Readings passed to on_reading()
+  uint32_t rejected = 0;    // Readings ignored because they weren't finite or couldn't be encoded
+  uint32_t updates = 0;     // Requests sent because the encoded temperature changed (or the feed started)
+  uint32_t keepalives = 0;  // Requests sent only to keep the unit from timing out
+  uint32_t fallbacks = 0;   // Switches back to the unit's internal sensor because readings went stale
+};
+
+/* Turns a stream of readings from an external sensor into the few RemoteTemperatureSetRequestPackets the unit
+actually needs.  The unit only sees the temperature as encoded on the wire (0.5 °C steps on both the enhanced and the
+legacy byte, with boundaries in different places), so a reading is only sent when its encoding changes, and only once
+it has moved hysteresis_c past the edge of the value last sent, so a sensor hovering at a boundary doesn't flap
+between two encodings.  Only the encoding the unit reads is compared, since tracking both would send at the
+boundaries of each, twice as often; pass settings responses to process_frame() to learn which one that is.  Changes
+are rate limited to one per min_interval_ms, and the current value is repeated every keepalive_ms.
+
+Readings that aren't finite (e.g. the NaN a failed sensor publishes) or are outside the range the wire can carry
+are rejected, so they count towards the reading going stale.  If no usable reading arrives for stale_after_ms, the
+feed sends one request to switch the unit back to its own sensor and
+then stays quiet until readings resume.
+
+Feed readings in with on_reading(), and call poll() regularly (e.g. from a component's loop()); whenever it returns
+true, send the request it filled in.  All methods must be called from the same thread.
+*/
+class RemoteTemperatureFeed {
+ public:
+  RemoteTemperatureFeed(RemoteTemperatureFeedConfig config = {}) : config_{config}, encoding_{config.encoding} {}
+
+  // Returns false (and ignores the reading) if it can't be sent to the unit
+  bool on_reading(float temperature_degrees_c, uint32_t now_ms);
+
+  // Learns which encoding the unit reads from a SettingsGetResponse (units that report an enhanced target
+  // temperature read the enhanced remote temperature); other frames are ignored.  Returns true if the frame was used.
+  bool process_frame(const RawPacketView &frame);
+  RemoteTemperatureEncoding get_encoding() const { return encoding_; }
+
+  // Fills in request and returns true if a request should be sent now
+  bool poll(uint32_t now_ms, RemoteTemperatureSetRequestPacket &request);
+
+  // Forgets what the unit was last sent (e.g. after the link is reset), so the next poll() with a current reading
+  // sends it straight away
+  void reset() { remote_active_ = false; }
+
+  // True if the unit was last told to use the remote temperature (rather than its own sensor)
+  bool is_remote_active() const { return remote_active_; }
+
+  const RemoteTemperatureFeedStats &get_stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+
+ private:
+  RemoteTemperatureFeedConfig config_;
+  RemoteTemperatureEncoding encoding_;
+
+  float reading_c_ = 0;
+  uint32_t reading_ms_ = 0;
+  bool has_reading_ = false;
+
+  bool remote_active_ = false;
+  float sent_c_ = 0;
+  uint32_t sent_ms_ = 0;
+
+  RemoteTemperatureFeedStats stats_;
+
+  // A temperature in the encoding the unit reads
+  uint8_t encode_(float temperature_degrees_c) const;
+  // True if reading has moved far enough from what was last sent to be worth sending
+  bool is_changed_() const;
+};
+
+}  // namespace itp_packet
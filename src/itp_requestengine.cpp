@@ -0,0 +1,211 @@
+#include "itp_requestengine.h"
+
+#include <cstring>
+
+namespace itp_packet {
+
+static const RawPacketView NO_RESPONSE(nullptr, 0);
+
+// True if time a is at or after time b, allowing for wraparound
+static bool is_due(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) >= 0; }
+
+bool RequestEngine::submit(const Packet &request, RequestCallback callback, uint32_t now_ms) {
+  return enqueue_(PacketRecord::from_packet(request), std::move(callback), now_ms);
+}
+
+bool RequestEngine::submit(const RawPacket &request, RequestCallback callback, uint32_t now_ms) {
+  return enqueue_(PacketRecord::from_raw_packet(request), std::move(callback), now_ms);
+}
+
+bool RequestEngine::enqueue_(const PacketRecord &request, RequestCallback &&callback, uint32_t now_ms) {
+  for (Entry &entry : entries_) {
+    if (entry.state != EntryState::FREE)
+      continue;
+
+    entry.request = request;
+    entry.callback = std::move(callback);
+    entry.order = next_order_++;
+    entry.filter_generation = 0;
+    entry.filtered = false;
+    entry.attempts = 0;
+    entry.state = EntryState::QUEUED;
+    stats_.submitted++;
+
+    if (!cancelling_)
+      send_ready_(now_ms);
+    return true;
+  }
+
+  stats_.rejected++;
+  return false;
+}
+
+bool RequestEngine::handle_response(const RawPacketView &response, uint32_t now_ms) {
+  Transaction transaction;
+  if (!tracker_.complete(response, now_ms, &transaction))
+    return false;
+
+  Entry *entry = find_in_flight_(transaction.sequence);
+  if (entry == nullptr)
+    return false;
+
+  stats_.responded++;
+  // Only responses to our own GETs are learned from, since only they can be ordered against our SETs
+  bool is_get = entry->request.view().get_packet_type() == static_cast<uint8_t>(PacketType::GET_REQUEST);
+  if (set_filter_ != nullptr && entry->filtered && is_get)
+    set_filter_->process_frame(response, now_ms, entry->filter_generation);
+  finish_(*entry, RequestResult::RESPONDED, response);
+  send_ready_(now_ms);
+  return true;
+}
+
+void RequestEngine::loop(uint32_t now_ms) {
+  tracker_.expire(now_ms, [this, now_ms](const Transaction &transaction) { handle_timeout_(transaction, now_ms); });
+  send_ready_(now_ms);
+}
+
+void RequestEngine::handle_timeout_(const Transaction &transaction, uint32_t now_ms) {
+  Entry *entry = find_in_flight_(transaction.sequence);
+  if (entry == nullptr)
+    return;
+
+  entry->state = EntryState::BACKOFF;
+  in_flight_--;
+  if (entry->attempts > config_.max_retries) {
+    stats_.timeouts++;
+    finish_(*entry, RequestResult::TIMED_OUT, NO_RESPONSE);
+    return;
+  }
+
+  entry->retry_at_ms = now_ms + (config_.backoff_ms << (entry->attempts - 1));
+}
+
+void RequestEngine::send_ready_(uint32_t now_ms) {
+  while (in_flight_ < config_.window) {
+    // Oldest submission first, so retries don't reorder requests
+    Entry *next = nullptr;
+    for (Entry &entry : entries_) {
+      bool ready = entry.state == EntryState::QUEUED ||
+                   (entry.state == EntryState::BACKOFF && is_due(now_ms, entry.retry_at_ms));
+      if (ready && (next == nullptr || static_cast<int32_t>(entry.order - next->order) < 0))
+        next = &entry;
+    }
+    if (next == nullptr)
+      return;
+
+    send_(*next, now_ms);
+  }
+}
+
+void RequestEngine::send_(Entry &entry, uint32_t now_ms) {
+  if (entry.attempts == 0 && set_filter_ != nullptr && !filter_(entry, now_ms))
+    return;
+
+  if (entry.attempts > 0)
+    stats_.retransmits++;
+  entry.attempts++;
+
+  if (!entry.request.is_response_expected()) {
+    entry.request.sequence = tracker_.next_sequence();
+    sender_(entry.request.view());
+    finish_(entry, RequestResult::SENT, NO_RESPONSE);
+    return;
+  }
+
+  uint8_t sequence;
+  if (!tracker_.begin(entry.request.view(), now_ms, config_.timeout_ms, &sequence)) {
+    // The tracker is never fuller than our own table, so this can't happen; fail rather than send untracked
+    finish_(entry, RequestResult::TIMED_OUT, NO_RESPONSE);
+    return;
+  }
+  entry.request.sequence = sequence;
+  entry.state = EntryState::IN_FLIGHT;
+  in_flight_++;
+  sender_(entry.request.view());
+}
+
+bool RequestEngine::filter_(Entry &entry, uint32_t now_ms) {
+  entry.filtered = true;
+  const RawPacketView view = entry.request.view();
+  if (view.get_packet_type() == static_cast<uint8_t>(PacketType::GET_REQUEST)) {
+    entry.filter_generation = set_filter_->get_generation();
+    return true;
+  }
+  if (view.get_packet_type() != static_cast<uint8_t>(PacketType::SET_REQUEST))
+    return true;
+
+  // Filtered against the state known now, not when it was submitted, since queued requests may have changed it
+  RawPacket filtered = entry.request.to_raw_packet();
+  switch (set_filter_->filter(filtered, now_ms)) {
+    case SetFilterResult::SUPPRESS:
+      stats_.suppressed++;
+      finish_(entry, RequestResult::SUPPRESSED, NO_RESPONSE);
+      return false;
+    case SetFilterResult::SEND_MODIFIED:
+      memcpy(entry.request.bytes, filtered.get_bytes(), filtered.get_length());
+      return true;
+    default:
+      return true;
+  }
+}
+
+RequestEngine::Entry *RequestEngine::find_in_flight_(uint8_t sequence) {
+  for (Entry &entry : entries_) {
+    if (entry.state == EntryState::IN_FLIGHT && entry.request.sequence == sequence)
+      return &entry;
+  }
+  return nullptr;
+}
+
+void RequestEngine::finish_(Entry &entry, RequestResult result, const RawPacketView &response) {
+  if (entry.state == EntryState::IN_FLIGHT)
+    in_flight_--;
+  // A SET that went out has been answered (or has failed), so later GETs may learn its settings again
+  if (set_filter_ != nullptr && entry.filtered && entry.attempts > 0)
+    set_filter_->settle(entry.request.view());
+
+  // Free the entry before calling back, so the callback can submit a follow-up request
+  RequestCallback callback = std::move(entry.callback);
+  entry.callback = nullptr;
+  entry.state = EntryState::FREE;
+
+  if (callback)
+    callback(result, response);
+}
+
+void RequestEngine::cancel_all() {
+  tracker_.clear();
+  if (set_filter_ != nullptr)
+    set_filter_->invalidate();
+
+  // Free every entry before calling back, so requests the callbacks submit aren't cancelled too (or not, depending
+  // on where their slot falls), and hold them back until we return
+  RequestCallback callbacks[MAX_PENDING];
+  size_t count = 0;
+  for (Entry &entry : entries_) {
+    if (entry.state == EntryState::FREE)
+      continue;
+    callbacks[count++] = std::move(entry.callback);
+    entry.callback = nullptr;
+    entry.state = EntryState::FREE;
+  }
+  in_flight_ = 0;
+
+  bool was_cancelling = cancelling_;
+  cancelling_ = true;
+  for (size_t i = 0; i < count; i++) {
+    if (callbacks[i])
+      callbacks[i](RequestResult::CANCELLED, NO_RESPONSE);
+  }
+  cancelling_ = was_cancelling;
+}
+
+size_t RequestEngine::get_pending() const {
+  size_t count = 0;
+  for (const Entry &entry : entries_) {
+    count += entry.state != EntryState::FREE;
+  }
+  return count;
+}
+
+}  // namespace itp_packet
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <functional>
+#include "itp_packet.h"
+#include "itp_packetrecord.h"
+#include "itp_rawpacketview.h"
+#include "itp_redundantsetfilter.h"
+#include "itp_transactions.h"
+
+namespace itp_packet {
+
+enum class RequestResult {
+  RESPONDED,   // A matching response arrived
+  SENT,        // The request doesn't expect a response, and has been written
+  TIMED_OUT,   // No response arrived after every retry
+  CANCELLED,   // cancel_all() was called (e.g. the link was reset)
+  SUPPRESSED,  // A set request the unit already satisfies, so it was never sent; treat as a success
+};
+
+// Writes a frame to the link (e.g. a UART)
+using RequestSender = std::function<void(const RawPacketView &frame)>;
+// Receives the outcome of a request.  response is only valid during the call, and is empty (length 0) unless the
+// result is RESPONDED.
+using RequestCallback = std::function<void(RequestResult result, const RawPacketView &response)>;
+
+struct RequestEngineConfig {
+  uint8_t window = 4;         // Requests allowed on the wire at once
+  uint32_t timeout_ms = 500;  // Time to wait for a response before retrying
+  uint8_t max_retries = 2;    // Retransmissions before a request times out
+  uint32_t backoff_ms = 100;  // Delay before the first retry; doubles with each further retry
+};
+
+// Counters describing an engine's traffic since construction (or the last reset_stats()).
+struct RequestEngineStats {
+  uint32_t submitted = 0;
+  uint32_t responded = 0;
+  uint32_t retransmits = 0;
+  uint32_t timeouts = 0;    // Requests that failed after every retry
+  uint32_t rejected = 0;    // Requests refused because the queue was full
+  uint32_t suppressed = 0;  // Set requests dropped by the RedundantSetFilter
+};
+
+/* Keeps a window of requests outstanding on one link instead of waiting for each response before sending the next
+request, so a refresh cycle costs roughly one round trip rather than one per request.  Requests are sent in the order
+they were submitted; timed-out requests are retransmitted after a backoff, and every request's callback is called
+exactly once with its outcome.
+
+Responses are matched to requests with a TransactionTracker, so requests from either ControllerAssociation (e.g. our
+own polling and requests proxied for a thermostat) can share a link.  Storage is fixed-size, and the engine is not
+thread-safe: submit(), handle_response() and loop() must be called from the same thread.  Callbacks may submit new
+requests.
+*/
+class RequestEngine {
+ public:
+  static const size_t MAX_PENDING = TransactionTracker::MAX_IN_FLIGHT;
+
+  RequestEngine(RequestSender sender, RequestEngineConfig config = {})
+      : sender_{std::move(sender)}, config_{config}, tracker_{config.timeout_ms} {}
+
+  // Queues a request to be sent on the next loop() (or immediately, if the window has room).  Returns false if the
+  // queue is full, in which case the callback is not called.  A set request is passed through the filter (if any)
+  // when its turn to be sent comes; if it's suppressed, its callback is called with SUPPRESSED instead.
+  bool submit(const Packet &request, RequestCallback callback = nullptr, uint32_t now_ms = 0);
+  bool submit(const RawPacket &request, RequestCallback callback = nullptr, uint32_t now_ms = 0);
+
+  // Passes a frame received from the link to the engine.  Returns true if it answered one of our requests.
+  bool handle_response(const RawPacketView &response, uint32_t now_ms);
+
+  // Retransmits or fails requests whose responses are overdue, and sends queued requests while the window has room.
+  // Call regularly (e.g. from a component's loop()).
+  void loop(uint32_t now_ms);
+
+  // Fails every queued and outstanding request with CANCELLED.  Every request is removed before any callback runs;
+  // requests the callbacks submit are queued, and sent by the next loop().
+  void cancel_all();
+
+  // Passes set requests through filter as they're first sent.  The filter learns the unit's state from responses to
+  // our settings GETs, and from each SET's outcome.  The filter must outlive the engine; nullptr (the default) sends
+  // everything as submitted.
+  void set_set_filter(RedundantSetFilter *filter) { set_filter_ = filter; }
+
+  size_t get_pending() const;
+  size_t get_in_flight() const { return in_flight_; }
+
+  const RequestEngineStats &get_stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+  // Matching and round-trip statistics for this link
+  const TransactionTracker &get_tracker() const { return tracker_; }
+
+ private:
+  enum class EntryState : uint8_t { FREE, QUEUED, IN_FLIGHT, BACKOFF };
+
+  struct Entry {
+    PacketRecord request;
+    RequestCallback callback;
+    uint32_t order;
+    uint32_t retry_at_ms;
+    uint32_t filter_generation;  // The set filter's generation when a GET was first sent
+    bool filtered;               // The set filter saw the request when it was first sent
+    uint8_t attempts;
+    EntryState state = EntryState::FREE;
+  };
+
+  RequestSender sender_;
+  RequestEngineConfig config_;
+  TransactionTracker tracker_;
+  RedundantSetFilter *set_filter_ = nullptr;
+  Entry entries_[MAX_PENDING];
+  uint32_t next_order_ = 0;
+  size_t in_flight_ = 0;
+  bool cancelling_ = false;  // Inside cancel_all(); nothing is sent until it returns
+  RequestEngineStats stats_;
+
+  bool enqueue_(const PacketRecord &request, RequestCallback &&callback, uint32_t now_ms);
+  void send_ready_(uint32_t now_ms);
+  void send_(Entry &entry, uint32_t now_ms);
+  // Runs a request through the set filter before its first transmission.  Returns false if it was suppressed.
+  bool filter_(Entry &entry, uint32_t now_ms);
+  void handle_timeout_(const Transaction &transaction, uint32_t now_ms);
+  Entry *find_in_flight_(uint8_t sequence);
+  void finish_(Entry &entry, RequestResult result, const RawPacketView &response);
+};
+
+}  // namespace itp_packet
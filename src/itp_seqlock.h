@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <stdint.h>
+#include <type_traits>
+
+namespace itp_packet {
+
+/* A sequence lock: one writer publishes a value of T, and any number of readers take consistent copies of it without
+ever blocking the writer (or each other).  A reader that overlaps a write simply retries, so reads are cheap while
+writes are rare compared to reads.
+
+The value is stored as an array of 32-bit atomics rather than a plain T, so concurrent reads and writes are
+well-defined, and so that it stays lock-free on 32-bit microcontrollers.  Only one thread may write at a time.
+*/
+template<typename T> class SeqLock {
+  static_assert(std::is_trivially_copyable_v<T>, "SeqLock values must be trivially copyable");
+
+ public:
+  SeqLock() : SeqLock(T{}) {}
+  explicit SeqLock(const T &value) : shadow_{value} { store_words_(value); }
+
+  // Publishes a new value
+  void write(const T &value) {
+    shadow_ = value;
+    publish_();
+  }
+
+  // Modifies the current value in place through fn(T &) and publishes the result
+  template<typename F> void update(F &&fn) {
+    fn(shadow_);
+    publish_();
+  }
+
+  // The writer's own copy of the current value; only valid on the writing thread
+  const T &get_written() const { return shadow_; }
+
+  // Returns a consistent copy of the current value, retrying while a write is in progress
+  T read() const {
+    T value;
+    while (!try_read(value)) {
+    }
+    return value;
+  }
+
+  // Takes a single attempt at reading the value; returns false if a write was in progress
+  bool try_read(T &value) const {
+    uint32_t before = sequence_.load(std::memory_order_acquire);
+    if (before & 1)
+      return false;
+
+    uint32_t words[WORD_COUNT];
+    for (size_t i = 0; i < WORD_COUNT; i++) {
+      words[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) != before)
+      return false;
+
+    memcpy(&value, words, sizeof(T));
+    return true;
+  }
+
+  // Incremented twice per write; readers can compare it to tell whether anything has been written since
+  uint32_t get_sequence() const { return sequence_.load(std::memory_order_acquire); }
+
+ private:
+  static const size_t WORD_COUNT = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<uint32_t> words_[WORD_COUNT];
+  T shadow_;
+
+  void publish_() {
+    uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    store_words_(shadow_);
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  void store_words_(const T &value) {
+    uint32_t words[WORD_COUNT] = {};
+    memcpy(words, &value, sizeof(T));
+    for (size_t i = 0; i < WORD_COUNT; i++) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+};
+
+}  // namespace itp_packet
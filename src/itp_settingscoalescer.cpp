@@ -0,0 +1,77 @@
+#include "itp_settingscoalescer.h"
+
+namespace itp_packet {
+
+bool SettingsCoalescer::submit(const SettingsSetRequestPacket &change, uint32_t now_ms,
+                               SettingsCompletion on_complete) {
+  if (on_complete && waiter_count_ >= MAX_WAITERS) {
+    stats_.rejected++;
+    return false;
+  }
+
+  if (!has_pending_) {
+    pending_ = SettingsSetRequestPacket();
+    has_pending_ = true;
+    deadline_ms_ = now_ms + window_ms_;
+  }
+  pending_.merge(change);
+  stats_.changes++;
+
+  // Waiters for the pending batch always sit after those for batches already sent
+  if (on_complete)
+    waiters_[waiter_count_++] = {std::move(on_complete), next_batch_id_};
+  return true;
+}
+
+bool SettingsCoalescer::take_ready(uint32_t now_ms, SettingsSetRequestPacket &request, uint32_t &batch_id) {
+  if (!has_pending_ || static_cast<int32_t>(now_ms - deadline_ms_) < 0)
+    return false;
+  return flush(request, batch_id);
+}
+
+bool SettingsCoalescer::flush(SettingsSetRequestPacket &request, uint32_t &batch_id) {
+  if (!has_pending_)
+    return false;
+
+  request = pending_;
+  batch_id = next_batch_id_++;
+  has_pending_ = false;
+  stats_.batches++;
+  return true;
+}
+
+void SettingsCoalescer::complete(uint32_t batch_id, bool success) { finish_(batch_id, false, success); }
+
+void SettingsCoalescer::cancel_all() {
+  if (has_pending_) {
+    has_pending_ = false;
+    next_batch_id_++;
+  }
+  finish_(0, true, false);
+}
+
+void SettingsCoalescer::finish_(uint32_t batch_id, bool all, bool success) {
+  // Take the callbacks out first, so they can submit new changes
+  SettingsCompletion finished[MAX_WAITERS];
+  size_t finished_count = 0;
+  size_t kept = 0;
+  for (size_t i = 0; i < waiter_count_; i++) {
+    if (all || waiters_[i].batch_id == batch_id) {
+      finished[finished_count++] = std::move(waiters_[i].callback);
+    } else if (kept != i) {
+      waiters_[kept++] = std::move(waiters_[i]);
+    } else {
+      kept++;
+    }
+  }
+  for (size_t i = kept; i < waiter_count_; i++) {
+    waiters_[i].callback = nullptr;
+  }
+  waiter_count_ = kept;
+
+  for (size_t i = 0; i < finished_count; i++) {
+    finished[i](success);
+  }
+}
+
+}  // namespace itp_packet
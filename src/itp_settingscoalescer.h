@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include "packets/set.h"
+
+namespace itp_packet {
+
+// Called once the request carrying a change has been answered (success is SetResponsePacket::is_successful()), or
+// has failed (success is false)
+using SettingsCompletion = std::function<void(bool success)>;
+
+// Counters describing a coalescer's activity since construction (or the last reset_stats()).
+struct SettingsCoalescerStats {
+  uint32_t changes = 0;   // Changes accepted by submit()
+  uint32_t batches = 0;   // Requests produced by take_ready()/flush()
+  uint32_t rejected = 0;  // Changes refused because too many callers were waiting
+};
+
+/* Merges settings changes made in quick succession (e.g. a slider dragged across ten temperatures) into a single
+SettingsSetRequestPacket, so a burst costs one request and one response instead of one per change.  The first change
+opens a window of window_ms; every change submitted before it closes is merged into the same request, and when a
+field is changed more than once the last value wins.
+
+Each caller may pass a completion callback, which is called when the request its change went out in is answered.
+The coalescer doesn't send anything: call take_ready() regularly, send the request it returns, and report the outcome
+with complete() and the batch id it returned.  All methods must be called from the same thread.
+*/
+class SettingsCoalescer {
+ public:
+  static const size_t MAX_WAITERS = 16;
+  static const uint32_t DEFAULT_WINDOW_MS = 100;
+
+  SettingsCoalescer(uint32_t window_ms = DEFAULT_WINDOW_MS) : window_ms_{window_ms} {}
+
+  // Merges change into the pending request.  Returns false (and merges nothing) if too many callers are already
+  // waiting for completion.
+  bool submit(const SettingsSetRequestPacket &change, uint32_t now_ms, SettingsCompletion on_complete = nullptr);
+
+  // When the pending request's window has closed, moves it into request, sets batch_id and returns true
+  bool take_ready(uint32_t now_ms, SettingsSetRequestPacket &request, uint32_t &batch_id);
+  // As take_ready(), without waiting for the window to close (e.g. before powering off)
+  bool flush(SettingsSetRequestPacket &request, uint32_t &batch_id);
+
+  // Reports the outcome of a batch returned by take_ready() or flush(), calling every waiting callback for it
+  void complete(uint32_t batch_id, bool success);
+  // Fails every pending change and every batch awaiting completion (e.g. after the link is reset)
+  void cancel_all();
+
+  bool has_pending() const { return has_pending_; }
+  // When the pending request's window closes; only meaningful if has_pending()
+  uint32_t get_deadline() const { return deadline_ms_; }
+
+  const SettingsCoalescerStats &get_stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+
+ private:
+  struct Waiter {
+    SettingsCompletion callback;
+    uint32_t batch_id;
+  };
+
+  uint32_t window_ms_;
+  SettingsSetRequestPacket pending_;
+  bool has_pending_ = false;
+  uint32_t deadline_ms_ = 0;
+  uint32_t next_batch_id_ = 0;
+
+  Waiter waiters_[MAX_WAITERS];
+  size_t waiter_count_ = 0;
+  SettingsCoalescerStats stats_;
+
+  // Calls and removes every waiter matching batch_id (or all waiters, if all is set)
+  void finish_(uint32_t batch_id, bool all, bool success);
+};
+
+}  // namespace itp_packet
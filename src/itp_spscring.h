@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+#include <type_traits>
+#include "itp_packetrecord.h"
+
+namespace itp_packet {
+
+// How a consumer waits in SpscRing::wait_pop_batch() when the ring is empty
+enum class SpscWaitMode {
+  BLOCKING,   // Sleep until the producer pushes (falls back to polling where std::atomic::wait is unavailable)
+  BUSY_POLL,  // Spin on the ring; lowest latency, but keeps a core busy
+};
+
+// Counters describing a ring's traffic since construction (or the last reset_stats()).  Safe to read from any thread.
+struct SpscRingStats {
+  uint32_t pushed = 0;      // Items accepted by push()/push_batch()
+  uint32_t popped = 0;      // Items returned by pop()/pop_batch()
+  uint32_t overflows = 0;   // Items rejected because the ring was full
+  uint32_t high_water = 0;  // Most items the consumer has found waiting at once
+};
+
+/* A bounded, lock-free single-producer/single-consumer ring of trivially copyable items (normally PacketRecords),
+for handing frames from a reader thread to a processing thread without a mutex.  Exactly one thread may push and
+exactly one thread may pop.  Each side caches the other's index and only reloads it when the cached value says the
+ring is full (producer) or has fewer items than requested (consumer), so the two index cache lines are only written by
+their owners.  A push also reads the consumer's sleep flag, which lives on a line that's only written when the
+consumer goes to sleep or wakes up.  high_water is sampled by the consumer whenever it reloads the producer's index,
+so it's the most items the consumer has found waiting, a lower bound on the true peak.
+
+When the ring is full, new items are rejected (and counted as overflows) rather than overwriting unread ones.
+*/
+template<typename T, size_t CAPACITY> class SpscRing {
+  static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscRing capacity must be a power of two");
+  static_assert(std::is_trivially_copyable_v<T>, "SpscRing items must be trivially copyable");
+
+ public:
+  static const size_t CACHE_LINE_SIZE = 64;
+
+  constexpr size_t capacity() const { return CAPACITY; }
+
+  // Number of items waiting; exact only when called from one of the two sides with the other idle
+  size_t size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+
+  // Producer side.  Returns false (and counts an overflow) if the ring is full.
+  bool push(const T &item) { return push_batch(&item, 1) == 1; }
+
+  // Producer side.  Pushes as many of items as fit, returning the number pushed; the rest are counted as overflows.
+  size_t push_batch(const T *items, size_t count) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t free = CAPACITY - (tail - head_cache_);
+    if (free < count) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      free = CAPACITY - (tail - head_cache_);
+    }
+
+    size_t pushed = count < free ? count : free;
+    for (size_t i = 0; i < pushed; i++) {
+      slots_[(tail + i) & MASK] = items[i];
+    }
+    tail_.store(tail + pushed, std::memory_order_release);
+
+    if (pushed > 0) {
+      pushed_.store(pushed_.load(std::memory_order_relaxed) + pushed, std::memory_order_relaxed);
+      wake_consumer_();
+    }
+    if (pushed < count)
+      overflows_.store(overflows_.load(std::memory_order_relaxed) + (count - pushed), std::memory_order_relaxed);
+
+    return pushed;
+  }
+
+  // Consumer side.  Returns false if the ring is empty.
+  bool pop(T &item) { return pop_batch(&item, 1) == 1; }
+
+  // Consumer side.  Pops up to max_count items into out without waiting, returning the number popped.
+  size_t pop_batch(T *out, size_t max_count) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t available = tail_cache_ - head;
+    if (available < max_count) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      available = tail_cache_ - head;
+      if (available > high_water_.load(std::memory_order_relaxed))
+        high_water_.store(available, std::memory_order_relaxed);
+    }
+
+    size_t popped = max_count < available ? max_count : available;
+    for (size_t i = 0; i < popped; i++) {
+      out[i] = slots_[(head + i) & MASK];
+    }
+    if (popped > 0) {
+      head_.store(head + popped, std::memory_order_release);
+      popped_.store(popped_.load(std::memory_order_relaxed) + popped, std::memory_order_relaxed);
+    }
+
+    return popped;
+  }
+
+  // Consumer side.  As pop_batch(), but waits until at least one item is available.  Returns 0 only once the ring
+  // has been closed and drained.
+  size_t wait_pop_batch(T *out, size_t max_count, SpscWaitMode mode = SpscWaitMode::BLOCKING) {
+    while (true) {
+      size_t popped = pop_batch(out, max_count);
+      if (popped > 0)
+        return popped;
+      if (closed_.load(std::memory_order_acquire)) {
+        // The producer may have pushed just before closing
+        return pop_batch(out, max_count);
+      }
+
+      if (mode == SpscWaitMode::BUSY_POLL) {
+        cpu_relax_();
+      } else {
+        wait_for_producer_();
+      }
+    }
+  }
+
+  // Wakes a blocked consumer and makes wait_pop_batch() return 0 once the ring is drained.  Called by the producer
+  // (or any thread) at shutdown.
+  void close() {
+    closed_.store(true, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wake_epoch_.fetch_add(1, std::memory_order_release);
+#ifdef __cpp_lib_atomic_wait
+    wake_epoch_.notify_all();
+#endif
+  }
+  bool is_closed() const { return closed_.load(std::memory_order_acquire); }
+
+  SpscRingStats get_stats() const {
+    SpscRingStats stats;
+    stats.pushed = pushed_.load(std::memory_order_relaxed);
+    stats.popped = popped_.load(std::memory_order_relaxed);
+    stats.overflows = overflows_.load(std::memory_order_relaxed);
+    stats.high_water = high_water_.load(std::memory_order_relaxed);
+    return stats;
+  }
+  // Only safe while neither side is running
+  void reset_stats() {
+    pushed_.store(0, std::memory_order_relaxed);
+    popped_.store(0, std::memory_order_relaxed);
+    overflows_.store(0, std::memory_order_relaxed);
+    high_water_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  static const size_t MASK = CAPACITY - 1;
+
+  // Consumer-owned
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+  size_t tail_cache_ = 0;
+  std::atomic<uint32_t> popped_{0};
+  std::atomic<uint32_t> high_water_{0};
+
+  // Producer-owned
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+  size_t head_cache_ = 0;
+  std::atomic<uint32_t> pushed_{0};
+  std::atomic<uint32_t> overflows_{0};
+
+  // Shared, but only written when a consumer is (about to be) asleep, when it wakes, or at shutdown
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> wake_epoch_{0};
+  std::atomic<bool> waiting_{false};
+  std::atomic<bool> closed_{false};
+
+  alignas(CACHE_LINE_SIZE) T slots_[CAPACITY];
+
+  // The producer publishes tail_ then checks waiting_; the consumer publishes waiting_ then checks tail_.  The
+  // seq_cst fences on both sides guarantee at least one of them sees the other, so a wakeup is never lost, and an
+  // unblocked producer never touches wake_epoch_.
+  void wake_consumer_() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_.load(std::memory_order_relaxed)) {
+      wake_epoch_.fetch_add(1, std::memory_order_release);
+#ifdef __cpp_lib_atomic_wait
+      wake_epoch_.notify_one();
+#endif
+    }
+  }
+
+  void wait_for_producer_() {
+    uint32_t epoch = wake_epoch_.load(std::memory_order_acquire);
+    waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (tail_.load(std::memory_order_relaxed) == head_.load(std::memory_order_relaxed) &&
+        !closed_.load(std::memory_order_relaxed)) {
+#ifdef __cpp_lib_atomic_wait
+      wake_epoch_.wait(epoch, std::memory_order_acquire);
+#else
+      while (wake_epoch_.load(std::memory_order_acquire) == epoch)
+        cpu_relax_();
+#endif
+    }
+
+    waiting_.store(false, std::memory_order_relaxed);
+  }
+
+  static void cpu_relax_() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+  }
+};
+
+// The standard handoff between a UART reader and packet processing
+template<size_t CAPACITY> using PacketRecordRing = SpscRing<PacketRecord, CAPACITY>;
+
+}  // namespace itp_packet
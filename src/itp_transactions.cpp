@@ -0,0 +1,138 @@
+#include "itp_transactions.h"
+
+namespace itp_packet {
+
+// True if time a is after time b, allowing for wraparound
+static bool is_after(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) > 0; }
+
+bool TransactionTracker::begin(Packet &request, uint32_t now_ms, uint32_t timeout_ms) {
+  uint8_t sequence = next_sequence();
+  request.set_sequence(sequence);
+  if (!request.is_response_expected())
+    return false;
+
+  const RawPacket &pkt = request.raw_packet();
+  return track_(pkt.get_packet_type(), pkt.get_command(), sequence, now_ms, timeout_ms);
+}
+
+bool TransactionTracker::begin(const RawPacketView &request, uint32_t now_ms, uint32_t timeout_ms,
+                               uint8_t *sequence) {
+  uint8_t assigned = next_sequence();
+  if (sequence != nullptr)
+    *sequence = assigned;
+  return track_(request.get_packet_type(), request.get_command(), assigned, now_ms, timeout_ms);
+}
+
+bool TransactionTracker::track_(uint8_t request_type, uint8_t command, uint8_t sequence, uint32_t now_ms,
+                                uint32_t timeout_ms) {
+  for (Slot &slot : slots_) {
+    if (slot.in_use)
+      continue;
+
+    slot.transaction = {sequence, request_type, command, now_ms,
+                        now_ms + (timeout_ms == 0 ? default_timeout_ms_ : timeout_ms)};
+    slot.order = next_order_++;
+    slot.in_use = true;
+    stats_.requests++;
+    return true;
+  }
+
+  stats_.overflows++;
+  return false;
+}
+
+bool TransactionTracker::complete(const RawPacketView &response, uint32_t now_ms, Transaction *transaction,
+                                  uint32_t *rtt_ms) {
+  uint8_t response_type = response.get_packet_type();
+  // Set and connect responses don't echo a command, so they can only be matched in order
+  bool match_command = response_type != static_cast<uint8_t>(PacketType::SET_RESPONSE) &&
+                       response_type != static_cast<uint8_t>(PacketType::CONNECT_RESPONSE);
+  uint8_t command = response.get_command();
+
+  Slot *oldest = nullptr;
+  for (Slot &slot : slots_) {
+    if (!slot.in_use || response_type_for(slot.transaction.request_type) != response_type)
+      continue;
+    if (match_command && slot.transaction.command != command)
+      continue;
+    if (oldest == nullptr || is_after(oldest->order, slot.order))
+      oldest = &slot;
+  }
+
+  if (oldest == nullptr) {
+    stats_.unmatched_responses++;
+    return false;
+  }
+
+  oldest->in_use = false;
+  uint32_t rtt = now_ms - oldest->transaction.sent_ms;
+  stats_.completed++;
+  stats_.rtt_total_ms += rtt;
+  if (rtt < stats_.rtt_min_ms)
+    stats_.rtt_min_ms = rtt;
+  if (rtt > stats_.rtt_max_ms)
+    stats_.rtt_max_ms = rtt;
+
+  if (transaction != nullptr)
+    *transaction = oldest->transaction;
+  if (rtt_ms != nullptr)
+    *rtt_ms = rtt;
+  return true;
+}
+
+size_t TransactionTracker::take_expired_(uint32_t now_ms, Transaction expired[MAX_IN_FLIGHT]) {
+  size_t count = 0;
+  uint32_t orders[MAX_IN_FLIGHT];
+  for (Slot &slot : slots_) {
+    if (!slot.in_use || is_after(slot.transaction.deadline_ms, now_ms))
+      continue;
+
+    // Insertion sort by tracking order, so callbacks see the oldest request first
+    size_t i = count++;
+    for (; i > 0 && is_after(orders[i - 1], slot.order); i--) {
+      expired[i] = expired[i - 1];
+      orders[i] = orders[i - 1];
+    }
+    expired[i] = slot.transaction;
+    orders[i] = slot.order;
+    slot.in_use = false;
+  }
+
+  stats_.timeouts += count;
+  return count;
+}
+
+void TransactionTracker::clear() {
+  for (Slot &slot : slots_) {
+    slot.in_use = false;
+  }
+}
+
+size_t TransactionTracker::get_in_flight() const {
+  size_t count = 0;
+  for (const Slot &slot : slots_) {
+    count += slot.in_use;
+  }
+  return count;
+}
+
+bool TransactionTracker::get_next_deadline(uint32_t &deadline_ms) const {
+  bool found = false;
+  for (const Slot &slot : slots_) {
+    if (slot.in_use && (!found || is_after(deadline_ms, slot.transaction.deadline_ms))) {
+      deadline_ms = slot.transaction.deadline_ms;
+      found = true;
+    }
+  }
+  return found;
+}
+
+TransactionStats TransactionTracker::get_stats() const {
+  return stats_;
+}
+
+void TransactionTracker::reset_stats() {
+  stats_ = {};
+}
+
+}  // namespace itp_packet
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "itp_packet.h"
+#include "itp_rawpacketview.h"
+
+namespace itp_packet {
+
+// A request that is waiting for its response
+struct Transaction {
+  uint8_t sequence;
+  uint8_t request_type;  // PacketType of the request
+  uint8_t command;       // First payload byte of the request
+  uint32_t sent_ms;
+  uint32_t deadline_ms;
+};
+
+// Counters describing a tracker's traffic since construction (or the last reset_stats()).
+struct TransactionStats {
+  uint32_t requests = 0;             // Requests tracked by begin()
+  uint32_t completed = 0;            // Responses matched to a request
+  uint32_t timeouts = 0;             // Requests expired without a response
+  uint32_t unmatched_responses = 0;  // Responses with no matching request in flight
+  uint32_t overflows = 0;            // Requests not tracked because the in-flight table was full
+  uint32_t rtt_min_ms = UINT32_MAX;
+  uint32_t rtt_max_ms = 0;
+  uint64_t rtt_total_ms = 0;  // Divide by completed for the mean
+
+  uint32_t get_rtt_mean_ms() const { return completed == 0 ? 0 : rtt_total_ms / completed; }
+};
+
+/* Correlates requests sent on one link with the responses that come back, so that callers can tell which request
+a response answers, how long it took, and which requests never got one.  Use one tracker per serial link; each
+assigns its own sequence numbers.
+
+Responses are matched by packet type and command:
+- GET_RESPONSE and IDENTIFY_RESPONSE go to the oldest in-flight request with the same command
+  (e.g. a GetRequestPacket's get_requested_command()).
+- SET_RESPONSE and CONNECT_RESPONSE carry no command, so they go to the oldest in-flight request of that type.
+
+Time is supplied by the caller (e.g. millis()), and comparisons are safe across wraparound.  The tracker is not
+thread-safe: like the link it serves, it must be used from one thread (or task).  Expiry callbacks run after the
+expired requests have been removed, so they may begin new ones.
+*/
+class TransactionTracker {
+ public:
+  static const size_t MAX_IN_FLIGHT = 16;
+  static const uint32_t DEFAULT_TIMEOUT_MS = 2000;
+
+  TransactionTracker(uint32_t default_timeout_ms = DEFAULT_TIMEOUT_MS) : default_timeout_ms_{default_timeout_ms} {}
+
+  // Returns the next sequence number for this link
+  uint8_t next_sequence() { return next_sequence_++; }
+
+  // Assigns the request a sequence number and, if it expects a response, starts tracking it with a deadline of
+  // now_ms + timeout_ms (or the default timeout if 0).  Returns false if the request isn't being tracked.
+  bool begin(Packet &request, uint32_t now_ms, uint32_t timeout_ms = 0);
+  // As above, for a frame sent without a Packet (e.g. a prebuilt request frame).  Returns the assigned sequence
+  // number through sequence.
+  bool begin(const RawPacketView &request, uint32_t now_ms, uint32_t timeout_ms = 0, uint8_t *sequence = nullptr);
+
+  // Matches a received response to the request it answers, removing that request from the table.  On a match,
+  // fills in transaction (if supplied) and rtt_ms, and returns true.
+  bool complete(const RawPacketView &response, uint32_t now_ms, Transaction *transaction = nullptr,
+                uint32_t *rtt_ms = nullptr);
+  bool complete(const Packet &response, uint32_t now_ms, Transaction *transaction = nullptr,
+                uint32_t *rtt_ms = nullptr) {
+    return complete(response.raw_view(), now_ms, transaction, rtt_ms);
+  }
+
+  // Removes every request whose deadline has passed, calling on_timeout(const Transaction &) for each (oldest
+  // first).  Returns the number expired.
+  template<typename F> size_t expire(uint32_t now_ms, F &&on_timeout) {
+    Transaction expired[MAX_IN_FLIGHT];
+    size_t count = take_expired_(now_ms, expired);
+    for (size_t i = 0; i < count; i++) {
+      on_timeout(expired[i]);
+    }
+    return count;
+  }
+  size_t expire(uint32_t now_ms) {
+    return expire(now_ms, [](const Transaction &) {});
+  }
+
+  // Forgets every in-flight request without counting timeouts (e.g. after the link is reset)
+  void clear();
+
+  size_t get_in_flight() const;
+  // Earliest deadline among in-flight requests; returns false if there are none
+  bool get_next_deadline(uint32_t &deadline_ms) const;
+
+  TransactionStats get_stats() const;
+  void reset_stats();
+
+  // The response type a request of request_type is answered with (by convention, the request type with 0x20 set)
+  static constexpr uint8_t response_type_for(uint8_t request_type) { return request_type | 0x20; }
+
+ private:
+  struct Slot {
+    Transaction transaction;
+    uint32_t order;  // Tracking order, for oldest-first matching
+    bool in_use;
+  };
+
+  uint32_t default_timeout_ms_;
+  uint8_t next_sequence_ = 0;
+
+  Slot slots_[MAX_IN_FLIGHT]{};
+  uint32_t next_order_ = 0;
+  TransactionStats stats_;
+
+  bool track_(uint8_t request_type, uint8_t command, uint8_t sequence, uint32_t now_ms, uint32_t timeout_ms);
+  size_t take_expired_(uint32_t now_ms, Transaction expired[MAX_IN_FLIGHT]);
+};
+
+}  // namespace itp_packet
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <array>
 #include <bit>
 #include <cstring>
+#include <stdint.h>
 #include <math.h>
 #include <string>
 #include <type_traits>
@@ -9,6 +11,24 @@
 
 namespace itp_packet {
 
+// Byte-to-temperature lookup tables (in tenths of a degree C) for ITPUtils' fixed-point converters, built at compile
+// time from the same formulas as the float converters
+namespace deci_c_tables {
+template<typename F> constexpr std::array<int16_t, 256> make(F decode) {
+  std::array<int16_t, 256> table{};
+  for (int i = 0; i < 256; i++) {
+    table[i] = static_cast<int16_t>(decode(i));
+  }
+  return table;
+}
+
+inline constexpr std::array<int16_t, 256> TEMP_SCALE_A = make([](int value) { return (value - 128) * 5; });
+inline constexpr std::array<int16_t, 256> LEGACY_TARGET_TEMP =
+    make([](int value) { return (31 - (value & 0x0F)) * 10 + ((value & 0xF0) > 0 ? 5 : 0); });
+inline constexpr std::array<int16_t, 256> LEGACY_HP_ROOM_TEMP = make([](int value) { return (value + 10) * 10; });
+inline constexpr std::array<int16_t, 256> LEGACY_TS_ROOM_TEMP = make([](int value) { return 80 + value * 5; });
+}  // namespace deci_c_tables
+
 class ITPUtils {
  public:
   /// Read a string out of data, wordSize bits at a time.
@@ -16,6 +36,12 @@ class ITPUtils {
   static std::string decode_n_bit_string(const uint8_t data[], size_t data_length, size_t word_size = 6) {
     auto result = std::string();
 
+    if (word_size == 6) {
+      result.resize(data_length);
+      decode_6_bit_string(data, data_length, result.data());
+      return result;
+    }
+
     for (int i = 0; i < data_length; i++) {
       auto bits = bit_slice(data, i * word_size, ((i + 1) * word_size) - 1);
       if (bits <= 0x1F)
@@ -26,6 +52,64 @@ class ITPUtils {
     return result;
   }
 
+  /// As decode_n_bit_string with a word size of 6, into buffer (which must hold length + 1 chars) without allocating.
+  /// Characters are unpacked four at a time from each three bytes.  Returns length; buffer is NUL-terminated.
+  static size_t decode_6_bit_string(const uint8_t data[], size_t length, char buffer[]) {
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4, data += 3) {
+      uint32_t group = data[0] << 16 | data[1] << 8 | data[2];
+      buffer[i] = SIX_BIT_CHARS[group >> 18];
+      buffer[i + 1] = SIX_BIT_CHARS[(group >> 12) & 0x3F];
+      buffer[i + 2] = SIX_BIT_CHARS[(group >> 6) & 0x3F];
+      buffer[i + 3] = SIX_BIT_CHARS[group & 0x3F];
+    }
+
+    if (i < length) {
+      // A partial group of 1-3 characters only reaches into as many bytes
+      size_t remaining = length - i;
+      uint32_t group = data[0] << 16;
+      if (remaining > 1)
+        group |= data[1] << 8;
+      if (remaining > 2)
+        group |= data[2];
+      for (size_t j = 0; j < remaining; j++) {
+        buffer[i + j] = SIX_BIT_CHARS[(group >> (18 - 6 * j)) & 0x3F];
+      }
+    }
+
+    buffer[length] = '\0';
+    return length;
+  }
+
+  /// The inverse of decode_6_bit_string: packs length characters of str into data, four to each three bytes, and
+  /// returns the number of bytes written ((length * 6 + 7) / 8).  Lower case letters are sent as upper case, and
+  /// characters with no 6-bit code as '?'.
+  static size_t encode_6_bit_string(const char str[], size_t length, uint8_t data[]) {
+    size_t i = 0;
+    uint8_t *out = data;
+    for (; i + 4 <= length; i += 4, out += 3) {
+      uint32_t group = six_bit_code_(str[i]) << 18 | six_bit_code_(str[i + 1]) << 12 | six_bit_code_(str[i + 2]) << 6 |
+                       six_bit_code_(str[i + 3]);
+      out[0] = group >> 16;
+      out[1] = group >> 8;
+      out[2] = group;
+    }
+
+    if (i < length) {
+      size_t remaining = length - i;
+      uint32_t group = 0;
+      for (size_t j = 0; j < remaining; j++) {
+        group |= six_bit_code_(str[i + j]) << (18 - 6 * j);
+      }
+      // As many bytes as the characters reach into
+      for (size_t j = 0; j < (remaining * 6 + 7) / 8; j++) {
+        *out++ = group >> (16 - 8 * j);
+      }
+    }
+
+    return out - data;
+  }
+
   static float temp_scale_a_to_deg_c(const uint8_t value) { return (float) (value - 128) / 2.0f; }
 
   static uint8_t deg_c_to_temp_scale_a(const float value) {
@@ -74,6 +158,62 @@ class ITPUtils {
     return ((uint8_t) (2 * value)) - 16;
   }
 
+  // Fixed-point equivalents of the converters above.  Temperatures are in exact tenths of a degree C, so they can be
+  // compared and stored without float rounding, and every result is exactly ten times the float converter's
+  // (encoders take value / 10.0f).
+
+  // Returned by decoders (and accepted by setters) when a temperature isn't available, in place of NAN
+  static const int16_t DECI_C_UNAVAILABLE = INT16_MIN;
+
+  static int16_t temp_scale_a_to_deci_c(const uint8_t value) { return deci_c_tables::TEMP_SCALE_A[value]; }
+
+  static uint8_t deci_c_to_temp_scale_a(const int16_t value) {
+    if (value < -640)
+      return 0;
+    if (value > 635)
+      return 0xFF;
+
+    // Half-steps are 5 tenths, so value / 5 never lands on a tie
+    return (uint8_t) ((value + (value < 0 ? -2 : 2)) / 5 + 128);
+  }
+
+  static int16_t legacy_target_temp_to_deci_c(const uint8_t value) { return deci_c_tables::LEGACY_TARGET_TEMP[value]; }
+
+  static uint8_t deci_c_to_legacy_target_temp(const int16_t value) {
+    if (value < 160)
+      return 0x0F;
+    if (value > 315)
+      return 0x10;
+
+    return ((31 - value / 10) & 0xF) + (((value / 5) % 2) << 4);
+  }
+
+  static int16_t legacy_hp_room_temp_to_deci_c(const uint8_t value) {
+    return deci_c_tables::LEGACY_HP_ROOM_TEMP[value];
+  }
+
+  static uint8_t deci_c_to_legacy_hp_room_temp(const int16_t value) {
+    if (value < 100)
+      return 0x00;
+    if (value > 410)
+      return 0x1F;
+
+    return value / 10 - 10;
+  }
+
+  static int16_t legacy_ts_room_temp_to_deci_c(const uint8_t value) {
+    return deci_c_tables::LEGACY_TS_ROOM_TEMP[value];
+  }
+
+  static uint8_t deci_c_to_legacy_ts_room_temp(const int16_t value) {
+    if (value < 80)
+      return 0x00;
+    if (value > 395)
+      return 0x3F;
+
+    return value / 5 - 16;
+  }
+
   // START Copied from esphome/core/helpers
   static std::string format_hex_pretty(const uint8_t *data, size_t length) {
     if (length == 0)
@@ -133,10 +273,26 @@ class ITPUtils {
   }
 
  private:
+  // 6-bit character codes: 0x00-0x1F map to '@'-'_', 0x20-0x3F map to themselves (' '-'?')
+  static constexpr char SIX_BIT_CHARS[65] = "@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_ !\"#$%&'()*+,-./0123456789:;<=>?";
+
+  // The 6-bit code for a character (the inverse of SIX_BIT_CHARS)
+  static constexpr uint32_t six_bit_code_(char c) {
+    uint8_t value = c;
+    if (value >= 0x20 && value < 0x40)
+      return value;
+    if (value >= 0x40 && value < 0x60)
+      return value - 0x40;
+    if (value >= 0x60 && value < 0x80)
+      return value - 0x60;  // Lower case folds to upper case
+    return '?';
+  }
+
   /// Extract the specified bits (inclusive) from an arbitrarily-sized byte array. Does not perform bounds checks.
-  /// Max extraction is 64 bits. Preserves endianness of incoming data stream.
+  /// Max extraction is 64 bits, and the bits must lie within 8 consecutive bytes (otherwise 0 is returned).
+  /// Preserves endianness of incoming data stream.
   static uint64_t bit_slice(const uint8_t ds[], size_t start, size_t end) {
-    if ((end - start) >= 64)
+    if ((end - start) >= 64 || end / 8 - start / 8 >= 8)
       return 0;
 
     uint64_t result = 0;
@@ -151,8 +307,10 @@ class ITPUtils {
     // shift out the bits we don't want from the end (64 + credit any pre-sliced bits)
     result >>= (sizeof(uint64_t) * 8) + (start_byte * 8) - end - 1;
 
-    // mask out the number of bits we want
-    result &= (1 << (end - start + 1)) - 1;
+    // mask out the number of bits we want (in 64 bits; an int mask breaks for slices of 31 bits or more)
+    size_t width = end - start + 1;
+    if (width < 64)
+      result &= (uint64_t{1} << width) - 1;
 
     return result;
   }
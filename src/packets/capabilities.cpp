@@ -2,9 +2,9 @@
 
 namespace itp_packet {
 
-uint8_t CapabilitiesResponsePacket::get_supported_fan_speeds() const {
-  uint8_t raw_value = ((pkt_.get_payload_byte(7) & 0x10) >> 2) + ((pkt_.get_payload_byte(8) & 0x08) >> 2) +
-                      ((pkt_.get_payload_byte(9) & 0x02) >> 1);
+uint8_t CapabilitiesResponseView::get_supported_fan_speeds() const {
+  uint8_t raw_value =
+      ((get_payload_byte(7) & 0x10) >> 2) + ((get_payload_byte(8) & 0x08) >> 2) + ((get_payload_byte(9) & 0x02) >> 1);
 
   switch (raw_value) {
     case 1:
@@ -22,24 +22,32 @@ uint8_t CapabilitiesResponsePacket::get_supported_fan_speeds() const {
   }
 }
 
-std::string CapabilitiesResponsePacket::to_string() const {
-  return (
-      "Identify Base Capabilities Response: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE +
-      "HeatDisabled:" + (is_heat_disabled() ? "Yes" : "No") + " SupportsVane:" + (supports_vane() ? "Yes" : "No") +
-      " SupportsVaneSwing:" + (supports_vane_swing() ? "Yes" : "No")
-
-      + " DryDisabled:" + (is_dry_disabled() ? "Yes" : "No") + " FanDisabled:" + (is_fan_disabled() ? "Yes" : "No") +
-      " ExtTempRange:" + (has_extended_temperature_range() ? "Yes" : "No") +
-      " AutoFanDisabled:" + (auto_fan_speed_disabled() ? "Yes" : "No") +
-      " InstallerSettings:" + (supports_installer_settings() ? "Yes" : "No") +
-      " TestMode:" + (supports_test_mode() ? "Yes" : "No") + " DryTemp:" + (supports_dry_temperature() ? "Yes" : "No")
-
-      + " StatusDisplay:" + (has_status_display() ? "Yes" : "No")
-
-      + "\n " + CONSOLE_COLOR_PURPLE + "CoolDrySetpoint:" + std::to_string(get_min_cool_dry_setpoint()) + "/" +
-      std::to_string(get_max_cool_dry_setpoint()) + " HeatSetpoint:" + std::to_string(get_min_heating_setpoint()) +
-      "/" + std::to_string(get_max_heating_setpoint()) + " AutoSetpoint:" + std::to_string(get_min_auto_setpoint()) +
-      "/" + std::to_string(get_max_auto_setpoint()) + " FanSpeeds:" + std::to_string(get_supported_fan_speeds()));
+void CapabilitiesResponsePacket::format_to(PacketFormatter &out) const {
+  out.append("Identify Base Capabilities Response: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("HeatDisabled:").append_yes_no(is_heat_disabled());
+  out.append(" SupportsVane:").append_yes_no(supports_vane());
+  out.append(" SupportsVaneSwing:").append_yes_no(supports_vane_swing());
+
+  out.append(" DryDisabled:").append_yes_no(is_dry_disabled());
+  out.append(" FanDisabled:").append_yes_no(is_fan_disabled());
+  out.append(" ExtTempRange:").append_yes_no(has_extended_temperature_range());
+  out.append(" AutoFanDisabled:").append_yes_no(auto_fan_speed_disabled());
+  out.append(" InstallerSettings:").append_yes_no(supports_installer_settings());
+  out.append(" TestMode:").append_yes_no(supports_test_mode());
+  out.append(" DryTemp:").append_yes_no(supports_dry_temperature());
+
+  out.append(" StatusDisplay:").append_yes_no(has_status_display());
+
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("CoolDrySetpoint:").append_float(get_min_cool_dry_setpoint());
+  out.append('/').append_float(get_max_cool_dry_setpoint());
+  out.append(" HeatSetpoint:").append_float(get_min_heating_setpoint());
+  out.append('/').append_float(get_max_heating_setpoint());
+  out.append(" AutoSetpoint:").append_float(get_min_auto_setpoint());
+  out.append('/').append_float(get_max_auto_setpoint());
+  out.append(" FanSpeeds:").append_uint(get_supported_fan_speeds());
 }
 
 }  // namespace itp_packet
\ No newline at end of file
@@ -5,6 +5,10 @@
 namespace itp_packet {
 class CapabilitiesRequestPacket : public Packet {
  public:
+  // Prebuilt request frame with a compile-time checksum; can be sent without constructing a packet
+  static constexpr std::array<uint8_t, PACKET_HEADER_SIZE + 2> FRAME =
+      RawPacket::make_frame<1>(PacketType::IDENTIFY_REQUEST, {IDENTIFY_COMMAND_CAPABILITIES});
+
   static CapabilitiesRequestPacket &instance() {
     static CapabilitiesRequestPacket instance;
     return instance;
@@ -12,45 +16,93 @@ class CapabilitiesRequestPacket : public Packet {
   using Packet::Packet;
 
  private:
-  CapabilitiesRequestPacket() : Packet(RawPacket(PacketType::IDENTIFY_REQUEST, 1)) { pkt_.set_payload_byte(0, 0xc9); }
+  CapabilitiesRequestPacket() : Packet(RawPacket(FRAME.data(), FRAME.size())) {}
+};
+
+class CapabilitiesResponseView : public RawPacketView {
+ public:
+  using RawPacketView::RawPacketView;
+
+  // Byte 7
+  bool is_heat_disabled() const { return get_payload_byte(7) & 0x02; }
+  bool supports_vane() const { return get_payload_byte(7) & 0x20; }
+  bool supports_vane_swing() const { return get_payload_byte(7) & 0x40; }
+
+  // Byte 8
+  bool is_dry_disabled() const { return get_payload_byte(8) & 0x01; }
+  bool is_fan_disabled() const { return get_payload_byte(8) & 0x02; }
+  bool has_extended_temperature_range() const { return get_payload_byte(8) & 0x04; }
+  bool auto_fan_speed_disabled() const { return get_payload_byte(8) & 0x10; }
+  bool supports_installer_settings() const { return get_payload_byte(8) & 0x20; }
+  bool supports_test_mode() const { return get_payload_byte(8) & 0x40; }
+  bool supports_dry_temperature() const { return get_payload_byte(8) & 0x80; }
+
+  // Byte 9
+  bool has_status_display() const { return get_payload_byte(9) & 0x01; }
+
+  // Bytes 10-15
+  float get_min_cool_dry_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(get_payload_byte(10)); }
+  float get_max_cool_dry_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(get_payload_byte(11)); }
+  float get_min_heating_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(get_payload_byte(12)); }
+  float get_max_heating_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(get_payload_byte(13)); }
+  float get_min_auto_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(get_payload_byte(14)); }
+  float get_max_auto_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(get_payload_byte(15)); }
+  int16_t get_min_cool_dry_setpoint_deci_c() const { return ITPUtils::temp_scale_a_to_deci_c(get_payload_byte(10)); }
+  int16_t get_max_cool_dry_setpoint_deci_c() const { return ITPUtils::temp_scale_a_to_deci_c(get_payload_byte(11)); }
+  int16_t get_min_heating_setpoint_deci_c() const { return ITPUtils::temp_scale_a_to_deci_c(get_payload_byte(12)); }
+  int16_t get_max_heating_setpoint_deci_c() const { return ITPUtils::temp_scale_a_to_deci_c(get_payload_byte(13)); }
+  int16_t get_min_auto_setpoint_deci_c() const { return ITPUtils::temp_scale_a_to_deci_c(get_payload_byte(14)); }
+  int16_t get_max_auto_setpoint_deci_c() const { return ITPUtils::temp_scale_a_to_deci_c(get_payload_byte(15)); }
+
+  // Things that have to exist, but we don't know where yet.
+  bool supports_h_vane() const { return true; }
+
+  uint8_t get_supported_fan_speeds() const;
 };
 
 class CapabilitiesResponsePacket : public Packet {
   using Packet::Packet;
 
  public:
+  CapabilitiesResponseView view() const { return CapabilitiesResponseView(pkt_); }
+
   // Byte 7
-  bool is_heat_disabled() const { return pkt_.get_payload_byte(7) & 0x02; }
-  bool supports_vane() const { return pkt_.get_payload_byte(7) & 0x20; }
-  bool supports_vane_swing() const { return pkt_.get_payload_byte(7) & 0x40; }
+  bool is_heat_disabled() const { return view().is_heat_disabled(); }
+  bool supports_vane() const { return view().supports_vane(); }
+  bool supports_vane_swing() const { return view().supports_vane_swing(); }
 
   // Byte 8
-  bool is_dry_disabled() const { return pkt_.get_payload_byte(8) & 0x01; }
-  bool is_fan_disabled() const { return pkt_.get_payload_byte(8) & 0x02; }
-  bool has_extended_temperature_range() const { return pkt_.get_payload_byte(8) & 0x04; }
-  bool auto_fan_speed_disabled() const { return pkt_.get_payload_byte(8) & 0x10; }
-  bool supports_installer_settings() const { return pkt_.get_payload_byte(8) & 0x20; }
-  bool supports_test_mode() const { return pkt_.get_payload_byte(8) & 0x40; }
-  bool supports_dry_temperature() const { return pkt_.get_payload_byte(8) & 0x80; }
+  bool is_dry_disabled() const { return view().is_dry_disabled(); }
+  bool is_fan_disabled() const { return view().is_fan_disabled(); }
+  bool has_extended_temperature_range() const { return view().has_extended_temperature_range(); }
+  bool auto_fan_speed_disabled() const { return view().auto_fan_speed_disabled(); }
+  bool supports_installer_settings() const { return view().supports_installer_settings(); }
+  bool supports_test_mode() const { return view().supports_test_mode(); }
+  bool supports_dry_temperature() const { return view().supports_dry_temperature(); }
 
   // Byte 9
-  bool has_status_display() const { return pkt_.get_payload_byte(9) & 0x01; }
+  bool has_status_display() const { return view().has_status_display(); }
 
   // Bytes 10-15
-  float get_min_cool_dry_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(pkt_.get_payload_byte(10)); }
-  float get_max_cool_dry_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(pkt_.get_payload_byte(11)); }
-  float get_min_heating_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(pkt_.get_payload_byte(12)); }
-  float get_max_heating_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(pkt_.get_payload_byte(13)); }
-  float get_min_auto_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(pkt_.get_payload_byte(14)); }
-  float get_max_auto_setpoint() const { return ITPUtils::temp_scale_a_to_deg_c(pkt_.get_payload_byte(15)); }
+  float get_min_cool_dry_setpoint() const { return view().get_min_cool_dry_setpoint(); }
+  float get_max_cool_dry_setpoint() const { return view().get_max_cool_dry_setpoint(); }
+  float get_min_heating_setpoint() const { return view().get_min_heating_setpoint(); }
+  float get_max_heating_setpoint() const { return view().get_max_heating_setpoint(); }
+  float get_min_auto_setpoint() const { return view().get_min_auto_setpoint(); }
+  float get_max_auto_setpoint() const { return view().get_max_auto_setpoint(); }
+  int16_t get_min_cool_dry_setpoint_deci_c() const { return view().get_min_cool_dry_setpoint_deci_c(); }
+  int16_t get_max_cool_dry_setpoint_deci_c() const { return view().get_max_cool_dry_setpoint_deci_c(); }
+  int16_t get_min_heating_setpoint_deci_c() const { return view().get_min_heating_setpoint_deci_c(); }
+  int16_t get_max_heating_setpoint_deci_c() const { return view().get_max_heating_setpoint_deci_c(); }
+  int16_t get_min_auto_setpoint_deci_c() const { return view().get_min_auto_setpoint_deci_c(); }
+  int16_t get_max_auto_setpoint_deci_c() const { return view().get_max_auto_setpoint_deci_c(); }
 
   // Things that have to exist, but we don't know where yet.
-  bool supports_h_vane() const { return true; }
+  bool supports_h_vane() const { return view().supports_h_vane(); }
 
-  // Fan Speeds TODO: Probably move this to .cpp?
-  uint8_t get_supported_fan_speeds() const;
+  uint8_t get_supported_fan_speeds() const { return view().get_supported_fan_speeds(); }
 
-  std::string to_string() const override;
+  void format_to(PacketFormatter &out) const override;
 };
 
 }  // namespace itp_packet
\ No newline at end of file
@@ -2,7 +2,16 @@
 
 namespace itp_packet {
 
-std::string ConnectRequestPacket::to_string() const { return ("Connect Request: " + Packet::to_string()); }
-std::string ConnectResponsePacket::to_string() const { return ("Connect Response: " + Packet::to_string()); }
+// Matches the connect request captured from a real adapter
+static_assert(ConnectRequestPacket::FRAME == std::array<uint8_t, 8>{0xfc, 0x5a, 0x01, 0x30, 0x02, 0xca, 0x01, 0xa8});
+
+void ConnectRequestPacket::format_to(PacketFormatter &out) const {
+  out.append("Connect Request: ");
+  Packet::format_to(out);
+}
+void ConnectResponsePacket::format_to(PacketFormatter &out) const {
+  out.append("Connect Response: ");
+  Packet::format_to(out);
+}
 
 }  // namespace itp_packet
\ No newline at end of file
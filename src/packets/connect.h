@@ -6,24 +6,26 @@ namespace itp_packet {
 class ConnectRequestPacket : public Packet {
  public:
   using Packet::Packet;
+
+  // Prebuilt request frame with a compile-time checksum; can be sent without constructing a packet
+  static constexpr std::array<uint8_t, PACKET_HEADER_SIZE + 3> FRAME =
+      RawPacket::make_frame<2>(PacketType::CONNECT_REQUEST, {0xca, 0x01});
+
   static ConnectRequestPacket &instance() {
     static ConnectRequestPacket instance;
     return instance;
   }
 
-  std::string to_string() const override;
+  void format_to(PacketFormatter &out) const override;
 
  private:
-  ConnectRequestPacket() : Packet(RawPacket(PacketType::CONNECT_REQUEST, 2)) {
-    pkt_.set_payload_byte(0, 0xca);
-    pkt_.set_payload_byte(1, 0x01);
-  }
+  ConnectRequestPacket() : Packet(RawPacket(FRAME.data(), FRAME.size())) {}
 };
 
 class ConnectResponsePacket : public Packet {
  public:
   using Packet::Packet;
-  std::string to_string() const override;
+  void format_to(PacketFormatter &out) const override;
 };
 
 }  // namespace itp_packet
\ No newline at end of file
@@ -1,129 +1,193 @@
 #include "get.h"
 
 namespace itp_packet {
-std::string GetRequestPacket::to_string() const {
-  return ("Get Request: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE +
-          "CommandID: " + ITPUtils::format_hex((uint8_t) get_requested_command()));
-}
-std::string CurrentTempGetResponsePacket::to_string() const {
-  return ("Current Temp Response: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE +
-          "Temp:" + std::to_string(get_current_temp()) +
-          " Outdoor:" + (std::isnan(get_outdoor_temp()) ? "Unsupported" : std::to_string(get_outdoor_temp())) +
-          " Runtime Mins: " + std::to_string(get_runtime_minutes()));
-}
-std::string SettingsGetResponsePacket::to_string() const {
-  return ("Settings Response: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE +
-          "Fan:" + ITPUtils::format_hex(get_fan()) + " Mode:" + ITPUtils::format_hex(get_mode()) + " Power:" +
-          (get_power() == 3  ? "Test"
-           : get_power() > 0 ? "On"
-                             : "Off") +
-          " TargetTemp:" + std::to_string(get_target_temp()) + " Vane:" + ITPUtils::format_hex(get_vane()) +
-          " HVane:" + ITPUtils::format_hex(get_horizontal_vane()) + (get_horizontal_vane_msb() ? " (MSB Set)" : "") +
-          "\n " + CONSOLE_COLOR_PURPLE + "PowerLock:" + (locked_power() ? "Yes" : "No") +
-          " ModeLock:" + (locked_mode() ? "Yes" : "No") + " TempLock:" + (locked_temp() ? "Yes" : "No"));
-}
-std::string RunStateGetResponsePacket::to_string() const {
-  return ("RunState Response: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE +
-          "ServiceFilter:" + (service_filter() ? "Yes" : "No") + " Defrost:" + (in_defrost() ? "Yes" : "No") +
-          " Preheat:" + (in_preheat() ? "Yes" : "No") + " Standby:" + (in_standby() ? "Yes" : "No") +
-          " ActualFan:" + ACTUAL_FAN_SPEED_NAMES[get_actual_fan_speed()] + " (" +
-          std::to_string(get_actual_fan_speed()) + ")" + " AutoMode:" + ITPUtils::format_hex(get_auto_mode()));
-}
-std::string StatusGetResponsePacket::to_string() const {
-  return ("Status Response: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE + "Compressor Frequency: " +
-          std::to_string(get_compressor_frequency()) + " Operating: " + (get_operating() ? "Yes" : "No")) +
-         " Input Watts: " + std::to_string(get_input_watts()) + " Lifetime kWh: " + std::to_string(get_lifetime_kwh());
-}
-std::string ErrorStateGetResponsePacket::to_string() const {
-  return ("Error State Response: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE +
-          "Error State: " + (error_present() ? "Yes" : "No") + " ErrorCode: " + ITPUtils::format_hex(get_error_code()) +
-          " ShortCode: " + get_short_code() + "(" + ITPUtils::format_hex(get_raw_short_code()) + ")");
-}
-std::string Functions1GetResponsePacket::to_string() const {
-  std::stringstream funcstream;
-  funcstream << "Functions1 Response: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE + "\n";
-  for (uint8_t i = 1; i < pkt_.get_length() - 6; i++) {
-    uint8_t b = pkt_.get_payload_byte(i);
-    funcstream << std::to_string(((b >> 2) & 0xff) + 100) + ":" + std::to_string(b & 3) + " ";
+void GetRequestPacket::format_to(PacketFormatter &out) const {
+  out.append("Get Request: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("CommandID: ").append_hex((uint8_t) get_requested_command());
+}
+void CurrentTempGetResponsePacket::format_to(PacketFormatter &out) const {
+  out.append("Current Temp Response: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("Temp:").append_float(get_current_temp());
+  out.append(" Outdoor:");
+  if (std::isnan(get_outdoor_temp())) {
+    out.append("Unsupported");
+  } else {
+    out.append_float(get_outdoor_temp());
   }
-  return funcstream.str();
-}
-std::string Functions2GetResponsePacket::to_string() const {
-  std::stringstream funcstream;
-  funcstream << "Functions2 Response: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE + "\n";
-  for (uint8_t i = 1; i < pkt_.get_length() - 6; i++) {
-    uint8_t b = pkt_.get_payload_byte(i);
-    funcstream << std::to_string(((b >> 2) & 0xff) + 100) + ":" + std::to_string(b & 3) + " ";
+  out.append(" Runtime Mins: ").append_uint(get_runtime_minutes());
+}
+void SettingsGetResponsePacket::format_to(PacketFormatter &out) const {
+  out.append("Settings Response: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("Fan:").append_hex(get_fan());
+  out.append(" Mode:").append_hex(get_mode());
+  out.append(" Power:").append(get_power() == 3 ? "Test" : get_power() > 0 ? "On" : "Off");
+  out.append(" TargetTemp:").append_float(get_target_temp());
+  out.append(" Vane:").append_hex(get_vane());
+  out.append(" HVane:").append_hex(get_horizontal_vane());
+  if (get_horizontal_vane_msb())
+    out.append(" (MSB Set)");
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("PowerLock:").append_yes_no(locked_power());
+  out.append(" ModeLock:").append_yes_no(locked_mode());
+  out.append(" TempLock:").append_yes_no(locked_temp());
+}
+void RunStateGetResponsePacket::format_to(PacketFormatter &out) const {
+  out.append("RunState Response: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("ServiceFilter:").append_yes_no(service_filter());
+  out.append(" Defrost:").append_yes_no(in_defrost());
+  out.append(" Preheat:").append_yes_no(in_preheat());
+  out.append(" Standby:").append_yes_no(in_standby());
+  out.append(" ActualFan:").append(ACTUAL_FAN_SPEED_NAMES[get_actual_fan_speed()].c_str());
+  out.append(" (").append_uint(get_actual_fan_speed()).append(')');
+  out.append(" AutoMode:").append_hex(get_auto_mode());
+}
+void StatusGetResponsePacket::format_to(PacketFormatter &out) const {
+  out.append("Status Response: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("Compressor Frequency: ").append_uint(get_compressor_frequency());
+  out.append(" Operating: ").append_yes_no(get_operating());
+  out.append(" Input Watts: ").append_uint(get_input_watts());
+  out.append(" Lifetime kWh: ").append_float(get_lifetime_kwh());
+}
+void ErrorStateGetResponsePacket::format_to(PacketFormatter &out) const {
+  char short_code[SHORT_CODE_BUFFER_SIZE];
+
+  out.append("Error State Response: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("Error State: ").append_yes_no(error_present());
+  out.append(" ErrorCode: ").append_hex(get_error_code());
+  out.append(" ShortCode: ").append(short_code, get_short_code(short_code));
+  out.append('(').append_hex(get_raw_short_code()).append(')');
+}
+// Shared by the Functions1/2 responses; each payload byte packs a function code and its setting
+static void format_functions(const RawPacket &pkt, PacketFormatter &out) {
+  for (uint8_t i = 1; i < pkt.get_length() - 6; i++) {
+    uint8_t b = pkt.get_payload_byte(i);
+    out.append_uint(((b >> 2) & 0xff) + 100).append(':').append_uint(b & 3).append(' ');
   }
-  return funcstream.str();
+}
+void Functions1GetResponsePacket::format_to(PacketFormatter &out) const {
+  out.append("Functions1 Response: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE).append('\n');
+  format_functions(pkt_, out);
+}
+void Functions2GetResponsePacket::format_to(PacketFormatter &out) const {
+  out.append("Functions2 Response: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE).append('\n');
+  format_functions(pkt_, out);
 }
 
-// SettingsGetResponsePacket functions
-float SettingsGetResponsePacket::get_target_temp() const {
-  uint8_t enhanced_raw_temp = pkt_.get_payload_byte(PLINDEX_TARGETTEMP);
+// SettingsGetResponseView functions
+float SettingsGetResponseView::get_target_temp() const {
+  uint8_t enhanced_raw_temp = get_payload_byte(PLINDEX_TARGETTEMP);
 
   if (enhanced_raw_temp == 0x00) {
-    uint8_t legacy_raw_temp = pkt_.get_payload_byte(PLINDEX_TARGETTEMP_LEGACY);
+    uint8_t legacy_raw_temp = get_payload_byte(PLINDEX_TARGETTEMP_LEGACY);
     return ITPUtils::legacy_target_temp_to_deg_c(legacy_raw_temp);
   }
 
   return ITPUtils::temp_scale_a_to_deg_c(enhanced_raw_temp);
 }
 
-bool SettingsGetResponsePacket::is_i_see_enabled() const {
-  uint8_t mode = pkt_.get_payload_byte(PLINDEX_MODE);
+int16_t SettingsGetResponseView::get_target_temp_deci_c() const {
+  uint8_t enhanced_raw_temp = get_payload_byte(PLINDEX_TARGETTEMP);
+
+  if (enhanced_raw_temp == 0x00) {
+    uint8_t legacy_raw_temp = get_payload_byte(PLINDEX_TARGETTEMP_LEGACY);
+    return ITPUtils::legacy_target_temp_to_deci_c(legacy_raw_temp);
+  }
+
+  return ITPUtils::temp_scale_a_to_deci_c(enhanced_raw_temp);
+}
+
+bool SettingsGetResponseView::is_i_see_enabled() const {
+  uint8_t mode = get_payload_byte(PLINDEX_MODE);
 
   // so far only modes 0x09 to 0x11 are known to be i-see.
   // Mode 0x08 technically *can* be, but it's not a guarantee by itself.
   return (mode >= 0x09 && mode <= 0x11);
 }
 
-// CurrentTempGetResponsePacket functions
-float CurrentTempGetResponsePacket::get_current_temp() const {
-  uint8_t enhanced_raw_temp = pkt_.get_payload_byte(PLINDEX_CURRENTTEMP);
+// CurrentTempGetResponseView functions
+float CurrentTempGetResponseView::get_current_temp() const {
+  uint8_t enhanced_raw_temp = get_payload_byte(PLINDEX_CURRENTTEMP);
 
   // TODO: Figure out how to handle "out of range" issues here.
   if (enhanced_raw_temp == 0) {
-    uint8_t legacy_raw_temp = pkt_.get_payload_byte(PLINDEX_CURRENTTEMP_LEGACY);
+    uint8_t legacy_raw_temp = get_payload_byte(PLINDEX_CURRENTTEMP_LEGACY);
     return ITPUtils::legacy_hp_room_temp_to_deg_c(legacy_raw_temp);
   }
 
   return ITPUtils::temp_scale_a_to_deg_c(enhanced_raw_temp);
 }
 
-float CurrentTempGetResponsePacket::get_outdoor_temp() const {
-  uint8_t enhanced_raw_temp = pkt_.get_payload_byte(PLINDEX_OUTDOORTEMP);
+float CurrentTempGetResponseView::get_outdoor_temp() const {
+  uint8_t enhanced_raw_temp = get_payload_byte(PLINDEX_OUTDOORTEMP);
 
   // Byte can sometimes be 0x00 (unsupported?) or 0x01 (supported but not reading); only
   // return value if it's expected to be the actual temperature.
   return enhanced_raw_temp <= 1 ? NAN : ITPUtils::temp_scale_a_to_deg_c(enhanced_raw_temp);
 }
 
-uint32_t CurrentTempGetResponsePacket::get_runtime_minutes() const {
-  return pkt_.get_payload_byte(PLINDEX_RUNTIME) << 16 | pkt_.get_payload_byte(PLINDEX_RUNTIME + 1) << 8 |
-         pkt_.get_payload_byte(PLINDEX_RUNTIME + 2);
+int16_t CurrentTempGetResponseView::get_current_temp_deci_c() const {
+  uint8_t enhanced_raw_temp = get_payload_byte(PLINDEX_CURRENTTEMP);
+
+  if (enhanced_raw_temp == 0) {
+    uint8_t legacy_raw_temp = get_payload_byte(PLINDEX_CURRENTTEMP_LEGACY);
+    return ITPUtils::legacy_hp_room_temp_to_deci_c(legacy_raw_temp);
+  }
+
+  return ITPUtils::temp_scale_a_to_deci_c(enhanced_raw_temp);
+}
+
+int16_t CurrentTempGetResponseView::get_outdoor_temp_deci_c() const {
+  uint8_t enhanced_raw_temp = get_payload_byte(PLINDEX_OUTDOORTEMP);
+  return enhanced_raw_temp <= 1 ? ITPUtils::DECI_C_UNAVAILABLE : ITPUtils::temp_scale_a_to_deci_c(enhanced_raw_temp);
+}
+
+uint32_t CurrentTempGetResponseView::get_runtime_minutes() const {
+  return get_payload_byte(PLINDEX_RUNTIME) << 16 | get_payload_byte(PLINDEX_RUNTIME + 1) << 8 |
+         get_payload_byte(PLINDEX_RUNTIME + 2);
+}
+
+// ErrorStateGetResponseView functions
+std::string ErrorStateGetResponseView::get_short_code() const {
+  char buf[SHORT_CODE_BUFFER_SIZE];
+  size_t length = get_short_code(buf);
+  return std::string(buf, length);
 }
 
-// ErrorStateGetResponsePacket functions
-std::string ErrorStateGetResponsePacket::get_short_code() const {
+size_t ErrorStateGetResponseView::get_short_code(char buffer[SHORT_CODE_BUFFER_SIZE]) const {
   const char *upper_alphabet = "AbEFJLPU";
   const char *lower_alphabet = "0123456789ABCDEFOHJLPU";
   const uint8_t error_code = this->get_raw_short_code();
 
   uint8_t low_bits = error_code & 0x1F;
   if (low_bits > 0x15) {
-    char buf[7];
-    sprintf(buf, "ERR_%x", error_code);
-    return buf;
+    return sprintf(buffer, "ERR_%x", error_code);
   }
 
-  return {upper_alphabet[(error_code & 0xE0) >> 5], lower_alphabet[low_bits]};
+  buffer[0] = upper_alphabet[(error_code & 0xE0) >> 5];
+  buffer[1] = lower_alphabet[low_bits];
+  buffer[2] = '\0';
+  return 2;
 }
 
-// StatusGetResponsePacket functions
-float StatusGetResponsePacket::get_lifetime_kwh() const {
-  uint16_t raw_value =
-      pkt_.get_payload_byte(PLINDEX_LIFETIME_KWH) << 8 | pkt_.get_payload_byte(PLINDEX_LIFETIME_KWH + 1);
+// StatusGetResponseView functions
+float StatusGetResponseView::get_lifetime_kwh() const {
+  uint16_t raw_value = get_payload_byte(PLINDEX_LIFETIME_KWH) << 8 | get_payload_byte(PLINDEX_LIFETIME_KWH + 1);
   return (raw_value / 10.0f);
 }
 }  // namespace itp_packet
\ No newline at end of file
@@ -6,47 +6,65 @@ namespace itp_packet {
 
 class GetRequestPacket : public Packet {
  public:
+  using Frame = std::array<uint8_t, PACKET_HEADER_SIZE + 2>;
+
+  // Prebuilt request frames with compile-time checksums.  These are immutable and live in read-only storage, so they
+  // can be sent without constructing (or sharing) a packet object.
+  static constexpr Frame SETTINGS_FRAME =
+      RawPacket::make_frame<1>(PacketType::GET_REQUEST, {static_cast<uint8_t>(GetCommand::SETTINGS)});
+  static constexpr Frame CURRENT_TEMP_FRAME =
+      RawPacket::make_frame<1>(PacketType::GET_REQUEST, {static_cast<uint8_t>(GetCommand::CURRENT_TEMP)});
+  static constexpr Frame STATUS_FRAME =
+      RawPacket::make_frame<1>(PacketType::GET_REQUEST, {static_cast<uint8_t>(GetCommand::STATUS)});
+  static constexpr Frame RUNSTATE_FRAME =
+      RawPacket::make_frame<1>(PacketType::GET_REQUEST, {static_cast<uint8_t>(GetCommand::RUN_STATE)});
+  static constexpr Frame ERROR_INFO_FRAME =
+      RawPacket::make_frame<1>(PacketType::GET_REQUEST, {static_cast<uint8_t>(GetCommand::ERROR_INFO)});
+  static constexpr Frame FUNCTIONS_1_FRAME =
+      RawPacket::make_frame<1>(PacketType::GET_REQUEST, {static_cast<uint8_t>(GetCommand::FUNCTIONS_1)});
+  static constexpr Frame FUNCTIONS_2_FRAME =
+      RawPacket::make_frame<1>(PacketType::GET_REQUEST, {static_cast<uint8_t>(GetCommand::FUNCTIONS_2)});
+
   static GetRequestPacket &get_settings_instance() {
-    static GetRequestPacket instance = GetRequestPacket(GetCommand::SETTINGS);
+    static GetRequestPacket instance = GetRequestPacket(SETTINGS_FRAME);
     return instance;
   }
   static GetRequestPacket &get_current_temp_instance() {
-    static GetRequestPacket instance = GetRequestPacket(GetCommand::CURRENT_TEMP);
+    static GetRequestPacket instance = GetRequestPacket(CURRENT_TEMP_FRAME);
     return instance;
   }
   static GetRequestPacket &get_status_instance() {
-    static GetRequestPacket instance = GetRequestPacket(GetCommand::STATUS);
+    static GetRequestPacket instance = GetRequestPacket(STATUS_FRAME);
     return instance;
   }
   static GetRequestPacket &get_runstate_instance() {
-    static GetRequestPacket instance = GetRequestPacket(GetCommand::RUN_STATE);
+    static GetRequestPacket instance = GetRequestPacket(RUNSTATE_FRAME);
     return instance;
   }
   static GetRequestPacket &get_error_info_instance() {
-    static GetRequestPacket instance = GetRequestPacket(GetCommand::ERROR_INFO);
+    static GetRequestPacket instance = GetRequestPacket(ERROR_INFO_FRAME);
     return instance;
   }
   static GetRequestPacket &get_functions_1_instance() {
-    static GetRequestPacket instance = GetRequestPacket(GetCommand::FUNCTIONS_1);
+    static GetRequestPacket instance = GetRequestPacket(FUNCTIONS_1_FRAME);
     return instance;
   }
   static GetRequestPacket &get_functions_2_instance() {
-    static GetRequestPacket instance = GetRequestPacket(GetCommand::FUNCTIONS_2);
+    static GetRequestPacket instance = GetRequestPacket(FUNCTIONS_2_FRAME);
     return instance;
   }
   using Packet::Packet;
 
   GetCommand get_requested_command() const { return (GetCommand) pkt_.get_payload_byte(0); }
 
-  std::string to_string() const override;
+  void format_to(PacketFormatter &out) const override;
 
  private:
-  GetRequestPacket(GetCommand get_command) : Packet(RawPacket(PacketType::GET_REQUEST, 1)) {
-    pkt_.set_payload_byte(0, static_cast<uint8_t>(get_command));
-  }
+  GetRequestPacket(const Frame &frame) : Packet(RawPacket(frame.data(), frame.size())) {}
 };
 
-class SettingsGetResponsePacket : public Packet {
+class SettingsGetResponseView : public RawPacketView {
+ public:
   static const int PLINDEX_POWER = 3;
   static const int PLINDEX_MODE = 4;
   static const int PLINDEX_TARGETTEMP_LEGACY = 5;
@@ -55,100 +73,195 @@ class SettingsGetResponsePacket : public Packet {
   static const int PLINDEX_PROHIBITFLAGS = 8;
   static const int PLINDEX_HVANE = 10;
   static const int PLINDEX_TARGETTEMP = 11;
-  using Packet::Packet;
 
- public:
-  uint8_t get_power() const { return pkt_.get_payload_byte(PLINDEX_POWER); }
-  uint8_t get_mode() const { return pkt_.get_payload_byte(PLINDEX_MODE); }
-  const uint8_t get_fan() const { return pkt_.get_payload_byte(PLINDEX_FAN); }
-  uint8_t get_vane() const { return pkt_.get_payload_byte(PLINDEX_VANE); }
-  bool locked_power() const { return pkt_.get_payload_byte(PLINDEX_PROHIBITFLAGS) & 0x01; }
-  bool locked_mode() const { return pkt_.get_payload_byte(PLINDEX_PROHIBITFLAGS) & 0x02; }
-  bool locked_temp() const { return pkt_.get_payload_byte(PLINDEX_PROHIBITFLAGS) & 0x04; }
-  uint8_t get_horizontal_vane() const { return pkt_.get_payload_byte(PLINDEX_HVANE) & 0x7F; }
-  bool get_horizontal_vane_msb() const { return pkt_.get_payload_byte(PLINDEX_HVANE) & 0x80; }
+  using RawPacketView::RawPacketView;
+
+  uint8_t get_power() const { return get_payload_byte(PLINDEX_POWER); }
+  uint8_t get_mode() const { return get_payload_byte(PLINDEX_MODE); }
+  uint8_t get_fan() const { return get_payload_byte(PLINDEX_FAN); }
+  uint8_t get_vane() const { return get_payload_byte(PLINDEX_VANE); }
+  bool locked_power() const { return get_payload_byte(PLINDEX_PROHIBITFLAGS) & 0x01; }
+  bool locked_mode() const { return get_payload_byte(PLINDEX_PROHIBITFLAGS) & 0x02; }
+  bool locked_temp() const { return get_payload_byte(PLINDEX_PROHIBITFLAGS) & 0x04; }
+  uint8_t get_horizontal_vane() const { return get_payload_byte(PLINDEX_HVANE) & 0x7F; }
+  bool get_horizontal_vane_msb() const { return get_payload_byte(PLINDEX_HVANE) & 0x80; }
 
   float get_target_temp() const;
+  int16_t get_target_temp_deci_c() const;
 
   bool is_i_see_enabled() const;
+};
+
+class SettingsGetResponsePacket : public Packet {
+  using Packet::Packet;
+
+ public:
+  SettingsGetResponseView view() const { return SettingsGetResponseView(pkt_); }
+
+  uint8_t get_power() const { return view().get_power(); }
+  uint8_t get_mode() const { return view().get_mode(); }
+  const uint8_t get_fan() const { return view().get_fan(); }
+  uint8_t get_vane() const { return view().get_vane(); }
+  bool locked_power() const { return view().locked_power(); }
+  bool locked_mode() const { return view().locked_mode(); }
+  bool locked_temp() const { return view().locked_temp(); }
+  uint8_t get_horizontal_vane() const { return view().get_horizontal_vane(); }
+  bool get_horizontal_vane_msb() const { return view().get_horizontal_vane_msb(); }
+
+  float get_target_temp() const { return view().get_target_temp(); }
+  int16_t get_target_temp_deci_c() const { return view().get_target_temp_deci_c(); }
 
-  std::string to_string() const override;
+  bool is_i_see_enabled() const { return view().is_i_see_enabled(); }
+
+  void format_to(PacketFormatter &out) const override;
 };
 
-class CurrentTempGetResponsePacket : public Packet {
+class CurrentTempGetResponseView : public RawPacketView {
+ public:
   static const int PLINDEX_CURRENTTEMP_LEGACY = 3;
   static const int PLINDEX_OUTDOORTEMP = 5;
   static const int PLINDEX_CURRENTTEMP = 6;
   static const int PLINDEX_RUNTIME = 11;  // to 13.
-  using Packet::Packet;
 
- public:
+  using RawPacketView::RawPacketView;
+
   float get_current_temp() const;
+  int16_t get_current_temp_deci_c() const;
   // Returns outdoor temperature or NAN if unsupported
   float get_outdoor_temp() const;
+  // Returns outdoor temperature or ITPUtils::DECI_C_UNAVAILABLE if unsupported
+  int16_t get_outdoor_temp_deci_c() const;
   // Returns lifetime runtime minutes of unit
   uint32_t get_runtime_minutes() const;
-  std::string to_string() const override;
 };
 
-class StatusGetResponsePacket : public Packet {
+class CurrentTempGetResponsePacket : public Packet {
+  using Packet::Packet;
+
+ public:
+  CurrentTempGetResponseView view() const { return CurrentTempGetResponseView(pkt_); }
+
+  float get_current_temp() const { return view().get_current_temp(); }
+  int16_t get_current_temp_deci_c() const { return view().get_current_temp_deci_c(); }
+  // Returns outdoor temperature or NAN if unsupported
+  float get_outdoor_temp() const { return view().get_outdoor_temp(); }
+  // Returns outdoor temperature or ITPUtils::DECI_C_UNAVAILABLE if unsupported
+  int16_t get_outdoor_temp_deci_c() const { return view().get_outdoor_temp_deci_c(); }
+  // Returns lifetime runtime minutes of unit
+  uint32_t get_runtime_minutes() const { return view().get_runtime_minutes(); }
+  void format_to(PacketFormatter &out) const override;
+};
+
+class StatusGetResponseView : public RawPacketView {
+ public:
   static const int PLINDEX_COMPRESSOR_FREQUENCY = 3;
   static const int PLINDEX_OPERATING = 4;
   static const int PLINDEX_INPUT_WATTS = 5;   // and 6
   static const int PLINDEX_LIFETIME_KWH = 7;  // and 8
 
-  using Packet::Packet;
+  using RawPacketView::RawPacketView;
 
- public:
-  uint8_t get_compressor_frequency() const { return pkt_.get_payload_byte(PLINDEX_COMPRESSOR_FREQUENCY); }
-  bool get_operating() const { return pkt_.get_payload_byte(PLINDEX_OPERATING); }
+  uint8_t get_compressor_frequency() const { return get_payload_byte(PLINDEX_COMPRESSOR_FREQUENCY); }
+  bool get_operating() const { return get_payload_byte(PLINDEX_OPERATING); }
   uint16_t get_input_watts() const {
-    return pkt_.get_payload_byte(PLINDEX_INPUT_WATTS) << 8 | pkt_.get_payload_byte(PLINDEX_INPUT_WATTS + 1);
+    return get_payload_byte(PLINDEX_INPUT_WATTS) << 8 | get_payload_byte(PLINDEX_INPUT_WATTS + 1);
   }
   float get_lifetime_kwh() const;
-  std::string to_string() const override;
 };
 
-class RunStateGetResponsePacket : public Packet {
+class StatusGetResponsePacket : public Packet {
+  using Packet::Packet;
+
+ public:
+  StatusGetResponseView view() const { return StatusGetResponseView(pkt_); }
+
+  uint8_t get_compressor_frequency() const { return view().get_compressor_frequency(); }
+  bool get_operating() const { return view().get_operating(); }
+  uint16_t get_input_watts() const { return view().get_input_watts(); }
+  float get_lifetime_kwh() const { return view().get_lifetime_kwh(); }
+  void format_to(PacketFormatter &out) const override;
+};
+
+class RunStateGetResponseView : public RawPacketView {
+ public:
   static const int PLINDEX_STATUSFLAGS = 3;
   static const int PLINDEX_ACTUALFAN = 4;
   static const int PLINDEX_AUTOMODE = 5;
+
+  using RawPacketView::RawPacketView;
+
+  bool service_filter() const { return get_payload_byte(PLINDEX_STATUSFLAGS) & 0x01; }
+  bool in_defrost() const { return get_payload_byte(PLINDEX_STATUSFLAGS) & 0x02; }
+  bool in_preheat() const { return get_payload_byte(PLINDEX_STATUSFLAGS) & 0x04; }
+  bool in_standby() const { return get_payload_byte(PLINDEX_STATUSFLAGS) & 0x08; }
+  uint8_t get_actual_fan_speed() const { return get_payload_byte(PLINDEX_ACTUALFAN); }
+  uint8_t get_auto_mode() const { return get_payload_byte(PLINDEX_AUTOMODE); }
+};
+
+class RunStateGetResponsePacket : public Packet {
   using Packet::Packet;
 
  public:
-  bool service_filter() const { return pkt_.get_payload_byte(PLINDEX_STATUSFLAGS) & 0x01; }
-  bool in_defrost() const { return pkt_.get_payload_byte(PLINDEX_STATUSFLAGS) & 0x02; }
-  bool in_preheat() const { return pkt_.get_payload_byte(PLINDEX_STATUSFLAGS) & 0x04; }
-  bool in_standby() const { return pkt_.get_payload_byte(PLINDEX_STATUSFLAGS) & 0x08; }
-  uint8_t get_actual_fan_speed() const { return pkt_.get_payload_byte(PLINDEX_ACTUALFAN); }
-  uint8_t get_auto_mode() const { return pkt_.get_payload_byte(PLINDEX_AUTOMODE); }
-  std::string to_string() const override;
+  RunStateGetResponseView view() const { return RunStateGetResponseView(pkt_); }
+
+  bool service_filter() const { return view().service_filter(); }
+  bool in_defrost() const { return view().in_defrost(); }
+  bool in_preheat() const { return view().in_preheat(); }
+  bool in_standby() const { return view().in_standby(); }
+  uint8_t get_actual_fan_speed() const { return view().get_actual_fan_speed(); }
+  uint8_t get_auto_mode() const { return view().get_auto_mode(); }
+  void format_to(PacketFormatter &out) const override;
+};
+
+class ErrorStateGetResponseView : public RawPacketView {
+ public:
+  static const int PLINDEX_ERROR_CODE = 4;  // and 5
+  static const int PLINDEX_SHORT_CODE = 6;
+  static const size_t SHORT_CODE_BUFFER_SIZE = 7;
+
+  using RawPacketView::RawPacketView;
+
+  uint16_t get_error_code() const {
+    return get_payload_byte(PLINDEX_ERROR_CODE) << 8 | get_payload_byte(PLINDEX_ERROR_CODE + 1);
+  }
+  uint8_t get_raw_short_code() const { return get_payload_byte(PLINDEX_SHORT_CODE); }
+  std::string get_short_code() const;
+  // Writes the short code into buffer without allocating, returning its length
+  size_t get_short_code(char buffer[SHORT_CODE_BUFFER_SIZE]) const;
+
+  bool error_present() const { return get_error_code() != 0x8000 || get_raw_short_code() != 0x00; }
 };
 
 class ErrorStateGetResponsePacket : public Packet {
   using Packet::Packet;
 
  public:
-  uint16_t get_error_code() const { return pkt_.get_payload_byte(4) << 8 | pkt_.get_payload_byte(5); }
-  uint8_t get_raw_short_code() const { return pkt_.get_payload_byte(6); }
-  std::string get_short_code() const;
+  static const size_t SHORT_CODE_BUFFER_SIZE = ErrorStateGetResponseView::SHORT_CODE_BUFFER_SIZE;
 
-  bool error_present() const { return get_error_code() != 0x8000 || get_raw_short_code() != 0x00; }
+  ErrorStateGetResponseView view() const { return ErrorStateGetResponseView(pkt_); }
+
+  uint16_t get_error_code() const { return view().get_error_code(); }
+  uint8_t get_raw_short_code() const { return view().get_raw_short_code(); }
+  std::string get_short_code() const { return view().get_short_code(); }
+  // Writes the short code into buffer without allocating, returning its length
+  size_t get_short_code(char buffer[SHORT_CODE_BUFFER_SIZE]) const { return view().get_short_code(buffer); }
+
+  bool error_present() const { return view().error_present(); }
 
-  std::string to_string() const override;
+  void format_to(PacketFormatter &out) const override;
 };
 
 class Functions1GetResponsePacket : public Packet {
   using Packet::Packet;
 
  public:
-  std::string to_string() const override;
+  void format_to(PacketFormatter &out) const override;
 };
 
 class Functions2GetResponsePacket : public Packet {
   using Packet::Packet;
 
  public:
-  std::string to_string() const override;
+  void format_to(PacketFormatter &out) const override;
 };
 }  // namespace itp_packet
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "identify.h"
 
 namespace itp_packet {
-std::string IdentifyCDResponsePacket::to_string() const { return "Identify CD Response: " + Packet::to_string(); }
+void IdentifyCDResponsePacket::format_to(PacketFormatter &out) const {
+  out.append("Identify CD Response: ");
+  Packet::format_to(out);
+}
 }  // namespace itp_packet
\ No newline at end of file
@@ -5,6 +5,10 @@
 namespace itp_packet {
 class IdentifyCDRequestPacket : public Packet {
  public:
+  // Prebuilt request frame with a compile-time checksum; can be sent without constructing a packet
+  static constexpr std::array<uint8_t, PACKET_HEADER_SIZE + 2> FRAME =
+      RawPacket::make_frame<1>(PacketType::IDENTIFY_REQUEST, {IDENTIFY_COMMAND_CD});
+
   static IdentifyCDRequestPacket &instance() {
     static IdentifyCDRequestPacket instance;
     return instance;
@@ -12,13 +16,13 @@ class IdentifyCDRequestPacket : public Packet {
   using Packet::Packet;
 
  private:
-  IdentifyCDRequestPacket() : Packet(RawPacket(PacketType::IDENTIFY_REQUEST, 1)) { pkt_.set_payload_byte(0, 0xCD); }
+  IdentifyCDRequestPacket() : Packet(RawPacket(FRAME.data(), FRAME.size())) {}
 };
 
 class IdentifyCDResponsePacket : public Packet {
   using Packet::Packet;
 
  public:
-  std::string to_string() const override;
+  void format_to(PacketFormatter &out) const override;
 };
 }  // namespace itp_packet
\ No newline at end of file
@@ -1,32 +1,37 @@
 #include "set.h"
 
 namespace itp_packet {
-std::string RemoteTemperatureSetRequestPacket::to_string() const {
-  return ("Remote Temp Set Request: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE +
-          "Temp:" + std::to_string(get_remote_temperature()));
+void RemoteTemperatureSetRequestPacket::format_to(PacketFormatter &out) const {
+  out.append("Remote Temp Set Request: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("Temp:").append_float(get_remote_temperature());
 }
-std::string SettingsSetRequestPacket::to_string() const {
+void SettingsSetRequestPacket::format_to(PacketFormatter &out) const {
   uint8_t flags = get_flags();
   uint8_t flags2 = get_flags_2();
 
-  std::string result = "Settings Set Request: " + Packet::to_string() + "\n " + CONSOLE_COLOR_PURPLE +
-                       "Flags: " + ITPUtils::format_hex(flags2) + ITPUtils::format_hex(flags) + " =>";
+  out.append("Settings Set Request: ");
+  Packet::format_to(out);
+  out.append("\n ").append_color(CONSOLE_COLOR_PURPLE);
+  out.append("Flags: ").append_hex(flags2).append_hex(flags).append(" =>");
 
   if (flags & SettingFlag::SF_POWER)
-    result += " Power: " + std::to_string(get_power());
+    out.append(" Power: ").append_uint(get_power());
   if (flags & SettingFlag::SF_MODE)
-    result += " Mode: " + std::to_string(get_mode());
+    out.append(" Mode: ").append_uint(get_mode());
   if (flags & SettingFlag::SF_TARGET_TEMPERATURE)
-    result += " TargetTemp: " + std::to_string(get_target_temp());
+    out.append(" TargetTemp: ").append_float(get_target_temp());
   if (flags & SettingFlag::SF_FAN)
-    result += " Fan: " + std::to_string(get_fan());
+    out.append(" Fan: ").append_uint(get_fan());
   if (flags & SettingFlag::SF_VANE)
-    result += " Vane: " + std::to_string(get_vane());
+    out.append(" Vane: ").append_uint(get_vane());
 
-  if (flags2 & SettingFlag2::SF2_HORIZONTAL_VANE)
-    result += " HVane: " + std::to_string(get_horizontal_vane()) + (get_horizontal_vane_msb() ? " (MSB Set)" : "");
-
-  return result;
+  if (flags2 & SettingFlag2::SF2_HORIZONTAL_VANE) {
+    out.append(" HVane: ").append_uint(get_horizontal_vane());
+    if (get_horizontal_vane_msb())
+      out.append(" (MSB Set)");
+  }
 }
 
 void SettingsSetRequestPacket::add_settings_flag_(const SettingFlag flag_to_add) { add_flag(flag_to_add); }
@@ -68,6 +73,16 @@ SettingsSetRequestPacket &SettingsSetRequestPacket::set_target_temperature(const
 
   return *this;
 }
+SettingsSetRequestPacket &SettingsSetRequestPacket::set_target_temperature_deci_c(const int16_t temperature_deci_c) {
+  if (temperature_deci_c < 635 && temperature_deci_c > -640) {
+    pkt_.set_payload_byte(PLINDEX_TARGET_TEMPERATURE, ITPUtils::deci_c_to_temp_scale_a(temperature_deci_c));
+    pkt_.set_payload_byte(PLINDEX_TARGET_TEMPERATURE_CODE, ITPUtils::deci_c_to_legacy_target_temp(temperature_deci_c));
+    add_settings_flag_(SF_TARGET_TEMPERATURE);
+  }
+
+  return *this;
+}
+
 SettingsSetRequestPacket &SettingsSetRequestPacket::set_fan(const FanByte fan) {
   pkt_.set_payload_byte(PLINDEX_FAN, fan);
   add_settings_flag_(SF_FAN);
@@ -86,6 +101,31 @@ SettingsSetRequestPacket &SettingsSetRequestPacket::set_horizontal_vane(const Ho
   return *this;
 }
 
+SettingsSetRequestPacket &SettingsSetRequestPacket::merge(const SettingsSetRequestPacket &newer) {
+  const uint8_t flags = newer.get_flags();
+  const uint8_t flags2 = newer.get_flags_2();
+
+  if (flags & SF_POWER)
+    pkt_.set_payload_byte(PLINDEX_POWER, newer.pkt_.get_payload_byte(PLINDEX_POWER));
+  if (flags & SF_MODE)
+    pkt_.set_payload_byte(PLINDEX_MODE, newer.pkt_.get_payload_byte(PLINDEX_MODE));
+  if (flags & SF_TARGET_TEMPERATURE) {
+    pkt_.set_payload_byte(PLINDEX_TARGET_TEMPERATURE, newer.pkt_.get_payload_byte(PLINDEX_TARGET_TEMPERATURE));
+    pkt_.set_payload_byte(PLINDEX_TARGET_TEMPERATURE_CODE,
+                          newer.pkt_.get_payload_byte(PLINDEX_TARGET_TEMPERATURE_CODE));
+  }
+  if (flags & SF_FAN)
+    pkt_.set_payload_byte(PLINDEX_FAN, newer.pkt_.get_payload_byte(PLINDEX_FAN));
+  if (flags & SF_VANE)
+    pkt_.set_payload_byte(PLINDEX_VANE, newer.pkt_.get_payload_byte(PLINDEX_VANE));
+  if (flags2 & SF2_HORIZONTAL_VANE)
+    pkt_.set_payload_byte(PLINDEX_HORIZONTAL_VANE, newer.pkt_.get_payload_byte(PLINDEX_HORIZONTAL_VANE));
+
+  add_flag(flags);
+  add_flag2(flags2);
+  return *this;
+}
+
 float SettingsSetRequestPacket::get_target_temp() const {
   uint8_t enhanced_raw_temp = pkt_.get_payload_byte(PLINDEX_TARGET_TEMPERATURE);
 
@@ -97,6 +137,17 @@ float SettingsSetRequestPacket::get_target_temp() const {
   return ITPUtils::temp_scale_a_to_deg_c(enhanced_raw_temp);
 }
 
+int16_t SettingsSetRequestPacket::get_target_temp_deci_c() const {
+  uint8_t enhanced_raw_temp = pkt_.get_payload_byte(PLINDEX_TARGET_TEMPERATURE);
+
+  if (enhanced_raw_temp == 0x00) {
+    uint8_t legacy_raw_temp = pkt_.get_payload_byte(PLINDEX_TARGET_TEMPERATURE_CODE);
+    return ITPUtils::legacy_target_temp_to_deci_c(legacy_raw_temp);
+  }
+
+  return ITPUtils::temp_scale_a_to_deci_c(enhanced_raw_temp);
+}
+
 // RemoteTemperatureSetRequestPacket functions
 
 float RemoteTemperatureSetRequestPacket::get_remote_temperature() const {
@@ -123,6 +174,28 @@ RemoteTemperatureSetRequestPacket &RemoteTemperatureSetRequestPacket::set_remote
   return *this;
 }
 
+int16_t RemoteTemperatureSetRequestPacket::get_remote_temperature_deci_c() const {
+  uint8_t raw_temp_a = pkt_.get_payload_byte(PLINDEX_REMOTE_TEMPERATURE);
+
+  if (raw_temp_a == 0) {
+    uint8_t raw_temp_legacy = pkt_.get_payload_byte(PLINDEX_LEGACY_REMOTE_TEMPERATURE);
+    return ITPUtils::legacy_ts_room_temp_to_deci_c(raw_temp_legacy);
+  }
+
+  return ITPUtils::temp_scale_a_to_deci_c(raw_temp_a);
+}
+
+RemoteTemperatureSetRequestPacket &RemoteTemperatureSetRequestPacket::set_remote_temperature_deci_c(
+    int16_t temperature_deci_c) {
+  if (temperature_deci_c < 635 && temperature_deci_c > -640) {
+    pkt_.set_payload_byte(PLINDEX_REMOTE_TEMPERATURE, ITPUtils::deci_c_to_temp_scale_a(temperature_deci_c));
+    pkt_.set_payload_byte(PLINDEX_LEGACY_REMOTE_TEMPERATURE,
+                          ITPUtils::deci_c_to_legacy_ts_room_temp(temperature_deci_c));
+    set_flags(0x01);  // Set flags to say we're providing the temperature
+  }
+  return *this;
+}
+
 bool RemoteTemperatureSetRequestPacket::get_use_internal_temperature() const { return 0x00 == get_flags() & 0x01; }
 
 RemoteTemperatureSetRequestPacket &RemoteTemperatureSetRequestPacket::set_use_internal_temperature(bool use_internal) {
@@ -4,6 +4,7 @@
 
 namespace itp_packet {
 class SettingsSetRequestPacket : public Packet {
+ public:
   static const int PLINDEX_POWER = 3;
   static const int PLINDEX_MODE = 4;
   static const int PLINDEX_TARGET_TEMPERATURE_CODE = 5;
@@ -24,7 +25,6 @@ class SettingsSetRequestPacket : public Packet {
     SF2_HORIZONTAL_VANE = 0x01,
   };
 
- public:
   enum ModeByte : uint8_t {
     MODE_BYTE_HEAT = 0x01,
     MODE_BYTE_DRY = 0x02,
@@ -78,15 +78,23 @@ class SettingsSetRequestPacket : public Packet {
   bool get_horizontal_vane_msb() const { return pkt_.get_payload_byte(PLINDEX_HORIZONTAL_VANE) & 0x80; }
 
   float get_target_temp() const;
+  int16_t get_target_temp_deci_c() const;
 
   SettingsSetRequestPacket &set_power(bool is_on);
   SettingsSetRequestPacket &set_mode(ModeByte mode);
   SettingsSetRequestPacket &set_target_temperature(float temperature_degrees_c);
+  SettingsSetRequestPacket &set_target_temperature_deci_c(int16_t temperature_deci_c);
   SettingsSetRequestPacket &set_fan(FanByte fan);
   SettingsSetRequestPacket &set_vane(VaneByte vane);
   SettingsSetRequestPacket &set_horizontal_vane(HorizontalVaneByte horizontal_vane);
 
-  std::string to_string() const override;
+  // Copies every setting flagged in newer into this packet (overwriting any value already set here), so that
+  // several changes can be sent as one request
+  SettingsSetRequestPacket &merge(const SettingsSetRequestPacket &newer);
+  // True if no setting has been flagged
+  bool is_empty() const { return get_flags() == 0 && get_flags_2() == 0; }
+
+  void format_to(PacketFormatter &out) const override;
 
  private:
   void add_settings_flag_(SettingFlag flag_to_add);
@@ -94,22 +102,32 @@ class SettingsSetRequestPacket : public Packet {
 };
 
 class RemoteTemperatureSetRequestPacket : public Packet {
+ public:
   static const uint8_t PLINDEX_LEGACY_REMOTE_TEMPERATURE = 2;
   static const uint8_t PLINDEX_REMOTE_TEMPERATURE = 3;
 
- public:
   RemoteTemperatureSetRequestPacket() : Packet(RawPacket(PacketType::SET_REQUEST, 4)) {
     pkt_.set_payload_byte(0, static_cast<uint8_t>(SetCommand::REMOTE_TEMPERATURE));
   }
   using Packet::Packet;
 
   float get_remote_temperature() const;
+  int16_t get_remote_temperature_deci_c() const;
   RemoteTemperatureSetRequestPacket &set_remote_temperature(float temperature_degrees_c);
+  RemoteTemperatureSetRequestPacket &set_remote_temperature_deci_c(int16_t temperature_deci_c);
 
   bool get_use_internal_temperature() const;
   RemoteTemperatureSetRequestPacket &set_use_internal_temperature(bool use_internal = true);
 
-  std::string to_string() const override;
+  void format_to(PacketFormatter &out) const override;
+};
+
+class SetResponseView : public RawPacketView {
+ public:
+  using RawPacketView::RawPacketView;
+
+  uint8_t get_result_code() const { return get_payload_byte(0); }
+  bool is_successful() const { return get_result_code() == 0; }
 };
 
 class SetResponsePacket : public Packet {
@@ -118,8 +136,10 @@ class SetResponsePacket : public Packet {
  public:
   SetResponsePacket() : Packet(RawPacket(PacketType::SET_RESPONSE, 16)) {}
 
-  uint8_t get_result_code() const { return pkt_.get_payload_byte(0); }
-  bool is_successful() const { return get_result_code() == 0; }
+  SetResponseView view() const { return SetResponseView(pkt_); }
+
+  uint8_t get_result_code() const { return view().get_result_code(); }
+  bool is_successful() const { return view().is_successful(); }
 };
 
 class SetRunStatePacket : public Packet {
@@ -1,56 +1,127 @@
 #include "thermostat.h"
 
 namespace itp_packet {
-std::string ThermostatSensorStatusPacket::to_string() const {
-  return ("Thermostat Sensor Status: " + Packet::to_string() + CONSOLE_COLOR_PURPLE +
-          "\n Indoor RH: " + std::to_string(get_indoor_humidity_percent()) + "%" +
-          "  MHK Battery: " + THERMOSTAT_BATTERY_STATE_NAMES[get_thermostat_battery_state()] + "(" +
-          std::to_string(get_thermostat_battery_state()) + ")" +
-          "  Sensor Flags: " + std::to_string(get_sensor_flags()));
+void ThermostatSensorStatusPacket::format_to(PacketFormatter &out) const {
+  out.append("Thermostat Sensor Status: ");
+  Packet::format_to(out);
+  out.append_color(CONSOLE_COLOR_PURPLE);
+  out.append("\n Indoor RH: ").append_uint(get_indoor_humidity_percent()).append('%');
+  out.append("  MHK Battery: ").append(THERMOSTAT_BATTERY_STATE_NAMES[get_thermostat_battery_state()].c_str());
+  out.append('(').append_uint(get_thermostat_battery_state()).append(')');
+  out.append("  Sensor Flags: ").append_uint(get_sensor_flags());
 }
 
-std::string ThermostatHelloPacket::to_string() const {
-  return ("Thermostat Hello: " + Packet::to_string() + CONSOLE_COLOR_PURPLE + "\n Model: " + get_thermostat_model() +
-          " Serial: " + get_thermostat_serial() + " Version: " + get_thermostat_version_string());
+void ThermostatHelloPacket::format_to(PacketFormatter &out) const {
+  char model[MODEL_BUFFER_SIZE];
+  char serial[SERIAL_BUFFER_SIZE];
+  char version[VERSION_STRING_BUFFER_SIZE];
+
+  out.append("Thermostat Hello: ");
+  Packet::format_to(out);
+  out.append_color(CONSOLE_COLOR_PURPLE);
+  out.append("\n Model: ").append(model, get_thermostat_model(model));
+  out.append(" Serial: ").append(serial, get_thermostat_serial(serial));
+  out.append(" Version: ").append(version, get_thermostat_version_string(version));
 }
 
-std::string ThermostatStateUploadPacket::to_string() const {
+void ThermostatStateUploadPacket::format_to(PacketFormatter &out) const {
   uint8_t flags = get_flags();
 
-  std::string result = "Thermostat Sync " + Packet::to_string() + CONSOLE_COLOR_PURPLE +
-                       "\n Flags: " + ITPUtils::format_hex(flags) + " =>";
+  out.append("Thermostat Sync ");
+  Packet::format_to(out);
+  out.append_color(CONSOLE_COLOR_PURPLE);
+  out.append("\n Flags: ").append_hex(flags).append(" =>");
 
   if (flags & TSSF_TIMESTAMP) {
     struct tm ts_timestamp = get_thermostat_timestamp();
     char ts_chars[32];  // Buffer to store the formatted string
     strftime(ts_chars, sizeof(ts_chars), "%Y-%m-%d %H:%M:%S", &ts_timestamp);
 
-    result += " TS Time: " + (std::string) ts_chars;
+    out.append(" TS Time: ").append(ts_chars);
   }
 
   if (flags & TSSF_AUTO_MODE)
-    result += " AutoMode: " + std::to_string(get_auto_mode());
+    out.append(" AutoMode: ").append_uint(get_auto_mode());
   if (flags & TSSF_HEAT_SETPOINT)
-    result += " HeatSetpoint: " + std::to_string(get_heat_setpoint());
+    out.append(" HeatSetpoint: ").append_float(get_heat_setpoint());
   if (flags & TSSF_COOL_SETPOINT)
-    result += " CoolSetpoint: " + std::to_string(get_cool_setpoint());
+    out.append(" CoolSetpoint: ").append_float(get_cool_setpoint());
+}
+
+// ThermostatSensorStatusPacket functions
+ThermostatSensorStatusPacket &ThermostatSensorStatusPacket::set_indoor_humidity_percent(uint8_t humidity_percent) {
+  pkt_.set_payload_byte(5, humidity_percent);
+  return *this;
+}
 
-  return result;
+ThermostatSensorStatusPacket &ThermostatSensorStatusPacket::set_thermostat_battery_state(
+    ThermostatBatteryState battery_state) {
+  pkt_.set_payload_byte(6, battery_state);
+  return *this;
+}
+
+ThermostatSensorStatusPacket &ThermostatSensorStatusPacket::set_sensor_flags(uint8_t sensor_flags) {
+  pkt_.set_payload_byte(7, sensor_flags);
+  return *this;
 }
 
+// ThermostatHelloPacket functions
 std::string ThermostatHelloPacket::get_thermostat_model() const {
-  return ITPUtils::decode_n_bit_string((pkt_.get_payload_bytes(1)), 4, 6);
+  char buf[MODEL_BUFFER_SIZE];
+  return std::string(buf, get_thermostat_model(buf));
 }
 
 std::string ThermostatHelloPacket::get_thermostat_serial() const {
-  return ITPUtils::decode_n_bit_string((pkt_.get_payload_bytes(4)), 12, 6);
+  char buf[SERIAL_BUFFER_SIZE];
+  return std::string(buf, get_thermostat_serial(buf));
+}
+
+size_t ThermostatHelloPacket::get_thermostat_model(char buffer[MODEL_BUFFER_SIZE]) const {
+  return ITPUtils::decode_6_bit_string(pkt_.get_payload_bytes(1), MODEL_BUFFER_SIZE - 1, buffer);
+}
+
+size_t ThermostatHelloPacket::get_thermostat_serial(char buffer[SERIAL_BUFFER_SIZE]) const {
+  return ITPUtils::decode_6_bit_string(pkt_.get_payload_bytes(4), SERIAL_BUFFER_SIZE - 1, buffer);
+}
+
+// Encodes str into the packet as a 6-bit string of exactly length characters, padding it with spaces
+static void set_6_bit_string(RawPacket &pkt, uint8_t payload_index, const char *str, size_t length) {
+  char padded[16];
+  size_t given = strnlen(str, length);
+  memcpy(padded, str, given);
+  memset(padded + given, ' ', length - given);
+
+  uint8_t encoded[12];
+  pkt.set_payload_bytes(payload_index, encoded, ITPUtils::encode_6_bit_string(padded, length, encoded));
+}
+
+ThermostatHelloPacket &ThermostatHelloPacket::set_thermostat_model(const char *model) {
+  set_6_bit_string(pkt_, 1, model, MODEL_BUFFER_SIZE - 1);
+  return *this;
+}
+
+ThermostatHelloPacket &ThermostatHelloPacket::set_thermostat_serial(const char *serial) {
+  set_6_bit_string(pkt_, 4, serial, SERIAL_BUFFER_SIZE - 1);
+  return *this;
+}
+
+ThermostatHelloPacket &ThermostatHelloPacket::set_thermostat_version(uint8_t major, uint8_t minor, uint8_t patch) {
+  pkt_.set_payload_byte(13, major);
+  pkt_.set_payload_byte(14, minor);
+  pkt_.set_payload_byte(15, patch);
+  return *this;
 }
 
 std::string ThermostatHelloPacket::get_thermostat_version_string() const {
-  char buf[16];
-  sprintf(buf, "%02d.%02d.%02d", pkt_.get_payload_byte(13), pkt_.get_payload_byte(14), pkt_.get_payload_byte(15));
+  char buf[VERSION_STRING_BUFFER_SIZE];
+  size_t length = get_thermostat_version_string(buf);
+
+  return std::string(buf, length);
+}
 
-  return buf;
+size_t ThermostatHelloPacket::get_thermostat_version_string(char buffer[VERSION_STRING_BUFFER_SIZE]) const {
+  return sprintf(buffer, "%02d.%02d.%02d", pkt_.get_payload_byte(13), pkt_.get_payload_byte(14),
+                 pkt_.get_payload_byte(15));
 }
 
 // ThermostatStateUploadPacket functions
@@ -86,6 +157,55 @@ float ThermostatStateUploadPacket::get_cool_setpoint() const {
   return ITPUtils::temp_scale_a_to_deg_c(enhanced_raw_temp);
 }
 
+int16_t ThermostatStateUploadPacket::get_heat_setpoint_deci_c() const {
+  return ITPUtils::temp_scale_a_to_deci_c(pkt_.get_payload_byte(PLINDEX_HEAT_SETPOINT));
+}
+
+int16_t ThermostatStateUploadPacket::get_cool_setpoint_deci_c() const {
+  return ITPUtils::temp_scale_a_to_deci_c(pkt_.get_payload_byte(PLINDEX_COOL_SETPOINT));
+}
+
+ThermostatStateUploadPacket &ThermostatStateUploadPacket::set_thermostat_timestamp(const struct tm &timestamp) {
+  uint32_t raw_timestamp = (uint32_t) (timestamp.tm_year - 2017) << 26 | (timestamp.tm_mon & 15) << 22 |
+                           (timestamp.tm_mday & 31) << 17 | (timestamp.tm_hour & 31) << 12 |
+                           (timestamp.tm_min & 63) << 6 | (timestamp.tm_sec & 63);
+  raw_timestamp = ITPUtils::to_big_endian(raw_timestamp);
+
+  pkt_.set_payload_bytes(PLINDEX_THERMOSTAT_TIMESTAMP, &raw_timestamp, 4);
+  add_flag(TSSF_TIMESTAMP);
+  return *this;
+}
+
+ThermostatStateUploadPacket &ThermostatStateUploadPacket::set_auto_mode(uint8_t auto_mode) {
+  pkt_.set_payload_byte(PLINDEX_AUTO_MODE, auto_mode);
+  add_flag(TSSF_AUTO_MODE);
+  return *this;
+}
+
+ThermostatStateUploadPacket &ThermostatStateUploadPacket::set_heat_setpoint(float temperature_degrees_c) {
+  pkt_.set_payload_byte(PLINDEX_HEAT_SETPOINT, ITPUtils::deg_c_to_temp_scale_a(temperature_degrees_c));
+  add_flag(TSSF_HEAT_SETPOINT);
+  return *this;
+}
+
+ThermostatStateUploadPacket &ThermostatStateUploadPacket::set_cool_setpoint(float temperature_degrees_c) {
+  pkt_.set_payload_byte(PLINDEX_COOL_SETPOINT, ITPUtils::deg_c_to_temp_scale_a(temperature_degrees_c));
+  add_flag(TSSF_COOL_SETPOINT);
+  return *this;
+}
+
+ThermostatStateUploadPacket &ThermostatStateUploadPacket::set_heat_setpoint_deci_c(int16_t temperature_deci_c) {
+  pkt_.set_payload_byte(PLINDEX_HEAT_SETPOINT, ITPUtils::deci_c_to_temp_scale_a(temperature_deci_c));
+  add_flag(TSSF_HEAT_SETPOINT);
+  return *this;
+}
+
+ThermostatStateUploadPacket &ThermostatStateUploadPacket::set_cool_setpoint_deci_c(int16_t temperature_deci_c) {
+  pkt_.set_payload_byte(PLINDEX_COOL_SETPOINT, ITPUtils::deci_c_to_temp_scale_a(temperature_deci_c));
+  add_flag(TSSF_COOL_SETPOINT);
+  return *this;
+}
+
 // ThermostatStateDownloadResponsePacket functions
 ThermostatStateDownloadResponsePacket &ThermostatStateDownloadResponsePacket::set_timestamp(time_t ts) {
   // int32_t encoded_timestamp = ((ts.year - 2017) << 26) | (ts.month << 22) | (ts.day_of_month << 17) | (ts.hour << 12)
@@ -119,4 +239,46 @@ ThermostatStateDownloadResponsePacket &ThermostatStateDownloadResponsePacket::se
   pkt_.set_payload_byte(PLINDEX_COOL_SETPOINT, temp_a);
   return *this;
 }
+
+ThermostatStateDownloadResponsePacket &ThermostatStateDownloadResponsePacket::set_heat_setpoint_deci_c(
+    int16_t high_temp) {
+  uint8_t temp_a = high_temp != ITPUtils::DECI_C_UNAVAILABLE ? ITPUtils::deci_c_to_temp_scale_a(high_temp) : 0x00;
+
+  pkt_.set_payload_byte(PLINDEX_HEAT_SETPOINT, temp_a);
+  return *this;
+}
+
+ThermostatStateDownloadResponsePacket &ThermostatStateDownloadResponsePacket::set_cool_setpoint_deci_c(
+    int16_t low_temp) {
+  uint8_t temp_a = low_temp != ITPUtils::DECI_C_UNAVAILABLE ? ITPUtils::deci_c_to_temp_scale_a(low_temp) : 0x00;
+
+  pkt_.set_payload_byte(PLINDEX_COOL_SETPOINT, temp_a);
+  return *this;
+}
+
+time_t ThermostatStateDownloadResponsePacket::get_timestamp() const {
+  int32_t swapped_timestamp;
+  std::memcpy(&swapped_timestamp, pkt_.get_payload_bytes(PLINDEX_ADAPTER_TIMESTAMP), 4);
+  return (time_t) __builtin_bswap32(swapped_timestamp);
+}
+
+float ThermostatStateDownloadResponsePacket::get_heat_setpoint() const {
+  uint8_t temp_a = pkt_.get_payload_byte(PLINDEX_HEAT_SETPOINT);
+  return temp_a != 0x00 ? ITPUtils::temp_scale_a_to_deg_c(temp_a) : NAN;
+}
+
+float ThermostatStateDownloadResponsePacket::get_cool_setpoint() const {
+  uint8_t temp_a = pkt_.get_payload_byte(PLINDEX_COOL_SETPOINT);
+  return temp_a != 0x00 ? ITPUtils::temp_scale_a_to_deg_c(temp_a) : NAN;
+}
+
+int16_t ThermostatStateDownloadResponsePacket::get_heat_setpoint_deci_c() const {
+  uint8_t temp_a = pkt_.get_payload_byte(PLINDEX_HEAT_SETPOINT);
+  return temp_a != 0x00 ? ITPUtils::temp_scale_a_to_deci_c(temp_a) : ITPUtils::DECI_C_UNAVAILABLE;
+}
+
+int16_t ThermostatStateDownloadResponsePacket::get_cool_setpoint_deci_c() const {
+  uint8_t temp_a = pkt_.get_payload_byte(PLINDEX_COOL_SETPOINT);
+  return temp_a != 0x00 ? ITPUtils::temp_scale_a_to_deci_c(temp_a) : ITPUtils::DECI_C_UNAVAILABLE;
+}
 }  // namespace itp_packet
\ No newline at end of file
@@ -25,7 +25,11 @@ class ThermostatSensorStatusPacket : public Packet {
   }
   uint8_t get_sensor_flags() const { return pkt_.get_payload_byte(7); }
 
-  std::string to_string() const override;
+  ThermostatSensorStatusPacket &set_indoor_humidity_percent(uint8_t humidity_percent);
+  ThermostatSensorStatusPacket &set_thermostat_battery_state(ThermostatBatteryState battery_state);
+  ThermostatSensorStatusPacket &set_sensor_flags(uint8_t sensor_flags);
+
+  void format_to(PacketFormatter &out) const override;
 };
 
 // Sent by MHK2 but with no response; defined to allow setResponseExpected(false)
@@ -40,8 +44,21 @@ class ThermostatHelloPacket : public Packet {
   std::string get_thermostat_model() const;
   std::string get_thermostat_serial() const;
   std::string get_thermostat_version_string() const;
-
-  std::string to_string() const override;
+  // Write the model and serial into buffer without allocating, returning their length
+  static const size_t MODEL_BUFFER_SIZE = 5;
+  static const size_t SERIAL_BUFFER_SIZE = 13;
+  size_t get_thermostat_model(char buffer[MODEL_BUFFER_SIZE]) const;
+  size_t get_thermostat_serial(char buffer[SERIAL_BUFFER_SIZE]) const;
+  // Writes the version string into buffer without allocating, returning its length
+  static const size_t VERSION_STRING_BUFFER_SIZE = 16;
+  size_t get_thermostat_version_string(char buffer[VERSION_STRING_BUFFER_SIZE]) const;
+
+  // Encode the model (up to 4 characters) and serial (up to 12) as 6-bit strings; shorter ones are padded with spaces
+  ThermostatHelloPacket &set_thermostat_model(const char *model);
+  ThermostatHelloPacket &set_thermostat_serial(const char *serial);
+  ThermostatHelloPacket &set_thermostat_version(uint8_t major, uint8_t minor, uint8_t patch);
+
+  void format_to(PacketFormatter &out) const override;
 };
 
 class ThermostatStateUploadPacket : public Packet {
@@ -70,8 +87,18 @@ class ThermostatStateUploadPacket : public Packet {
   uint8_t get_auto_mode() const;
   float get_heat_setpoint() const;
   float get_cool_setpoint() const;
-
-  std::string to_string() const override;
+  int16_t get_heat_setpoint_deci_c() const;
+  int16_t get_cool_setpoint_deci_c() const;
+
+  // Takes the fields as get_thermostat_timestamp() returns them (tm_year is the full year)
+  ThermostatStateUploadPacket &set_thermostat_timestamp(const struct tm &timestamp);
+  ThermostatStateUploadPacket &set_auto_mode(uint8_t auto_mode);
+  ThermostatStateUploadPacket &set_heat_setpoint(float temperature_degrees_c);
+  ThermostatStateUploadPacket &set_cool_setpoint(float temperature_degrees_c);
+  ThermostatStateUploadPacket &set_heat_setpoint_deci_c(int16_t temperature_deci_c);
+  ThermostatStateUploadPacket &set_cool_setpoint_deci_c(int16_t temperature_deci_c);
+
+  void format_to(PacketFormatter &out) const override;
 };
 
 class ThermostatStateDownloadResponsePacket : public Packet {
@@ -91,6 +118,17 @@ class ThermostatStateDownloadResponsePacket : public Packet {
   ThermostatStateDownloadResponsePacket &set_auto_mode(bool is_auto);
   ThermostatStateDownloadResponsePacket &set_heat_setpoint(float high_temp);
   ThermostatStateDownloadResponsePacket &set_cool_setpoint(float low_temp);
+  // As above, in tenths of a degree C; ITPUtils::DECI_C_UNAVAILABLE clears the setpoint
+  ThermostatStateDownloadResponsePacket &set_heat_setpoint_deci_c(int16_t high_temp);
+  ThermostatStateDownloadResponsePacket &set_cool_setpoint_deci_c(int16_t low_temp);
+
+  time_t get_timestamp() const;
+  bool get_auto_mode() const { return pkt_.get_payload_byte(PLINDEX_AUTO_MODE) != 0; }
+  // Return NAN (or ITPUtils::DECI_C_UNAVAILABLE) if the setpoint is cleared
+  float get_heat_setpoint() const;
+  float get_cool_setpoint() const;
+  int16_t get_heat_setpoint_deci_c() const;
+  int16_t get_cool_setpoint_deci_c() const;
 };
 
 class ThermostatAASetRequestPacket : public Packet {
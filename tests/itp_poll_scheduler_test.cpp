@@ -0,0 +1,82 @@
+#include <cstdio>
+#include "itp_packet.h"
+#include "itp_pollscheduler.h"
+
+using namespace itp_packet;
+
+/* Runs a PollScheduler against a simulated unit and checks which commands it polls.  Exits non-zero if any check
+fails.
+*/
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char *what) {
+  if (!condition) {
+    fprintf(stderr, "FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// A response to command whose every field differs from the last one, so the command stays at its fastest rate
+RawPacket changed_response(GetCommand command, uint8_t counter) {
+  RawPacket response(PacketType::GET_RESPONSE, 16);
+  response.set_payload_byte(0, static_cast<uint8_t>(command));
+  for (uint8_t i = 1; i < 16; i++) {
+    response.set_payload_byte(i, counter);
+  }
+  return response;
+}
+
+// Polls for half an hour on a bus budget too small for everything that's due, answering each poll at once with
+// changed data.  Returns how often ERROR_INFO was polled.
+uint32_t count_error_info_polls(uint32_t aging_ms) {
+  PollSchedulerConfig config;
+  config.bus_budget_percent = 5;
+  config.aging_ms = aging_ms;
+  PollScheduler scheduler(config);
+
+  uint32_t error_info_polls = 0;
+  uint8_t counter = 0;
+  for (uint32_t now_ms = 0; now_ms < 30 * 60 * 1000; now_ms += 100) {
+    GetCommand command;
+    while (scheduler.next(now_ms, command)) {
+      error_info_polls += command == GetCommand::ERROR_INFO;
+      scheduler.on_response(command, changed_response(command, ++counter), now_ms);
+    }
+  }
+  return error_info_polls;
+}
+
+// Under a tight budget, busy high-priority commands mustn't starve ERROR_INFO forever
+void check_no_starvation() {
+  uint32_t strict = count_error_info_polls(0);
+  uint32_t aged = count_error_info_polls(PollSchedulerConfig().aging_ms);
+  printf("ERROR_INFO polls in 30 minutes: %u with strict priority, %u with aging\n", strict, aged);
+  check(strict == 0, "strict priority starves ERROR_INFO (the scenario is tight enough)");
+  check(aged >= 30, "aging polls ERROR_INFO about as often as its 30 s minimum interval allows");
+}
+
+// A poll is only completed by its own outcome, and a response for another command doesn't update it
+void check_completion() {
+  PollScheduler scheduler;
+  GetCommand command;
+  check(scheduler.next(0, command) && command == GetCommand::SETTINGS, "settings are polled first");
+  check(!scheduler.on_response(GetCommand::SETTINGS, changed_response(GetCommand::STATUS, 1), 10),
+        "a status response doesn't count as settings data");
+  check(scheduler.get_interval(GetCommand::SETTINGS) == scheduler.get_policy(GetCommand::SETTINGS)->min_interval_ms,
+        "the settings interval is untouched");
+
+  check(scheduler.next(1010, command) && command == GetCommand::SETTINGS,
+        "the poll has ended, and settings are polled again after their minimum interval");
+}
+
+}  // namespace
+
+int main() {
+  check_no_starvation();
+  check_completion();
+  printf("poll scheduler: %d failures\n", failures);
+  return failures == 0 ? 0 : 1;
+}
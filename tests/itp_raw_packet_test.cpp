@@ -0,0 +1,59 @@
+#include <cstdio>
+#include "itp_packet.h"
+
+using namespace itp_packet;
+
+/* Checks that RawPacket's payload writes keep the checksum valid.  Exits non-zero if any check fails.
+*/
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char *what) {
+  if (!condition) {
+    fprintf(stderr, "FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+void check_incremental_checksum() {
+  RawPacket packet(PacketType::SET_REQUEST, 16);
+  for (uint8_t i = 0; i < 16; i++) {
+    packet.set_payload_byte(i, i * 37);
+  }
+  const uint8_t bytes[] = {0x12, 0x34, 0x56};
+  packet.set_payload_bytes(4, bytes, sizeof(bytes));
+  check(packet.is_checksum_valid(), "payload writes keep a built packet's checksum valid");
+}
+
+// Packets built from received bytes with a bad checksum are repaired by their first write, as they always were
+void check_bad_checksum_repaired() {
+  RawPacket good(PacketType::SET_REQUEST, 16);
+  uint8_t bytes[PACKET_MAX_SIZE];
+  for (uint8_t i = 0; i < good.get_length(); i++) {
+    bytes[i] = good.get_bytes()[i];
+  }
+  bytes[good.get_length() - 1] ^= 0x5a;
+
+  RawPacket single(bytes, good.get_length());
+  check(!single.is_checksum_valid(), "the copied frame's checksum is bad");
+  single.set_payload_byte(1, 0x01);
+  check(single.is_checksum_valid(), "set_payload_byte() repairs a bad checksum");
+  single.set_payload_byte(2, 0x02);
+  check(single.is_checksum_valid(), "later writes keep it valid");
+
+  RawPacket multiple(bytes, good.get_length());
+  const uint8_t payload[] = {0x01, 0x02};
+  multiple.set_payload_bytes(1, payload, sizeof(payload));
+  check(multiple.is_checksum_valid(), "set_payload_bytes() repairs a bad checksum");
+}
+
+}  // namespace
+
+int main() {
+  check_incremental_checksum();
+  check_bad_checksum_repaired();
+  printf("raw packet: %d failures\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include <cstdio>
+#include "itp_packet.h"
+#include "itp_redundantsetfilter.h"
+#include "itp_requestengine.h"
+
+using namespace itp_packet;
+
+/* Drives a RequestEngine with a RedundantSetFilter through interleavings of settings GETs and SETs, checking which
+requests reach the wire.  Exits non-zero if any check fails.
+*/
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char *what) {
+  if (!condition) {
+    fprintf(stderr, "FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+RawPacket settings_response(bool power) {
+  RawPacket response(PacketType::GET_RESPONSE, 16);
+  response.set_payload_byte(0, static_cast<uint8_t>(GetCommand::SETTINGS));
+  response.set_payload_byte(SettingsGetResponseView::PLINDEX_POWER, power ? 0x01 : 0x00);
+  return response;
+}
+
+// An accepted SET: the first payload byte is the result code, and 0 means success
+RawPacket set_response() {
+  RawPacket response(PacketType::SET_RESPONSE, 16);
+  response.set_payload_byte(0, 0x00);
+  return response;
+}
+
+struct Link {
+  size_t sent = 0;  // Frames written to the wire
+  RedundantSetFilter filter;
+  RequestEngine engine;
+
+  Link(uint8_t window, bool attach_filter = true)
+      : engine{[this](const RawPacketView &) { sent++; }, {.window = window}} {
+    if (attach_filter)
+      engine.set_set_filter(&filter);
+  }
+
+  void get_settings(uint32_t now_ms) { engine.submit(GetRequestPacket::get_settings_instance(), nullptr, now_ms); }
+  void set_power(bool power, RequestResult *result, uint32_t now_ms) {
+    engine.submit(SettingsSetRequestPacket().set_power(power),
+                  [result](RequestResult r, const RawPacketView &) { *result = r; }, now_ms);
+  }
+  void respond(const RawPacket &response, uint32_t now_ms) { engine.handle_response(RawPacketView(response), now_ms); }
+};
+
+// A GET that was on the wire when a SET went out must not re-learn the setting from its (older) answer
+void check_stale_get_after_set() {
+  Link link(4);
+  RequestResult result = RequestResult::CANCELLED;
+  link.get_settings(0);
+  link.respond(settings_response(true), 1);
+
+  link.get_settings(2);  // Answered below, after the SET, with the power as it was before
+  link.set_power(false, &result, 3);
+  link.respond(set_response(), 4);
+  check(result == RequestResult::RESPONDED, "power off is sent");
+  link.respond(settings_response(true), 5);
+
+  link.set_power(true, &result, 6);
+  check(result != RequestResult::SUPPRESSED, "power on isn't suppressed by a GET sent before power off");
+
+  // The same, with the stale answer arriving while the SET is still outstanding
+  Link link2(4);
+  link2.get_settings(0);
+  link2.respond(settings_response(true), 1);
+  link2.get_settings(2);
+  link2.set_power(false, &result, 3);
+  link2.respond(settings_response(true), 4);
+  link2.respond(set_response(), 5);
+  link2.set_power(true, &result, 6);
+  check(result != RequestResult::SUPPRESSED, "power on isn't suppressed by a GET answered before power off");
+
+  // A GET sent after the SET was answered is trusted again
+  link2.respond(set_response(), 7);
+  link2.get_settings(8);
+  link2.respond(settings_response(true), 9);
+  link2.set_power(true, &result, 10);
+  check(result == RequestResult::SUPPRESSED, "power on is suppressed by a GET sent after the last SET");
+}
+
+// A queued SET is filtered against the state known when it's sent, not when it was submitted
+void check_filter_on_send() {
+  Link link(1);
+  RequestResult result = RequestResult::CANCELLED;
+  link.get_settings(0);
+  link.respond(settings_response(false), 1);
+
+  link.get_settings(2);
+  link.set_power(true, &result, 3);  // Queued behind the GET
+  check(link.sent == 2, "the SET waits for the window");
+  link.respond(settings_response(true), 4);
+  check(result == RequestResult::SUPPRESSED, "the SET is filtered against the response that arrived first");
+  check(link.sent == 2, "the suppressed SET never reaches the wire");
+}
+
+// A GET sent before the filter was attached carries no generation, so its response isn't learned from
+void check_filter_attached_mid_flight() {
+  Link link(4, false);
+  RequestResult result = RequestResult::CANCELLED;
+  link.get_settings(0);
+  link.engine.set_set_filter(&link.filter);
+  link.respond(settings_response(true), 1);
+
+  link.set_power(true, &result, 2);
+  check(link.sent == 2, "power on is sent, since nothing was learned from the GET");
+  link.respond(set_response(), 3);
+  check(result == RequestResult::RESPONDED, "power on is answered");
+
+  link.get_settings(4);
+  link.respond(settings_response(true), 5);
+  link.set_power(true, &result, 6);
+  check(result == RequestResult::SUPPRESSED, "GETs sent once the filter is attached are learned from");
+}
+
+}  // namespace
+
+int main() {
+  check_stale_get_after_set();
+  check_filter_on_send();
+  check_filter_attached_mid_flight();
+  printf("redundant set filter: %d failures\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include <cmath>
+#include <cstdio>
+#include "itp_remotetemperaturefeed.h"
+
+using namespace itp_packet;
+
+/* Feeds a RemoteTemperatureFeed synthetic sensor readings and checks which requests it asks to send.  Exits non-zero
+if any check fails.
+*/
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char *what) {
+  if (!condition) {
+    fprintf(stderr, "FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// A failing sensor (NaN) or an impossible reading must neither be sent nor keep the remote temperature alive
+void check_unusable_readings() {
+  RemoteTemperatureFeed feed;
+  RemoteTemperatureSetRequestPacket request;
+  check(feed.on_reading(21.0f, 0), "a normal reading is accepted");
+  check(feed.poll(0, request) && request.get_flags() == 0x01, "the first reading is sent");
+
+  uint32_t now_ms = 0;
+  bool sent_other = false;
+  for (int i = 0; i < 100; i++) {
+    now_ms += 2000;
+    check(!feed.on_reading(i % 2 ? NAN : 200.0f, now_ms), "unusable readings are rejected");
+    if (feed.poll(now_ms, request) && request.get_flags() != 0x01 && !request.get_use_internal_temperature())
+      sent_other = true;
+  }
+  check(!sent_other, "nothing but the last good temperature or a fallback is sent");
+  check(feed.get_stats().rejected == 100, "rejected readings are counted");
+  check(feed.get_stats().fallbacks == 1 && !feed.is_remote_active(), "the feed falls back once readings go stale");
+}
+
+// Sends while a reading drifts slowly from 20 °C to 25 °C, one reading every ten seconds
+uint32_t count_ramp_sends(RemoteTemperatureEncoding encoding) {
+  RemoteTemperatureFeedConfig config;
+  config.encoding = encoding;
+  config.keepalive_ms = UINT32_MAX;  // Count changes only
+  RemoteTemperatureFeed feed(config);
+  RemoteTemperatureSetRequestPacket request;
+
+  uint32_t sends = 0;
+  for (int step = 0; step <= 500; step++) {
+    uint32_t now_ms = step * 10000;
+    feed.on_reading(20.0f + step * 0.01f, now_ms);
+    sends += feed.poll(now_ms, request);
+  }
+  return sends;
+}
+
+// A slow drift crosses ten boundaries of the unit's encoding (plus the first send), not the twenty of both combined
+void check_drift_ramp() {
+  uint32_t enhanced = count_ramp_sends(RemoteTemperatureEncoding::ENHANCED);
+  uint32_t legacy = count_ramp_sends(RemoteTemperatureEncoding::LEGACY);
+  printf("20-25 °C ramp: %u enhanced sends, %u legacy sends\n", enhanced, legacy);
+  check(enhanced <= 11, "an enhanced ramp sends once per enhanced boundary");
+  check(legacy <= 11, "a legacy ramp sends once per legacy boundary");
+}
+
+// The encoding is learned from settings responses: an enhanced target temperature means an enhanced unit
+void check_learned_encoding() {
+  RemoteTemperatureFeed feed;
+  RawPacket settings(PacketType::GET_RESPONSE, 16);
+  settings.set_payload_byte(0, static_cast<uint8_t>(GetCommand::SETTINGS));
+  check(feed.process_frame(RawPacketView(settings)) && feed.get_encoding() == RemoteTemperatureEncoding::LEGACY,
+        "a settings response without an enhanced target temperature selects the legacy encoding");
+  settings.set_payload_byte(SettingsGetResponseView::PLINDEX_TARGETTEMP, 0xac);
+  check(feed.process_frame(RawPacketView(settings)) && feed.get_encoding() == RemoteTemperatureEncoding::ENHANCED,
+        "a settings response with an enhanced target temperature selects the enhanced encoding");
+}
+
+}  // namespace
+
+int main() {
+  check_unusable_readings();
+  check_drift_ramp();
+  check_learned_encoding();
+  printf("remote temperature feed: %d failures\n", failures);
+  return failures == 0 ? 0 : 1;
+}
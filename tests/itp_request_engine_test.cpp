@@ -0,0 +1,55 @@
+#include <cstdio>
+#include "itp_packet.h"
+#include "itp_requestengine.h"
+
+using namespace itp_packet;
+
+/* Drives a RequestEngine without a link, checking what it writes and which callbacks it calls.  Exits non-zero if
+any check fails.
+*/
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char *what) {
+  if (!condition) {
+    fprintf(stderr, "FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// Requests submitted from cancel_all()'s callbacks survive it, and only go out on the next loop()
+void check_submit_during_cancel() {
+  size_t sent = 0;
+  RequestEngine engine([&sent](const RawPacketView &) { sent++; });
+  size_t cancelled = 0, resubmitted = 0;
+  for (int i = 0; i < 4; i++) {
+    engine.submit(
+        GetRequestPacket::get_status_instance(),
+        [&](RequestResult result, const RawPacketView &) {
+          if (result != RequestResult::CANCELLED)
+            return;
+          cancelled++;
+          resubmitted += engine.submit(GetRequestPacket::get_settings_instance(), nullptr, 0);
+        },
+        0);
+  }
+  check(sent == 4, "the window is filled");
+
+  engine.cancel_all();
+  check(cancelled == 4 && resubmitted == 4, "every request is cancelled once, and every resubmission is accepted");
+  check(engine.get_pending() == 4 && engine.get_in_flight() == 0, "resubmitted requests are queued, not cancelled");
+  check(sent == 4, "nothing is sent from inside cancel_all()");
+
+  engine.loop(1);
+  check(sent == 8 && engine.get_in_flight() == 4, "the next loop() sends them");
+}
+
+}  // namespace
+
+int main() {
+  check_submit_during_cancel();
+  printf("request engine: %d failures\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "itp_utils.h"
+#include "reference_6_bit_decoder.h"
+
+using namespace itp_packet;
+
+/* Exhaustive equivalence checks for ITPUtils' fast paths against the implementations they replace: the fixed-point
+temperature converters against the float ones, and the four-at-a-time 6-bit decoder against the per-character
+reference.  Exits non-zero if any disagree.
+*/
+
+namespace {
+
+// Checks that the fixed-point temperature converters agree exactly with the float ones, for every byte and every
+// temperature (in tenths) either side of the encodable range.  Returns the number of mismatches.
+int verify_deci_c_converters() {
+  int mismatches = 0;
+  auto check = [&mismatches](const char *name, int input, bool same) {
+    if (!same && mismatches++ < 10)
+      fprintf(stderr, "%s disagrees with the float converter for %d\n", name, input);
+  };
+  auto same_float = [](int16_t deci_c, float deg_c) {
+    float converted = deci_c / 10.0f;
+    return memcmp(&converted, &deg_c, sizeof(float)) == 0;
+  };
+
+  for (int b = 0; b < 256; b++) {
+    check("temp_scale_a_to_deci_c", b,
+          same_float(ITPUtils::temp_scale_a_to_deci_c(b), ITPUtils::temp_scale_a_to_deg_c(b)));
+    check("legacy_target_temp_to_deci_c", b,
+          same_float(ITPUtils::legacy_target_temp_to_deci_c(b), ITPUtils::legacy_target_temp_to_deg_c(b)));
+    check("legacy_hp_room_temp_to_deci_c", b,
+          same_float(ITPUtils::legacy_hp_room_temp_to_deci_c(b), ITPUtils::legacy_hp_room_temp_to_deg_c(b)));
+    check("legacy_ts_room_temp_to_deci_c", b,
+          same_float(ITPUtils::legacy_ts_room_temp_to_deci_c(b), ITPUtils::legacy_ts_room_temp_to_deg_c(b)));
+  }
+
+  for (int d = -1000; d <= 1000; d++) {
+    float deg_c = d / 10.0f;
+    check("deci_c_to_temp_scale_a", d, ITPUtils::deci_c_to_temp_scale_a(d) == ITPUtils::deg_c_to_temp_scale_a(deg_c));
+    check("deci_c_to_legacy_target_temp", d,
+          ITPUtils::deci_c_to_legacy_target_temp(d) == ITPUtils::deg_c_to_legacy_target_temp(deg_c));
+    check("deci_c_to_legacy_hp_room_temp", d,
+          ITPUtils::deci_c_to_legacy_hp_room_temp(d) == ITPUtils::deg_c_to_legacy_hp_room_temp(deg_c));
+    check("deci_c_to_legacy_ts_room_temp", d,
+          ITPUtils::deci_c_to_legacy_ts_room_temp(d) == ITPUtils::deg_c_to_legacy_ts_room_temp(deg_c));
+  }
+
+  return mismatches;
+}
+
+// Checks decode_6_bit_string against the reference for every possible 3-byte group at every length it can hold, and
+// for full-length serials.  Returns the number of mismatches.
+int verify_6_bit_decoder() {
+  int mismatches = 0;
+  char expected[16], actual[16];
+  uint8_t data[9] = {};
+
+  for (uint32_t group = 0; group < (1u << 24); group++) {
+    data[0] = group >> 16;
+    data[1] = group >> 8;
+    data[2] = group;
+    for (size_t length = 1; length <= 4; length++) {
+      reference_decode_6_bit_string(data, length, expected);
+      ITPUtils::decode_6_bit_string(data, length, actual);
+      if (memcmp(expected, actual, length) != 0 || actual[length] != '\0') {
+        if (mismatches++ < 10)
+          fprintf(stderr, "decode_6_bit_string disagrees for %06x (length %zu)\n", group, length);
+      }
+    }
+  }
+
+  uint32_t seed = 1;
+  for (int i = 0; i < 100000; i++) {
+    for (uint8_t &b : data) {
+      seed = seed * 1664525 + 1013904223;
+      b = seed >> 24;
+    }
+    reference_decode_6_bit_string(data, 12, expected);
+    ITPUtils::decode_6_bit_string(data, 12, actual);
+    if (memcmp(expected, actual, 12) != 0 || ITPUtils::decode_n_bit_string(data, 12) != std::string(expected, 12))
+      mismatches++;
+  }
+
+  return mismatches;
+}
+
+}  // namespace
+
+int main() {
+  int deci_c_mismatches = verify_deci_c_converters();
+  int decoder_mismatches = verify_6_bit_decoder();
+  printf("deci_c converters: %d mismatches, 6-bit decoder: %d mismatches\n", deci_c_mismatches, decoder_mismatches);
+  return deci_c_mismatches == 0 && decoder_mismatches == 0 ? 0 : 1;
+}
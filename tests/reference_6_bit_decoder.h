@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstring>
+#include <stddef.h>
+#include <stdint.h>
+
+// The original per-character decoder (a bit_slice of each 6-bit word), kept as the reference that
+// ITPUtils::decode_6_bit_string is checked and benchmarked against
+inline void reference_decode_6_bit_string(const uint8_t data[], size_t length, char buffer[]) {
+  for (size_t i = 0; i < length; i++) {
+    size_t start = i * 6, end = start + 5;
+    uint64_t bits = 0;
+    std::memcpy(&bits, &data[start / 8], end / 8 + 1 - start / 8);
+    bits = __builtin_bswap64(bits);
+    bits >>= 64 + (start / 8) * 8 - end - 1;
+    bits &= (1 << 6) - 1;
+    buffer[i] = (char) (bits <= 0x1F ? bits + 0x40 : bits);
+  }
+}
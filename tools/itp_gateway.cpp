@@ -0,0 +1,120 @@
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+#include "itp_gateway.h"
+
+using namespace itp_packet;
+
+/* Polls every unit on the given devices from one process until interrupted, then prints each link's state and
+traffic.
+
+Usage: itp_gateway [options] <device>...
+
+Options:
+  --baud=<n>            Line speed (default 2400)
+  --budget-percent=<n>  Share of each link polling may use (default 50)
+  --window=<n>          Requests in flight per link (default 4)
+  --report-s=<n>        Also print a one-line summary every n seconds (default 0, never)
+*/
+
+namespace {
+
+std::atomic<bool> stop{false};
+
+void on_signal(int) { stop = true; }
+
+void print_summary(const Gateway &gateway) {
+  size_t online = 0;
+  uint64_t frames = 0;
+  uint32_t timeouts = 0;
+  for (size_t i = 0; i < gateway.get_link_count(); i++) {
+    const GatewayLink &link = gateway.get_link(i);
+    online += link.get_state() == GatewayLinkState::ONLINE;
+    frames += link.get_stats().frames_received;
+    timeouts += link.get_engine_stats().timeouts;
+  }
+  fprintf(stderr, "%zu/%zu links online, %llu frames received, %u requests timed out\n", online,
+          gateway.get_link_count(), (unsigned long long) frames, timeouts);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  GatewayConfig config;
+  int report_s = 0;
+  int first_device = argc;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (strncmp(arg, "--baud=", 7) == 0) {
+      config.poll.baud_rate = atoi(arg + 7);
+    } else if (strncmp(arg, "--budget-percent=", 17) == 0) {
+      config.poll.bus_budget_percent = atoi(arg + 17);
+    } else if (strncmp(arg, "--window=", 9) == 0) {
+      config.engine.window = atoi(arg + 9);
+    } else if (strncmp(arg, "--report-s=", 11) == 0) {
+      report_s = atoi(arg + 11);
+    } else if (strncmp(arg, "--", 2) == 0) {
+      fprintf(stderr, "Unknown option %s\n", arg);
+      return 2;
+    } else {
+      first_device = i;
+      break;
+    }
+  }
+  if (first_device == argc) {
+    fprintf(stderr, "Usage: %s [options] <device>...\n", argv[0]);
+    return 2;
+  }
+
+  // One descriptor per link
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+
+  Gateway gateway(config);
+  if (!gateway.open()) {
+    fprintf(stderr, "Unable to create the event loop: %s\n", strerror(errno));
+    return 1;
+  }
+  for (int i = first_device; i < argc; i++) {
+    if (gateway.add_link(argv[i]) < 0) {
+      fprintf(stderr, "Unable to open %s: %s\n", argv[i], strerror(errno));
+      return 1;
+    }
+  }
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  uint32_t next_report_ms = report_s * 1000;
+  while (!stop.load(std::memory_order_relaxed)) {
+    if (gateway.run_once(100) < 0) {
+      fprintf(stderr, "Event loop failed: %s\n", strerror(errno));
+      return 1;
+    }
+    if (report_s > 0 && static_cast<int32_t>(gateway.now_ms() - next_report_ms) >= 0) {
+      print_summary(gateway);
+      next_report_ms += report_s * 1000;
+    }
+  }
+
+  for (size_t i = 0; i < gateway.get_link_count(); i++) {
+    const GatewayLink &link = gateway.get_link(i);
+    const GatewayLinkStats &stats = link.get_stats();
+    const RequestEngineStats &engine = link.get_engine_stats();
+    TransactionStats transactions = link.get_tracker().get_stats();
+    fprintf(stderr, "%s: %s, %u frames, %u connects, %u reconnects, %u reopens, ", link.get_name(),
+            gateway_link_state_name(link.get_state()), stats.frames_received, stats.connects, stats.reconnects,
+            stats.reopens);
+    fprintf(stderr, "%u requests, %u retransmits, %u timeouts, mean round trip %u ms\n", engine.submitted,
+            engine.retransmits, engine.timeouts, transactions.get_rtt_mean_ms());
+  }
+  print_summary(gateway);
+  return 0;
+}
@@ -0,0 +1,125 @@
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+#include "itp_heatpumpemulator.h"
+
+using namespace itp_packet;
+
+/* Runs emulated indoor units on ptys until interrupted, printing one device path per unit.
+
+Options:
+  --units=<n>             Number of units to emulate (default 1)
+  --latency-ms=<n>        Response latency (default 10)
+  --jitter-ms=<n>         Extra random latency, up to n ms (default 0)
+  --drop-rate=<f>         Fraction of requests left unanswered (default 0)
+  --corrupt-rate=<f>      Fraction of responses sent with a bad checksum (default 0)
+  --set-failure-rate=<f>  Fraction of set requests refused (default 0)
+  --link-dir=<dir>        Also create dir/unit-<n> symlinks to the devices, for stable gateway configuration
+*/
+
+namespace {
+
+std::atomic<bool> stop{false};
+
+void on_signal(int) { stop = true; }
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  HeatPumpEmulatorConfig config;
+  int units = 1;
+  const char *link_dir = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (strncmp(arg, "--units=", 8) == 0) {
+      units = atoi(arg + 8);
+    } else if (strncmp(arg, "--latency-ms=", 13) == 0) {
+      config.latency_ms = atoi(arg + 13);
+    } else if (strncmp(arg, "--jitter-ms=", 12) == 0) {
+      config.jitter_ms = atoi(arg + 12);
+    } else if (strncmp(arg, "--drop-rate=", 12) == 0) {
+      config.drop_rate = atof(arg + 12);
+    } else if (strncmp(arg, "--corrupt-rate=", 15) == 0) {
+      config.corrupt_rate = atof(arg + 15);
+    } else if (strncmp(arg, "--set-failure-rate=", 19) == 0) {
+      config.set_failure_rate = atof(arg + 19);
+    } else if (strncmp(arg, "--link-dir=", 11) == 0) {
+      link_dir = arg + 11;
+    } else {
+      fprintf(stderr, "Unknown option %s\n", arg);
+      return 2;
+    }
+  }
+  if (units < 1) {
+    fprintf(stderr, "--units must be at least 1\n");
+    return 2;
+  }
+
+  // Each unit holds two descriptors
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+
+  std::vector<std::unique_ptr<HeatPumpEmulator>> emulators;
+  std::vector<HeatPumpEmulator *> pointers;
+  for (int i = 0; i < units; i++) {
+    HeatPumpEmulatorConfig unit_config = config;
+    unit_config.seed = config.seed + i;  // Independent faults per unit
+    emulators.emplace_back(new HeatPumpEmulator(unit_config));
+    if (!emulators.back()->open()) {
+      fprintf(stderr, "Unable to open a pty for unit %d: %s\n", i, strerror(errno));
+      return 1;
+    }
+    pointers.push_back(emulators.back().get());
+
+    if (link_dir != nullptr) {
+      char link_path[PATH_MAX];
+      snprintf(link_path, sizeof(link_path), "%s/unit-%03d", link_dir, i);
+      unlink(link_path);
+      if (symlink(emulators.back()->get_device_path(), link_path) != 0)
+        fprintf(stderr, "Unable to create %s: %s\n", link_path, strerror(errno));
+    }
+    printf("%s\n", emulators.back()->get_device_path());
+  }
+  fflush(stdout);
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  run_heat_pump_emulators(pointers.data(), pointers.size(), stop);
+
+  HeatPumpEmulatorStats total;
+  for (auto &emulator : emulators) {
+    const HeatPumpEmulatorStats &stats = emulator->get_stats();
+    total.requests += stats.requests;
+    total.responses += stats.responses;
+    total.ignored += stats.ignored;
+    total.dropped += stats.dropped;
+    total.corrupted += stats.corrupted;
+    total.sets_applied += stats.sets_applied;
+    total.sets_refused += stats.sets_refused;
+    total.overflows += stats.overflows;
+  }
+  fprintf(stderr, "%d units: %u requests, %u responses (%u corrupted), %u ignored, %u dropped, %u sets applied, ",
+          units, total.requests, total.responses, total.corrupted, total.ignored, total.dropped, total.sets_applied);
+  fprintf(stderr, "%u sets refused, %u overflows\n", total.sets_refused, total.overflows);
+
+  if (link_dir != nullptr) {
+    for (int i = 0; i < units; i++) {
+      char link_path[PATH_MAX];
+      snprintf(link_path, sizeof(link_path), "%s/unit-%03d", link_dir, i);
+      unlink(link_path);
+    }
+  }
+  return 0;
+}
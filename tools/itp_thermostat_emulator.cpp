@@ -0,0 +1,138 @@
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+#include "itp_thermostatemulator.h"
+
+using namespace itp_packet;
+
+/* Runs emulated thermostats on ptys until interrupted, printing one device path per thermostat, then reports each
+exchange's counts and response times.
+
+Options:
+  --units=<n>            Number of thermostats to emulate (default 1)
+  --cycle-ms=<n>         Polling cycle interval (default 3000)
+  --gap-ms=<n>           Pause between exchanges (default 40)
+  --timeout-ms=<n>       Response timeout (default 1000)
+  --no-heat-pump-poll    Leave the settings and current temperature GETs and remote temperature SET out of each cycle
+  --link-dir=<dir>       Also create dir/thermostat-<n> symlinks to the devices, for stable adapter configuration
+*/
+
+namespace {
+
+// Far more than descriptor limits allow, but small enough that every serial is distinct
+const int MAX_UNITS = 100000;
+
+std::atomic<bool> stop{false};
+
+void on_signal(int) { stop = true; }
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ThermostatEmulatorConfig config;
+  int units = 1;
+  const char *link_dir = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (strncmp(arg, "--units=", 8) == 0) {
+      units = atoi(arg + 8);
+    } else if (strncmp(arg, "--cycle-ms=", 11) == 0) {
+      config.cycle_interval_ms = atoi(arg + 11);
+    } else if (strncmp(arg, "--gap-ms=", 9) == 0) {
+      config.request_gap_ms = atoi(arg + 9);
+    } else if (strncmp(arg, "--timeout-ms=", 13) == 0) {
+      config.response_timeout_ms = atoi(arg + 13);
+    } else if (strcmp(arg, "--no-heat-pump-poll") == 0) {
+      config.poll_heat_pump = false;
+    } else if (strncmp(arg, "--link-dir=", 11) == 0) {
+      link_dir = arg + 11;
+    } else {
+      fprintf(stderr, "Unknown option %s\n", arg);
+      return 2;
+    }
+  }
+  if (units < 1 || units > MAX_UNITS) {
+    fprintf(stderr, "--units must be between 1 and %d\n", MAX_UNITS);
+    return 2;
+  }
+
+  // Each thermostat holds two descriptors
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+
+  std::vector<std::unique_ptr<ThermostatEmulator>> emulators;
+  std::vector<ThermostatEmulator *> pointers;
+  for (int i = 0; i < units; i++) {
+    ThermostatEmulatorConfig unit_config = config;
+    // Serials are 12 characters; units is bounded, so the number always fits in nine digits
+    snprintf(unit_config.serial, sizeof(unit_config.serial), "EMU%09u", static_cast<unsigned>(i + 1) % 1000000000u);
+    emulators.emplace_back(new ThermostatEmulator(unit_config));
+    if (!emulators.back()->open()) {
+      fprintf(stderr, "Unable to open a pty for thermostat %d: %s\n", i, strerror(errno));
+      return 1;
+    }
+    pointers.push_back(emulators.back().get());
+
+    if (link_dir != nullptr) {
+      char link_path[PATH_MAX];
+      snprintf(link_path, sizeof(link_path), "%s/thermostat-%03d", link_dir, i);
+      unlink(link_path);
+      if (symlink(emulators.back()->get_device_path(), link_path) != 0)
+        fprintf(stderr, "Unable to create %s: %s\n", link_path, strerror(errno));
+    }
+    printf("%s\n", emulators.back()->get_device_path());
+  }
+  fflush(stdout);
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  run_thermostat_emulators(pointers.data(), pointers.size(), stop);
+
+  uint32_t cycles = 0, reconnects = 0, unexpected = 0;
+  for (auto &emulator : emulators) {
+    cycles += emulator->get_stats().cycles;
+    reconnects += emulator->get_stats().reconnects;
+    unexpected += emulator->get_stats().unexpected;
+  }
+  fprintf(stderr, "%d thermostats: %u cycles, %u reconnects, %u unexpected frames\n", units, cycles, reconnects,
+          unexpected);
+  for (size_t i = 0; i < THERMOSTAT_EXCHANGE_COUNT; i++) {
+    ThermostatExchangeStats total;
+    for (auto &emulator : emulators) {
+      const ThermostatExchangeStats &stats = emulator->get_stats().exchanges[i];
+      total.requests += stats.requests;
+      total.responses += stats.responses;
+      total.timeouts += stats.timeouts;
+      total.mismatched += stats.mismatched;
+      total.refused += stats.refused;
+      total.total_latency_us += stats.total_latency_us;
+      if (stats.max_latency_us > total.max_latency_us)
+        total.max_latency_us = stats.max_latency_us;
+    }
+    fprintf(stderr, "  %-18s %u requests, %u responses, %u timeouts, %u mismatched, %u refused, ",
+            thermostat_exchange_name(static_cast<ThermostatExchange>(i)), total.requests, total.responses,
+            total.timeouts, total.mismatched, total.refused);
+    fprintf(stderr, "mean %u us, max %u us\n", total.get_mean_latency_us(), total.max_latency_us);
+  }
+
+  if (link_dir != nullptr) {
+    for (int i = 0; i < units; i++) {
+      char link_path[PATH_MAX];
+      snprintf(link_path, sizeof(link_path), "%s/thermostat-%03d", link_dir, i);
+      unlink(link_path);
+    }
+  }
+  return 0;
+}